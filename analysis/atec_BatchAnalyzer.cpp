@@ -0,0 +1,547 @@
+namespace atec
+{
+BatchAnalyzer::Worker::Worker(BatchAnalyzer& analyzer) : juce::Thread("BatchAnalyzer worker"), mAnalyzer(analyzer)
+{
+    mMappedReader = nullptr;
+    mReaderFileIndex = -1;
+}
+
+void BatchAnalyzer::Worker::run()
+{
+    bool finished = false;
+
+    while(!finished && !threadShouldExit())
+    {
+        int slotIndex, chunk;
+
+        switch(mAnalyzer.claimWork(slotIndex, chunk))
+        {
+            case claimedChunk:
+                mAnalyzer.processChunk(*this, slotIndex, chunk);
+                break;
+            case claimedFile:
+                mAnalyzer.openFile(*this, slotIndex);
+                break;
+            case tryAgain:
+                // another worker is still reading a header, and its chunks are all that's left
+                wait(1);
+                break;
+            case allClaimed:
+                finished = true;
+                break;
+        }
+    }
+
+    // close the reader whether the run finished or was stopped. file indices start over with the next start(), so a reader left open here would be taken for a different file
+    mReader.reset();
+    mMappedReader = nullptr;
+    mReaderFileIndex = -1;
+}
+
+BatchAnalyzer::BatchAnalyzer() : mNumFilesDone(0), mAllDone(true)
+{
+    mDebugFlag = false;
+
+    mFormatManager.registerBasicFormats();
+
+    mNextFile = 0;
+    mThreshDb = BATCHDEFAULTTHRESHDB;
+    mAnalysisFlags = zeroCrossingRate | rms | spectrum;
+    mChannel = 0;
+    mNumThreads = 0;
+    mChunkSize = BATCHDEFAULTCHUNKSIZE;
+    mFftSize = BATCHDEFAULTFFTSIZE;
+    mNumBins = (mFftSize / 2) + 1;
+    mHop = BATCHDEFAULTHOP;
+
+    if(mDebugFlag)
+        DBG("BatchAnalyzer constructor called");
+}
+
+BatchAnalyzer::~BatchAnalyzer()
+{
+    stop();
+
+    if(mDebugFlag)
+        DBG("BatchAnalyzer destructor called");
+}
+
+void BatchAnalyzer::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// any combination of the Analysis flags. only change this while stopped
+void BatchAnalyzer::setAnalyses(int analysisFlags)
+{
+    mAnalysisFlags = analysisFlags;
+}
+
+int BatchAnalyzer::getAnalyses()
+{
+    return mAnalysisFlags;
+}
+
+void BatchAnalyzer::setChannel(int channel)
+{
+    mChannel = juce::jmax(0, channel);
+}
+
+// crossings at samples louder than this aren't zero crossing points. same as the threshDb of getZeroCrossingPoints()
+void BatchAnalyzer::setThreshDb(double threshDb)
+{
+    mThreshDb = threshDb;
+}
+
+// fftSize must be a power of 2. allocates a chunk buffer and FFT per thread, which is all the memory the analysis needs besides the results
+void BatchAnalyzer::prepare(int numThreads, int chunkSize, int fftSize, int hop)
+{
+    jassert(juce::isPowerOfTwo(fftSize));
+
+    stop();
+
+    mNumThreads = juce::jmax(1, numThreads);
+    mFftSize = fftSize;
+    mNumBins = (mFftSize / 2) + 1;
+    mHop = juce::jlimit(1, mFftSize, hop);
+    // every chunk has to start on a frame, so the chunk that owns a frame is the one it starts in
+    mChunkSize = ((juce::jmax(chunkSize, mHop) + mHop - 1) / mHop) * mHop;
+
+    // periodic Hann, from one extra point
+    mWindow.allocate((size_t)mFftSize + 1, true);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(mWindow.get(), (size_t)mFftSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
+
+    mWorkers.clear();
+    mSlots.clear();
+
+    for(int i = 0; i < mNumThreads; i++)
+    {
+        Worker* worker = mWorkers.add(new Worker(*this));
+        FileSlot* slot = mSlots.add(new FileSlot());
+
+        // stereo to begin with. files with more channels grow it the first time they're read
+        worker->mChunkBuf.setSize(2, mChunkSize + mFftSize);
+        worker->mFFT.reset(new juce::dsp::FFT((int)std::log2(mFftSize)));
+        worker->mFftBuf.allocate((size_t)mFftSize * 2, true);
+        worker->mMag.allocate((size_t)mNumBins, true);
+        worker->mMagSums.allocate((size_t)mNumBins, true);
+
+        slot->magSums.allocate((size_t)mNumBins, true);
+    }
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "BatchAnalyzer prepare. threads: " + std::to_string(mNumThreads) + ", mChunkSize: " + std::to_string(mChunkSize) + ", mFftSize: " + std::to_string(mFftSize);
+        DBG(post);
+    }
+}
+
+// starts analyzing the files in the background and returns right away. stops any run that's still going first
+void BatchAnalyzer::start(const juce::Array<juce::File>& files)
+{
+    jassert(mWorkers.size() > 0); // call prepare() first
+
+    stop();
+
+    mFiles = files;
+    mResults.clearQuick();
+    mResults.resize(mFiles.size());
+    mFileDone.reset(new std::atomic<bool>[(size_t)mFiles.size()]);
+
+    for(int i = 0; i < mFiles.size(); i++)
+        mFileDone[i].store(false);
+
+    for(auto* slot : mSlots)
+        slot->state = FileSlot::slotFree;
+
+    mNextFile = 0;
+    mNumFilesDone.store(0);
+    mAllDone.reset();
+
+    if(mFiles.size() == 0)
+        mAllDone.signal();
+
+    for(auto* worker : mWorkers)
+        worker->startThread();
+}
+
+// returns true once every file is done, or false if timeoutMs runs out first (-1 waits forever)
+bool BatchAnalyzer::waitForCompletion(int timeoutMs)
+{
+    return mAllDone.wait(timeoutMs);
+}
+
+// abandons the run. files that weren't finished stay not done
+void BatchAnalyzer::stop()
+{
+    for(auto* worker : mWorkers)
+        worker->signalThreadShouldExit();
+
+    for(auto* worker : mWorkers)
+        worker->stopThread(-1);
+}
+
+bool BatchAnalyzer::isFinished()
+{
+    return mNumFilesDone.load() == mFiles.size();
+}
+
+int BatchAnalyzer::getNumFiles()
+{
+    return mFiles.size();
+}
+
+// for progress reports. files finish roughly in order, but not exactly
+int BatchAnalyzer::getNumFilesDone()
+{
+    return mNumFilesDone.load();
+}
+
+bool BatchAnalyzer::isFileDone(int fileIndex)
+{
+    return mFileDone[fileIndex].load();
+}
+
+// only valid once isFileDone(fileIndex) is true
+const BatchAnalyzer::FileResult& BatchAnalyzer::getResult(int fileIndex)
+{
+    jassert(isFileDone(fileIndex));
+
+    return mResults.getReference(fileIndex);
+}
+
+// basic formats are registered already. register any others before start()
+juce::AudioFormatManager& BatchAnalyzer::getFormatManager()
+{
+    return mFormatManager;
+}
+
+// a chunk from the open file furthest down the list, or else the next file in the list to open
+BatchAnalyzer::ClaimResult BatchAnalyzer::claimWork(int& slotIndex, int& chunk)
+{
+    const juce::ScopedLock sl(mLock);
+    bool opening = false;
+    int oldestFile = mFiles.size();
+
+    slotIndex = -1;
+
+    for(int i = 0; i < mSlots.size(); i++)
+    {
+        FileSlot& slot = *mSlots[i];
+
+        if(slot.state == FileSlot::slotOpening)
+            opening = true;
+        else if(slot.state == FileSlot::slotOpen && slot.nextChunk < slot.numChunks && slot.fileIndex < oldestFile)
+        {
+            oldestFile = slot.fileIndex;
+            slotIndex = i;
+        }
+    }
+
+    if(slotIndex >= 0)
+    {
+        chunk = mSlots[slotIndex]->nextChunk++;
+        return claimedChunk;
+    }
+
+    if(mNextFile < mFiles.size())
+    {
+        for(int i = 0; i < mSlots.size(); i++)
+        {
+            if(mSlots[i]->state == FileSlot::slotFree)
+            {
+                mSlots[i]->state = FileSlot::slotOpening;
+                mSlots[i]->fileIndex = mNextFile++;
+                slotIndex = i;
+
+                return claimedFile;
+            }
+        }
+
+        // can't happen with a slot per worker, but waiting is always safe
+        jassertfalse;
+        return tryAgain;
+    }
+
+    return opening ? tryAgain : allClaimed;
+}
+
+// reads the file's header (outside the lock, since that's file I/O) and opens its chunks to every worker
+void BatchAnalyzer::openFile(Worker& worker, int slotIndex)
+{
+    FileSlot& slot = *mSlots[slotIndex];
+    int fileIndex = slot.fileIndex;
+    FileResult& result = mResults.getReference(fileIndex);
+    bool opened = openReader(worker, fileIndex);
+    bool empty;
+
+    if(opened)
+    {
+        result.memoryMapped = (worker.mMappedReader != nullptr);
+        result.sampleRate = worker.mReader->sampleRate;
+        result.lengthInSamples = worker.mReader->lengthInSamples;
+        result.numChannels = (int)worker.mReader->numChannels;
+    }
+
+    {
+        const juce::ScopedLock sl(mLock);
+
+        slot.lengthInSamples = opened ? result.lengthInSamples : 0;
+        slot.numChunks = (int)((slot.lengthInSamples + mChunkSize - 1) / mChunkSize);
+        slot.nextChunk = 0;
+        slot.chunksDone = 0;
+        slot.failed = !opened;
+
+        if(slot.lengthInSamples >= mFftSize)
+            slot.numFrames = (int)((slot.lengthInSamples - mFftSize) / mHop) + 1;
+        else
+            slot.numFrames = (slot.lengthInSamples > 0) ? 1 : 0;
+
+        slot.signChanges = 0;
+        slot.sumOfSquares = 0.0;
+        slot.sumOfCentroids = 0.0;
+        slot.numCentroids = 0;
+        slot.points.clearQuick();
+        juce::FloatVectorOperations::clear(slot.magSums.get(), mNumBins);
+
+        // an empty or unreadable file has no chunks to wait for
+        empty = (slot.numChunks == 0);
+
+        if(empty)
+            finishFile(slot);
+        else
+            slot.state = FileSlot::slotOpen;
+    }
+
+    if(empty)
+        publishFile(fileIndex);
+
+    if(mDebugFlag && !opened)
+    {
+        std::string post;
+        post = "BatchAnalyzer couldn't open " + mFiles[fileIndex].getFullPathName().toStdString();
+        DBG(post);
+    }
+}
+
+// memory mapped if the file's format can do it, otherwise a streaming reader. keeps the worker's reader if it's already for this file
+bool BatchAnalyzer::openReader(Worker& worker, int fileIndex)
+{
+    const juce::File& file = mFiles.getReference(fileIndex);
+    juce::AudioFormat* format;
+
+    if(worker.mReader != nullptr && worker.mReaderFileIndex == fileIndex)
+        return true;
+
+    worker.mReader.reset();
+    worker.mMappedReader = nullptr;
+    worker.mReaderFileIndex = -1;
+
+    format = mFormatManager.findFormatForFileExtension(file.getFileExtension());
+
+    if(format != nullptr)
+        worker.mMappedReader = format->createMemoryMappedReader(file);
+
+    if(worker.mMappedReader != nullptr)
+        worker.mReader.reset(worker.mMappedReader);
+    else
+        worker.mReader.reset(mFormatManager.createReaderFor(file));
+
+    if(worker.mReader == nullptr)
+        return false;
+
+    worker.mReaderFileIndex = fileIndex;
+
+    return true;
+}
+
+// the analysis proper. every crossing and frame belongs to the chunk it starts in, so chunks only need to be summed
+void BatchAnalyzer::processChunk(Worker& worker, int slotIndex, int chunk)
+{
+    FileSlot& slot = *mSlots[slotIndex];
+    int fileIndex = slot.fileIndex;
+    juce::int64 length = slot.lengthInSamples;
+    juce::int64 start = (juce::int64)chunk * mChunkSize;
+    juce::int64 end = juce::jmin(length, start + mChunkSize);
+    // one sample of the last chunk, for the crossing into this one
+    juce::int64 readStart = (start > 0) ? start - 1 : 0;
+    juce::int64 readEnd = end;
+    juce::int64 signChanges = 0;
+    double sumOfSquares = 0.0;
+    double sumOfCentroids = 0.0;
+    int numCentroids = 0;
+    int readSamps, offset, numSamps;
+    bool ok, done;
+
+    // the rest of the last frame that starts in this chunk
+    if((mAnalysisFlags & spectrum) != 0)
+        readEnd = juce::jmin(length, end + mFftSize - mHop);
+
+    readSamps = (int)(readEnd - readStart);
+    offset = (int)(start - readStart);
+    numSamps = (int)(end - start);
+
+    ok = openReader(worker, fileIndex);
+
+    // only map what this chunk reads, so long files never tie up much address space either
+    if(ok && worker.mMappedReader != nullptr)
+        ok = worker.mMappedReader->mapSectionOfFile(juce::Range<juce::int64>(readStart, readEnd));
+
+    if(ok)
+    {
+        worker.mChunkBuf.setSize((int)worker.mReader->numChannels, readSamps, false, false, true);
+        ok = worker.mReader->read(&worker.mChunkBuf, 0, readSamps, readStart, true, true);
+    }
+
+    worker.mPoints.clearQuick();
+
+    if(ok)
+    {
+        const float* samples = worker.mChunkBuf.getReadPointer(juce::jmin(mChannel, worker.mChunkBuf.getNumChannels() - 1));
+
+        // same sign rule as Utilities::getSign(), without the branches
+        if((mAnalysisFlags & zeroCrossingRate) != 0)
+        {
+            int prevSign = (samples[0] > 0.0f) - (samples[0] < 0.0f);
+
+            for(int i = 1; i < offset + numSamps; i++)
+            {
+                int sign = (samples[i] > 0.0f) - (samples[i] < 0.0f);
+
+                signChanges += std::abs(sign - prevSign);
+                prevSign = sign;
+            }
+        }
+
+        if((mAnalysisFlags & zeroCrossingPoints) != 0)
+        {
+            double threshGain = juce::Decibels::decibelsToGain(mThreshDb);
+
+            for(int i = 1; i < offset + numSamps; i++)
+                if(Utilities::getSign(samples[i]) != Utilities::getSign(samples[i-1]) && std::fabs(samples[i-1]) < threshGain)
+                    worker.mPoints.add(readStart + i - 1);
+        }
+
+        if((mAnalysisFlags & rms) != 0)
+            for(int i = offset; i < offset + numSamps; i++)
+                sumOfSquares += (double)samples[i] * samples[i];
+
+        if((mAnalysisFlags & spectrum) != 0)
+        {
+            const juce::dsp::Complex<float>* spectrumPtr = reinterpret_cast<const juce::dsp::Complex<float>*>(worker.mFftBuf.get());
+            const float* mag = worker.mMag.get();
+            double* magSums = worker.mMagSums.get();
+            double binToHz = mResults.getReference(fileIndex).sampleRate / mFftSize;
+
+            juce::FloatVectorOperations::clear(magSums, mNumBins);
+
+            // chunks start on a hop, so this is the first frame starting in the chunk
+            for(int frame = (int)(start / mHop); frame < slot.numFrames && (juce::int64)frame * mHop < end; frame++)
+            {
+                juce::int64 frameStart = (juce::int64)frame * mHop;
+                int frameSamps = (int)juce::jmin((juce::int64)mFftSize, length - frameStart);
+                double sumMag = 0.0;
+                double sumWeighted = 0.0;
+
+                juce::FloatVectorOperations::multiply(worker.mFftBuf.get(), samples + (frameStart - readStart), mWindow.get(), frameSamps);
+                juce::FloatVectorOperations::clear(worker.mFftBuf.get() + frameSamps, (mFftSize * 2) - frameSamps);
+                worker.mFFT->performRealOnlyForwardTransform(worker.mFftBuf.get(), true);
+
+                Utilities::getFftMagSpec(spectrumPtr, worker.mMag.get(), mFftSize);
+
+                for(int k = 0; k < mNumBins; k++)
+                {
+                    magSums[k] += mag[k];
+                    sumMag += mag[k];
+                    sumWeighted += (double)mag[k] * k;
+                }
+
+                if(sumMag > 0.0)
+                {
+                    sumOfCentroids += (sumWeighted / sumMag) * binToHz;
+                    numCentroids++;
+                }
+            }
+        }
+    }
+
+    {
+        const juce::ScopedLock sl(mLock);
+
+        if(ok)
+        {
+            slot.signChanges += signChanges;
+            slot.sumOfSquares += sumOfSquares;
+            slot.sumOfCentroids += sumOfCentroids;
+            slot.numCentroids += numCentroids;
+            slot.points.addArray(worker.mPoints);
+
+            if((mAnalysisFlags & spectrum) != 0)
+                for(int k = 0; k < mNumBins; k++)
+                    slot.magSums[k] += worker.mMagSums[k];
+        }
+        else
+        {
+            slot.failed = true;
+        }
+
+        slot.chunksDone++;
+        done = (slot.chunksDone == slot.numChunks);
+
+        if(done)
+            finishFile(slot);
+    }
+
+    if(done)
+        publishFile(fileIndex);
+}
+
+// turns the slot's sums into the file's results and frees the slot. call with mLock held
+void BatchAnalyzer::finishFile(FileSlot& slot)
+{
+    FileResult& result = mResults.getReference(slot.fileIndex);
+    double length = (double)slot.lengthInSamples;
+
+    result.analyzed = !slot.failed;
+    result.numFrames = 0;
+
+    if(result.analyzed && slot.lengthInSamples > 0)
+    {
+        // getZeroCrossingRate() divides by twice the number of samples, since each crossing is a sign change of 2
+        if((mAnalysisFlags & zeroCrossingRate) != 0)
+            result.zeroCrossingRate = (double)slot.signChanges / (2.0 * length);
+
+        if((mAnalysisFlags & rms) != 0)
+            result.rms = std::sqrt(slot.sumOfSquares / length);
+
+        if((mAnalysisFlags & zeroCrossingPoints) != 0)
+            result.zeroCrossingPoints.swapWith(slot.points);
+
+        if((mAnalysisFlags & spectrum) != 0)
+        {
+            result.numFrames = slot.numFrames;
+            result.averageMagSpec.resize(mNumBins);
+
+            for(int k = 0; k < mNumBins; k++)
+                result.averageMagSpec.set(k, (float)(slot.magSums[k] / slot.numFrames));
+
+            if(slot.numCentroids > 0)
+                result.averageCentroidHz = slot.sumOfCentroids / slot.numCentroids;
+        }
+    }
+
+    slot.points.clearQuick();
+    slot.state = FileSlot::slotFree;
+}
+
+// chunks finish in any order, so the crossing points only get sorted once they're all in
+void BatchAnalyzer::publishFile(int fileIndex)
+{
+    mResults.getReference(fileIndex).zeroCrossingPoints.sort();
+    mFileDone[fileIndex].store(true);
+
+    if(mNumFilesDone.fetch_add(1) + 1 == mFiles.size())
+        mAllDone.signal();
+}
+} // namespace atec
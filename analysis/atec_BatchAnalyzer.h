@@ -0,0 +1,164 @@
+/*
+
+    Offline analysis of whole sets of audio files (sample libraries, corpora), for the same results getZeroCrossingRate(), getZeroCrossingPoints() and getFftMagSpec() would give on each file, without ever loading a whole file into an AudioBuffer.
+
+    Every file is cut into fixed-size chunks, and each chunk is read on its own: through a MemoryMappedAudioFormatReader mapped to just that chunk's section of the file when the format supports it, or through a regular AudioFormatReader when it doesn't (compressed formats). Each worker thread has one chunk buffer and one reader open at a time, so the memory in use depends on the chunk size and the number of threads, never on how long the files are.
+
+    SCHEDULING:
+    - a worker with nothing to do first helps with chunks of files that are already open, oldest file first, and only opens the next file in the list if none are left. a long file is split across every idle worker instead of holding up the one that opened it, and at most one file per worker is open at any time
+    - claiming a chunk takes a lock, but a chunk is tens of thousands of samples, so that's nothing next to reading and analyzing it
+
+    CHUNK BOUNDARIES:
+    - each chunk also reads the sample before it and, for spectra, the rest of the last frame that starts inside it. so every crossing and every FFT frame is counted exactly once, in the chunk where it starts, and merging a file's chunks is just adding up their sums in whatever order they finish
+    - crossing counts are whole numbers, so zeroCrossingRate comes out exactly the same as a whole-file getZeroCrossingRate(). spectra and RMS are double sums, so they can differ from a whole-file run in the last few bits from the order chunks are added in
+
+    NOTE:
+    - analysis is of one channel (setChannel(), clipped to the file's channel count), like the Utilities functions
+    - spectrum frames are Hann windowed, fftSize long and hop apart, and every frame lies completely inside the file. a file shorter than one frame gets one zero padded frame
+    - zero crossing points are the sample before each crossing quieter than the threshold, as in getZeroCrossingPoints(). they're sorted once the file is done, and they're the one result that grows with the file, so they're off by default
+    - set everything up and prepare() before start(). results for a file can be read once isFileDone() says so, and the results for all files after waitForCompletion()
+
+ */
+
+namespace atec
+{
+    // in samples. rounded up to a whole number of hops
+    #define BATCHDEFAULTCHUNKSIZE 65536
+    #define BATCHDEFAULTFFTSIZE 2048
+    #define BATCHDEFAULTHOP 512
+    #define BATCHDEFAULTTHRESHDB -60.0
+
+    class BatchAnalyzer
+    {
+    public:
+        enum Analysis
+        {
+            zeroCrossingRate = 1,
+            zeroCrossingPoints = 2,
+            rms = 4,
+            spectrum = 8,
+            allAnalyses = 15
+        };
+
+        struct FileResult
+        {
+            // false if the file couldn't be opened or read
+            bool analyzed = false;
+            bool memoryMapped = false;
+            double sampleRate = 0.0;
+            juce::int64 lengthInSamples = 0;
+            int numChannels = 0;
+            // same as getZeroCrossingRate() over the whole file
+            double zeroCrossingRate = 0.0;
+            double rms = 0.0;
+            // same as getZeroCrossingPoints() over the whole file, in file sample indices
+            juce::Array<juce::int64> zeroCrossingPoints;
+            // mean magnitude spectrum over all frames, fftSize/2 + 1 bins
+            juce::Array<float> averageMagSpec;
+            // mean of the frames' spectral centroids, skipping silent frames
+            double averageCentroidHz = 0.0;
+            int numFrames = 0;
+        };
+
+        BatchAnalyzer();
+        ~BatchAnalyzer();
+
+        void debug(bool d);
+        void setAnalyses(int analysisFlags);
+        int getAnalyses();
+        void setChannel(int channel);
+        void setThreshDb(double threshDb);
+        void prepare(int numThreads, int chunkSize, int fftSize, int hop);
+        void start(const juce::Array<juce::File>& files);
+        bool waitForCompletion(int timeoutMs);
+        void stop();
+        bool isFinished();
+        int getNumFiles();
+        int getNumFilesDone();
+        bool isFileDone(int fileIndex);
+        const FileResult& getResult(int fileIndex);
+        juce::AudioFormatManager& getFormatManager();
+
+    private:
+        // a file that's open for chunks. there's one per worker, which is always enough: a worker looking for a slot isn't holding a chunk, so at most numThreads-1 slots are still busy
+        struct FileSlot
+        {
+            enum State {slotFree, slotOpening, slotOpen};
+
+            State state = slotFree;
+            int fileIndex = -1;
+            juce::int64 lengthInSamples = 0;
+            int numFrames = 0;
+            int numChunks = 0;
+            int nextChunk = 0;
+            int chunksDone = 0;
+            bool failed = false;
+
+            // the merged sums of all the file's chunks so far
+            juce::int64 signChanges = 0;
+            double sumOfSquares = 0.0;
+            double sumOfCentroids = 0.0;
+            int numCentroids = 0;
+            juce::HeapBlock<double> magSums;
+            juce::Array<juce::int64> points;
+        };
+
+        class Worker : public juce::Thread
+        {
+        public:
+            Worker(BatchAnalyzer& analyzer);
+            void run() override;
+
+            // this worker's own reader, for whichever file it read its last chunk from
+            std::unique_ptr<juce::AudioFormatReader> mReader;
+            juce::MemoryMappedAudioFormatReader* mMappedReader;
+            int mReaderFileIndex;
+
+            juce::AudioBuffer<float> mChunkBuf;
+            std::unique_ptr<juce::dsp::FFT> mFFT;
+            juce::HeapBlock<float> mFftBuf;
+            juce::HeapBlock<float> mMag;
+            // this chunk's sums, before they're merged into the file's
+            juce::HeapBlock<double> mMagSums;
+            juce::Array<juce::int64> mPoints;
+
+        private:
+            BatchAnalyzer& mAnalyzer;
+        };
+
+        enum ClaimResult {claimedChunk, claimedFile, tryAgain, allClaimed};
+
+        ClaimResult claimWork(int& slotIndex, int& chunk);
+        void openFile(Worker& worker, int slotIndex);
+        bool openReader(Worker& worker, int fileIndex);
+        void processChunk(Worker& worker, int slotIndex, int chunk);
+        void finishFile(FileSlot& slot);
+        void publishFile(int fileIndex);
+
+        juce::AudioFormatManager mFormatManager;
+        juce::OwnedArray<Worker> mWorkers;
+        juce::OwnedArray<FileSlot> mSlots;
+        // shared by every worker's FFT
+        juce::HeapBlock<float> mWindow;
+
+        juce::Array<juce::File> mFiles;
+        juce::Array<FileResult> mResults;
+        std::unique_ptr<std::atomic<bool>[]> mFileDone;
+        std::atomic<int> mNumFilesDone;
+        // signaled when the last file is published
+        juce::WaitableEvent mAllDone;
+        // guards the slots and mNextFile
+        juce::CriticalSection mLock;
+        int mNextFile;
+
+        double mThreshDb;
+        int mAnalysisFlags;
+        int mChannel;
+        int mNumThreads;
+        int mChunkSize;
+        int mFftSize;
+        int mNumBins;
+        int mHop;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,226 @@
+namespace atec
+{
+FeatureExtractor::FeatureExtractor()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+
+    mSampleRate = 48000.0;
+    mRolloffPercent = FEATURESDEFAULTROLLOFF;
+    mFftSize = 0;
+    mNumBins = 0;
+    mFeatureFlags = allFeatures;
+    mHasPrevMag = false;
+
+    if(mDebugFlag)
+        DBG("FeatureExtractor constructor called");
+}
+
+FeatureExtractor::~FeatureExtractor()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("FeatureExtractor destructor called");
+}
+
+void FeatureExtractor::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the next prepare() takes the FFT buffer, window and magnitude spectra from arena. pass nullptr to go back to the heap
+void FeatureExtractor::setArena(AudioArena* arena)
+{
+    mArena = arena;
+}
+
+// fftSize must be a power of 2, and match the size of any spectra passed to processFrame(). allocates, so call from prepareToPlay()
+void FeatureExtractor::prepare(int fftSize, double sampleRate)
+{
+    jassert(juce::isPowerOfTwo(fftSize));
+
+    mFftSize = fftSize;
+    mNumBins = (mFftSize / 2) + 1;
+    mSampleRate = sampleRate;
+
+    mFFT.reset(new juce::dsp::FFT((int)std::log2(mFftSize)));
+    mFftBuf.allocate(mArena, (size_t)mFftSize * 2);
+
+    // periodic Hann, from one extra point
+    mWindow.allocate(mArena, (size_t)mFftSize + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(mWindow.get(), (size_t)mFftSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
+
+    mMag.allocate(mArena, (size_t)mNumBins);
+    mPrevMag.allocate(mArena, (size_t)mNumBins);
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "FeatureExtractor prepare. mFftSize: " + std::to_string(mFftSize);
+        DBG(post);
+    }
+}
+
+// call while neither thread is using the extractor
+void FeatureExtractor::init()
+{
+    mHasPrevMag = false;
+    mCurrent = Features();
+
+    for(int i = 0; i < 3; i++)
+        mSnapshots.getSlot(i) = Features();
+}
+
+// any combination of the Feature flags
+void FeatureExtractor::setFeatures(int featureFlags)
+{
+    mFeatureFlags = featureFlags;
+}
+
+int FeatureExtractor::getFeatures()
+{
+    return mFeatureFlags;
+}
+
+// the fraction of the total magnitude that lies below the rolloff frequency
+void FeatureExtractor::setRolloffPercent(float percent)
+{
+    mRolloffPercent = juce::jlimit(0.0f, 1.0f, percent);
+}
+
+// windows and transforms the frame itself. numSamps can be less than the FFT size, and the rest is zero padded
+void FeatureExtractor::processFrame(const float* samples, int numSamps)
+{
+    const juce::dsp::Complex<float>* spectrum = nullptr;
+
+    jassert(mFFT != nullptr); // call prepare() first
+    jassert(numSamps <= mFftSize);
+
+    if((mFeatureFlags & (centroid | flux | rolloff | flatness)) != 0)
+    {
+        juce::FloatVectorOperations::multiply(mFftBuf.get(), samples, mWindow.get(), numSamps);
+        juce::FloatVectorOperations::clear(mFftBuf.get() + numSamps, (mFftSize * 2) - numSamps);
+        mFFT->performRealOnlyForwardTransform(mFftBuf.get(), true);
+
+        spectrum = reinterpret_cast<const juce::dsp::Complex<float>*>(mFftBuf.get());
+    }
+
+    processFrame(samples, numSamps, spectrum);
+}
+
+// for when the caller already has the frame's spectrum (N/2+1 bins). spectrum can be nullptr if no spectral features are on
+void FeatureExtractor::processFrame(const float* samples, int numSamps, const juce::dsp::Complex<float>* spectrum)
+{
+    Features& features = mSnapshots.getWriteBuffer();
+
+    features = Features();
+    features.frameIndex = mCurrent.frameIndex + 1;
+
+    if((mFeatureFlags & (rms | zeroCrossingRate)) != 0)
+        processTimeDomain(samples, numSamps, features);
+
+    if((mFeatureFlags & (centroid | flux | rolloff | flatness)) != 0)
+    {
+        jassert(spectrum != nullptr);
+        processSpectrum(spectrum, features);
+    }
+
+    mCurrent = features;
+    mSnapshots.publish();
+}
+
+// RMS and zero-crossing rate in one pass. a crossing is a change of sign bit between neighboring samples that are both nonzero
+void FeatureExtractor::processTimeDomain(const float* samples, int numSamps, Features& features)
+{
+    const juce::uint32* bits = reinterpret_cast<const juce::uint32*>(samples);
+    float sumOfSquares = samples[0] * samples[0];
+    juce::uint32 crossings = 0;
+
+    jassert(numSamps > 0);
+
+    for(int i = 1; i < numSamps; i++)
+    {
+        sumOfSquares += samples[i] * samples[i];
+        // shifting out the sign bit leaves 0 only for +0.0 and -0.0
+        crossings += ((bits[i] ^ bits[i - 1]) >> 31) & (juce::uint32)((bits[i] << 1) != 0) & (juce::uint32)((bits[i - 1] << 1) != 0);
+    }
+
+    if((mFeatureFlags & rms) != 0)
+        features.rms = std::sqrt(sumOfSquares / (float)numSamps);
+
+    if((mFeatureFlags & zeroCrossingRate) != 0)
+        features.zeroCrossingRate = (float)crossings / (float)juce::jmax(1, numSamps - 1);
+}
+
+// one fused loop over the bins for magnitude, centroid, flux and flatness sums. rolloff then walks the stored magnitudes until it's reached
+void FeatureExtractor::processSpectrum(const juce::dsp::Complex<float>* spectrum, Features& features)
+{
+    const float* binPtr = reinterpret_cast<const float*>(spectrum);
+    const float* prevMag = mPrevMag.get();
+    float* mag = mMag.get();
+    float binToHz = (float)(mSampleRate / mFftSize);
+    float sumMag = 0.0f;
+    float sumWeighted = 0.0f;
+    float sumPower = 0.0f;
+    float sumLogPower = 0.0f;
+    float sumFluxSquares = 0.0f;
+
+    for(int k = 0; k < mNumBins; k++)
+    {
+        float power = binPtr[k*2] * binPtr[k*2] + binPtr[k*2 + 1] * binPtr[k*2 + 1];
+        float diff;
+
+        mag[k] = std::sqrt(power);
+        diff = mag[k] - prevMag[k];
+
+        sumMag += mag[k];
+        sumWeighted += mag[k] * (float)k;
+        sumPower += power;
+        // fastLog2() needs normal floats, so keep silent bins just above 0
+        sumLogPower += Utilities::fastLog2(power + 1e-20f);
+        sumFluxSquares += diff * diff;
+    }
+
+    if((mFeatureFlags & centroid) != 0 && sumMag > 0.0f)
+        features.centroidHz = (sumWeighted / sumMag) * binToHz;
+
+    if((mFeatureFlags & flux) != 0 && mHasPrevMag)
+        features.flux = std::sqrt(sumFluxSquares);
+
+    // geometric mean over arithmetic mean. the geometric mean comes out of the log2 sum as 2^(mean log2)
+    if((mFeatureFlags & flatness) != 0 && sumPower > 0.0f)
+        features.flatness = juce::jlimit(0.0f, 1.0f, Utilities::fastExp2(sumLogPower / (float)mNumBins) / (sumPower / (float)mNumBins));
+
+    if((mFeatureFlags & rolloff) != 0 && sumMag > 0.0f)
+    {
+        float threshold = sumMag * mRolloffPercent;
+        float runningSum = 0.0f;
+        int k = 0;
+
+        while(k < mNumBins - 1 && runningSum + mag[k] < threshold)
+            runningSum += mag[k++];
+
+        features.rolloffHz = (float)k * binToHz;
+    }
+
+    // this frame's magnitudes are next frame's flux reference
+    mMag.swapWith(mPrevMag);
+    mHasPrevMag = true;
+}
+
+// the features from the last processFrame(), for the audio thread
+const FeatureExtractor::Features& FeatureExtractor::getCurrentFeatures()
+{
+    return mCurrent;
+}
+
+// for one reader thread (e.g. the GUI timer). never blocks, and all values come from the same frame. frameIndex tells you whether it's new
+FeatureExtractor::Features FeatureExtractor::getLatestFeatures()
+{
+    mSnapshots.update();
+
+    return mSnapshots.getReadBuffer();
+}
+} // namespace atec
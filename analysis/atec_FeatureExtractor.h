@@ -0,0 +1,91 @@
+/*
+
+    Per-frame audio features (RMS, zero-crossing rate, spectral centroid, flux, rolloff and flatness), all from one spectrum and one pass over the samples.
+
+    Computing these one at a time means a getFftMagSpec() call per feature, plus separate passes for RMS and zero crossings. Here the magnitude spectrum is computed once per frame, in the same loop that sums everything centroid, flux and flatness need. Rolloff is the only feature that needs a second look at the spectrum, and that stops as soon as it reaches the rolloff point. RMS and zero crossings share one pass over the samples. Zero crossings are sign bit changes between nonzero samples, the same rule as ZeroCrossingDetector, so silence reads 0 even when it's full of -0.0.
+
+    Pass in the spectrum you already have (e.g. from an OlaBufferStereo frame you FFT for other processing), or let processFrame() take its own Hann windowed FFT.
+
+    Results go out through a TripleBuffer, so the GUI thread can call getLatestFeatures() at any time without locking and always gets all the features from the same frame.
+
+    NOTE:
+    - features that aren't turned on with setFeatures() read 0. RMS and zero-crossing rate are cheap to leave off, and rolloff saves its second pass. the fused spectral loop runs if any spectral feature is on
+    - flux is the L2 distance between this frame's magnitude spectrum and the last one's, and flatness is measured on the power spectrum (geometric mean/arithmetic mean, 0 to 1)
+    - the spectrum is N/2+1 interleaved complex bins, the layout performRealOnlyForwardTransform() gives with onlyCalculateNonNegativeFrequencies set
+
+ */
+
+#include "../utilities/atec_TripleBuffer.h"
+#include "../buffering/atec_AudioArena.h"
+
+namespace atec
+{
+    #define FEATURESDEFAULTROLLOFF 0.85f
+
+    class FeatureExtractor
+    {
+    public:
+        enum Feature
+        {
+            rms = 1,
+            zeroCrossingRate = 2,
+            centroid = 4,
+            flux = 8,
+            rolloff = 16,
+            flatness = 32,
+            allFeatures = 63
+        };
+
+        struct Features
+        {
+            float rms = 0.0f;
+            // crossings per sample
+            float zeroCrossingRate = 0.0f;
+            float centroidHz = 0.0f;
+            float flux = 0.0f;
+            float rolloffHz = 0.0f;
+            float flatness = 0.0f;
+            // counts up from 0 with every processed frame since init()
+            juce::int64 frameIndex = -1;
+        };
+
+        FeatureExtractor();
+        ~FeatureExtractor();
+
+        void debug(bool d);
+        void setArena(AudioArena* arena);
+        void prepare(int fftSize, double sampleRate);
+        void init();
+        void setFeatures(int featureFlags);
+        int getFeatures();
+        void setRolloffPercent(float percent);
+        void processFrame(const float* samples, int numSamps);
+        void processFrame(const float* samples, int numSamps, const juce::dsp::Complex<float>* spectrum);
+        const Features& getCurrentFeatures();
+        Features getLatestFeatures();
+
+    private:
+        void processTimeDomain(const float* samples, int numSamps, Features& features);
+        void processSpectrum(const juce::dsp::Complex<float>* spectrum, Features& features);
+
+        std::unique_ptr<juce::dsp::FFT> mFFT;
+        ArenaBlock<float> mFftBuf;
+        ArenaBlock<float> mWindow;
+        ArenaBlock<float> mMag;
+        ArenaBlock<float> mPrevMag;
+
+        TripleBuffer<Features> mSnapshots;
+        // the audio thread's copy of the newest features, separate from the TripleBuffer slots
+        Features mCurrent;
+
+        double mSampleRate;
+        float mRolloffPercent;
+        int mFftSize;
+        int mNumBins;
+        int mFeatureFlags;
+        bool mHasPrevMag;
+        // set by setArena(), used by prepare()
+        AudioArena* mArena;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,359 @@
+namespace atec
+{
+OnsetDetector::OnsetDetector() : mFifo(ONSETDEFAULTQUEUESIZE), mNumOverflowed(0)
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+
+    mMethod = spectralFlux;
+    mSampleRate = 48000.0;
+    mMinIntervalMs = ONSETDEFAULTMININTERVALMS;
+    mOffset = ONSETDEFAULTOFFSET;
+    mMultiplier = ONSETDEFAULTMULTIPLIER;
+    mWindowSize = 0;
+    mNumBins = 0;
+
+    init();
+
+    if(mDebugFlag)
+        DBG("OnsetDetector constructor called");
+}
+
+OnsetDetector::~OnsetDetector()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("OnsetDetector destructor called");
+}
+
+void OnsetDetector::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// spectra and frame scratch from arena from the next prepare() on. the onset queue is shared with the reader thread and stays on the heap
+void OnsetDetector::setArena(AudioArena* arena)
+{
+    mArena = arena;
+}
+
+// windowSize is the OlaBufferStereo window size, and must be a power of 2. queueSize is how many onsets can wait for popOnsets(). call from prepareToPlay()
+void OnsetDetector::prepare(int windowSize, double sampleRate, int queueSize)
+{
+    jassert(juce::isPowerOfTwo(windowSize));
+
+    mWindowSize = windowSize;
+    mNumBins = (mWindowSize / 2) + 1;
+    mSampleRate = sampleRate;
+
+    mFFT.reset(new juce::dsp::FFT((int)std::log2(mWindowSize)));
+    mFftBuf.allocate(mArena, (size_t)mWindowSize * 2);
+
+    // periodic Hann, from one extra point
+    mWindow.allocate(mArena, (size_t)mWindowSize + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(mWindow.get(), (size_t)mWindowSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
+
+    mMono.allocate(mArena, (size_t)mWindowSize);
+    mPrevMono.allocate(mArena, (size_t)mWindowSize);
+    mMag.allocate(mArena, (size_t)mNumBins);
+    mPrevMag.allocate(mArena, (size_t)mNumBins);
+    mPrevSpec.allocate(mArena, (size_t)mNumBins * 2);
+    mUnit.allocate(mArena, (size_t)mNumBins * 2);
+    mPrevUnit.allocate(mArena, (size_t)mNumBins * 2);
+
+    // AbstractFifo always keeps one slot empty
+    mFifo.setTotalSize(juce::jmax(1, queueSize) + 1);
+    mQueue.allocate((size_t)mFifo.getTotalSize(), true);
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "OnsetDetector prepare. mWindowSize: " + std::to_string(mWindowSize) + ", queue size: " + std::to_string(mFifo.getTotalSize() - 1);
+        DBG(post);
+    }
+}
+
+// forget all history. only call while nothing is reading the queue
+void OnsetDetector::init()
+{
+    for(int i = 0; i < ONSETHISTORYSIZE; i++)
+        mHistory[i] = 0.0f;
+
+    mHistoryIdx = 0;
+    mHistoryCount = 0;
+    mNovelty = 0.0f;
+    mPrevNovelty = 0.0f;
+    mCandidateThreshold = 0.0f;
+    mFrameStart = 0;
+    mPrevFrameStart = 0;
+    mLastOnset = std::numeric_limits<juce::int64>::min() / 2;
+    mFramesSeen = 0;
+
+    if(mNumBins > 0)
+    {
+        juce::FloatVectorOperations::clear(mPrevMag.get(), mNumBins);
+        juce::FloatVectorOperations::clear(mPrevSpec.get(), mNumBins * 2);
+        juce::FloatVectorOperations::clear(mUnit.get(), mNumBins * 2);
+        juce::FloatVectorOperations::clear(mPrevUnit.get(), mNumBins * 2);
+    }
+
+    mFifo.reset();
+}
+
+// takes effect from the next frame. complexDomain needs two frames of phase history before it reports anything
+void OnsetDetector::setMethod(NoveltyMethod method)
+{
+    mMethod = method;
+}
+
+OnsetDetector::NoveltyMethod OnsetDetector::getMethod()
+{
+    return mMethod;
+}
+
+// a frame's novelty has to be over offset + multiplier * the recent median. the offset keeps noise and near silence from triggering
+void OnsetDetector::setThreshold(float offset, float multiplier)
+{
+    mOffset = juce::jmax(0.0f, offset);
+    mMultiplier = juce::jmax(0.0f, multiplier);
+}
+
+// the shortest time between two onsets. a retrigger any closer than this is ignored
+void OnsetDetector::setMinIntervalMs(double ms)
+{
+    mMinIntervalMs = juce::jmax(0.0, ms);
+}
+
+// audio thread. frameL and frameR are the raw frame, before any windowing. frames must come in order, each later than the last
+void OnsetDetector::processFrame(const float* frameL, const float* frameR, int windowSize, juce::int64 frameStartSample)
+{
+    float* mono = nullptr;
+    float novelty;
+
+    jassert(mFFT != nullptr); // call prepare() first
+
+    // a different framing, or history rebuilt after a framing switch
+    if(windowSize != mWindowSize || (mFramesSeen > 0 && frameStartSample <= mFrameStart))
+        return;
+
+    // the frame that was current is the onset candidate now
+    mMono.swapWith(mPrevMono);
+    mPrevFrameStart = mFrameStart;
+    mFrameStart = frameStartSample;
+    mono = mMono.get();
+
+    juce::FloatVectorOperations::add(mono, frameL, frameR, mWindowSize);
+    juce::FloatVectorOperations::multiply(mono, 0.5f, mWindowSize);
+
+    juce::FloatVectorOperations::multiply(mFftBuf.get(), mono, mWindow.get(), mWindowSize);
+    juce::FloatVectorOperations::clear(mFftBuf.get() + mWindowSize, mWindowSize);
+    mFFT->performRealOnlyForwardTransform(mFftBuf.get(), true);
+
+    novelty = (mMethod == spectralFlux) ? getSpectralFlux() : getComplexDomain();
+    mFramesSeen++;
+
+    // the candidate is a peak if it beat the frames on both sides of it, and its threshold
+    if(mFramesSeen >= 3 && mNovelty > mCandidateThreshold && mNovelty > mPrevNovelty && mNovelty >= novelty)
+    {
+        juce::int64 position = locateOnset();
+
+        if(position - mLastOnset >= (juce::int64)(mMinIntervalMs * 0.001 * mSampleRate))
+        {
+            pushOnset(position, mNovelty / juce::jmax(mCandidateThreshold, 1e-9f));
+            mLastOnset = position;
+        }
+    }
+
+    // the old candidate is history now, and the new frame is judged against everything up to it
+    if(mFramesSeen >= 2)
+    {
+        mHistory[mHistoryIdx] = mNovelty;
+        mHistoryIdx = (mHistoryIdx + 1) % ONSETHISTORYSIZE;
+        mHistoryCount = juce::jmin(mHistoryCount + 1, ONSETHISTORYSIZE);
+    }
+
+    mCandidateThreshold = getThreshold();
+    mPrevNovelty = mNovelty;
+    mNovelty = novelty;
+}
+
+// audio thread. processes the frame in one overlap channel, for when its process flag is up
+void OnsetDetector::processFrame(OlaBufferStereo& olaBuf, int channel)
+{
+    processFrame(olaBuf.getReadPointerL(channel), olaBuf.getReadPointerR(channel), olaBuf.getWindowSize(), olaBuf.getFrameStartSample(channel));
+}
+
+// the novelty of the newest frame
+float OnsetDetector::getCurrentNovelty()
+{
+    return mNovelty;
+}
+
+// reader thread. copies out up to maxOnsets onsets, oldest first, and returns how many
+int OnsetDetector::popOnsets(Onset* onsets, int maxOnsets)
+{
+    int start1, size1, start2, size2;
+
+    mFifo.prepareToRead(maxOnsets, start1, size1, start2, size2);
+
+    for(int i = 0; i < size1; i++)
+        onsets[i] = mQueue[start1 + i];
+
+    for(int i = 0; i < size2; i++)
+        onsets[size1 + i] = mQueue[start2 + i];
+
+    mFifo.finishedRead(size1 + size2);
+
+    return size1 + size2;
+}
+
+juce::int64 OnsetDetector::getNumOverflowed()
+{
+    return mNumOverflowed.load();
+}
+
+void OnsetDetector::resetNumOverflowed()
+{
+    mNumOverflowed.store(0);
+}
+
+// half-wave rectified difference of log compressed magnitudes. magnitudes are scaled so a full scale sine is 1 in its bin, which keeps the compression and the threshold independent of the window size
+float OnsetDetector::getSpectralFlux()
+{
+    const juce::dsp::Complex<float>* spectrum = reinterpret_cast<const juce::dsp::Complex<float>*>(mFftBuf.get());
+    float* mag = mMag.get();
+    const float* prevMag = mPrevMag.get();
+    float scale = ONSETCOMPRESSION * 4.0f / (float)mWindowSize;
+    float flux = 0.0f;
+
+    Utilities::getFftMagSpec(spectrum, mag, mWindowSize);
+
+    for(int k = 0; k < mNumBins; k++)
+    {
+        float rise;
+
+        mag[k] = Utilities::fastLog2(1.0f + mag[k] * scale);
+        rise = mag[k] - prevMag[k];
+        flux += (rise > 0.0f) ? rise : 0.0f;
+    }
+
+    mMag.swapWith(mPrevMag);
+
+    // the first frame has nothing to rise from
+    return (mFramesSeen >= 1) ? flux / (float)mNumBins : 0.0f;
+}
+
+// rectified complex domain: the distance of each bin from last frame's value advanced by last frame's phase increment, for bins that didn't get quieter.
+// with unit phasors u, the target is X[n-1] * u[n-1] * conj(u[n-2]), which is |X[n-1]| at phase 2*phi[n-1] - phi[n-2], without any angles
+float OnsetDetector::getComplexDomain()
+{
+    const float* spec = mFftBuf.get();
+    float* prevSpec = mPrevSpec.get();
+    float* unit = mUnit.get();
+    float* prevUnit = mPrevUnit.get();
+    float* mag = mMag.get();
+    const float* prevMag = mPrevMag.get();
+    float scale = ONSETCOMPRESSION * 4.0f / (float)mWindowSize;
+    float sum = 0.0f;
+
+    for(int k = 0; k < mNumBins; k++)
+    {
+        float re = spec[k*2];
+        float im = spec[k*2 + 1];
+        float pRe = prevSpec[k*2];
+        float pIm = prevSpec[k*2 + 1];
+        float uRe = unit[k*2];
+        float uIm = unit[k*2 + 1];
+        float aRe = uRe * prevUnit[k*2] + uIm * prevUnit[k*2 + 1];
+        float aIm = uIm * prevUnit[k*2] - uRe * prevUnit[k*2 + 1];
+        float dRe = re - (pRe * aRe - pIm * aIm);
+        float dIm = im - (pRe * aIm + pIm * aRe);
+        float magnitude = std::sqrt(re * re + im * im);
+        float norm = 1.0f / (magnitude + 1e-20f);
+
+        sum += (magnitude >= prevMag[k]) ? std::sqrt(dRe * dRe + dIm * dIm) : 0.0f;
+
+        // everything moves back a frame
+        mag[k] = magnitude;
+        prevSpec[k*2] = re;
+        prevSpec[k*2 + 1] = im;
+        prevUnit[k*2] = uRe;
+        prevUnit[k*2 + 1] = uIm;
+        unit[k*2] = re * norm;
+        unit[k*2 + 1] = im * norm;
+    }
+
+    mMag.swapWith(mPrevMag);
+
+    return (mFramesSeen >= 2) ? sum * scale / (float)mNumBins : 0.0f;
+}
+
+// offset + multiplier * median of the recent history
+float OnsetDetector::getThreshold()
+{
+    int middle = mHistoryCount / 2;
+
+    if(mHistoryCount == 0)
+        return mOffset;
+
+    std::copy(mHistory, mHistory + mHistoryCount, mHistoryScratch);
+    std::nth_element(mHistoryScratch, mHistoryScratch + middle, mHistoryScratch + mHistoryCount);
+
+    return mOffset + mMultiplier * mHistoryScratch[middle];
+}
+
+// the biggest jump in short-term energy inside the candidate frame. running sums over two back to back ONSETREFINESIZE windows slide along it once
+juce::int64 OnsetDetector::locateOnset()
+{
+    const float* x = mPrevMono.get();
+    int size = ONSETREFINESIZE;
+    int best = size;
+    float before = 0.0f;
+    float after = 0.0f;
+    float bestRise;
+
+    for(int i = 0; i < size; i++)
+    {
+        before += x[i] * x[i];
+        after += x[i + size] * x[i + size];
+    }
+
+    bestRise = after - before;
+
+    for(int i = size + 1; i <= mWindowSize - size; i++)
+    {
+        float rise;
+
+        before += x[i - 1] * x[i - 1] - x[i - 1 - size] * x[i - 1 - size];
+        after += x[i + size - 1] * x[i + size - 1] - x[i - 1] * x[i - 1];
+        rise = after - before;
+
+        if(rise > bestRise)
+        {
+            bestRise = rise;
+            best = i;
+        }
+    }
+
+    return mPrevFrameStart + best;
+}
+
+void OnsetDetector::pushOnset(juce::int64 sample, float strength)
+{
+    int start1, size1, start2, size2;
+
+    mFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if(size1 + size2 == 0)
+    {
+        mNumOverflowed++;
+        return;
+    }
+
+    mQueue[start1].sample = sample;
+    mQueue[start1].strength = strength;
+    mFifo.finishedWrite(1);
+}
+} // namespace atec
@@ -0,0 +1,127 @@
+/*
+
+    Streaming onset (transient) detection on OlaBufferStereo frames, for beat slicing and transient shaping.
+
+    Every frame gets one novelty value, from one of two detection functions:
+    - spectralFlux: how much the log compressed magnitude spectrum went up since the last frame, summed over the bins. cheap, and good for percussive material
+    - complexDomain: how far each bin landed from where its magnitude and phase advance predicted it would be (only counting bins that got louder). it also catches soft onsets and note changes the magnitudes alone miss
+    Both are straight loops over the bins. complexDomain predicts the phase from unit phasors instead of angles, so it needs no atan2 or sin/cos.
+
+    A frame is an onset if its novelty is a local peak, above an adaptive threshold (offset + multiplier * the median novelty over the last ONSETHISTORYSIZE frames), and far enough from the last onset. That takes one frame of lookahead, so onsets come out a hop late. Each onset is then pinned down to the sample: the transient is somewhere in the peak frame, so the biggest jump in short-term energy across it, from running sums, is the position that gets reported.
+
+    Onsets go out through a lock-free single-reader, single-writer queue, as input sample indices (counted since the OlaBufferStereo's init(), from getFrameStartSample()), so the GUI or a slicing thread can popOnsets() any time.
+
+    COST:
+    - per frame: one real FFT of the window size, a few passes over the window and the bins, a median over ONSETHISTORYSIZE values, and one more pass over the window when there's an onset
+    - none of that depends on the input, and nothing allocates or locks after prepare(). so the budget is easy to work out: a 64 track session costs 64 of those per hop
+
+    NOTE:
+    - pass each frame before OlaBufferStereo::doWindowing(). the detector applies its own Hann window
+    - frames have to match the window size given to prepare(). after a framing switch, frames rebuilt from history start before the last frame that was processed, and they're skipped
+    - when the queue is full, onsets are counted in getNumOverflowed() and dropped
+
+ */
+
+#include "../buffering/atec_AudioArena.h"
+
+namespace atec
+{
+    #define ONSETDEFAULTWINDOWSIZE 1024
+    #define ONSETDEFAULTQUEUESIZE 64
+    #define ONSETHISTORYSIZE 16
+    #define ONSETDEFAULTOFFSET 0.02f
+    #define ONSETDEFAULTMULTIPLIER 1.5f
+    #define ONSETDEFAULTMININTERVALMS 30.0
+    // the gain magnitudes get before spectralFlux's log compression (bigger values favor quiet onsets more). complexDomain is scaled by it too, so the same thresholds suit both
+    #define ONSETCOMPRESSION 100.0f
+    // the short-term energy windows for placing an onset, in samples
+    #define ONSETREFINESIZE 32
+
+    class OlaBufferStereo;
+
+    class OnsetDetector
+    {
+    public:
+        enum NoveltyMethod
+        {
+            spectralFlux,
+            complexDomain
+        };
+
+        struct Onset
+        {
+            // input sample index of the transient
+            juce::int64 sample = 0;
+            // the frame's novelty over its threshold, 1 and up
+            float strength = 0.0f;
+        };
+
+        OnsetDetector();
+        ~OnsetDetector();
+
+        void debug(bool d);
+        void setArena(AudioArena* arena);
+        void prepare(int windowSize, double sampleRate, int queueSize);
+        void init();
+        void setMethod(NoveltyMethod method);
+        NoveltyMethod getMethod();
+        void setThreshold(float offset, float multiplier);
+        void setMinIntervalMs(double ms);
+        void processFrame(const float* frameL, const float* frameR, int windowSize, juce::int64 frameStartSample);
+        void processFrame(OlaBufferStereo& olaBuf, int channel);
+        float getCurrentNovelty();
+        int popOnsets(Onset* onsets, int maxOnsets);
+        juce::int64 getNumOverflowed();
+        void resetNumOverflowed();
+
+    private:
+        float getSpectralFlux();
+        float getComplexDomain();
+        float getThreshold();
+        juce::int64 locateOnset();
+        void pushOnset(juce::int64 sample, float strength);
+
+        std::unique_ptr<juce::dsp::FFT> mFFT;
+        ArenaBlock<float> mFftBuf;
+        ArenaBlock<float> mWindow;
+
+        // the mono frame, and the one before it, which is the onset candidate until this one has been seen
+        ArenaBlock<float> mMono;
+        ArenaBlock<float> mPrevMono;
+        // one per bin
+        ArenaBlock<float> mMag;
+        ArenaBlock<float> mPrevMag;
+        // complex, interleaved like the FFT output. the last spectrum, and the unit phasors of the last two
+        ArenaBlock<float> mPrevSpec;
+        ArenaBlock<float> mUnit;
+        ArenaBlock<float> mPrevUnit;
+
+        float mHistory[ONSETHISTORYSIZE];
+        float mHistoryScratch[ONSETHISTORYSIZE];
+        int mHistoryIdx;
+        int mHistoryCount;
+
+        juce::AbstractFifo mFifo;
+        juce::HeapBlock<Onset> mQueue;
+        // bumped on the audio thread, read and reset on the reader's
+        std::atomic<juce::int64> mNumOverflowed;
+
+        NoveltyMethod mMethod;
+        double mSampleRate;
+        double mMinIntervalMs;
+        float mOffset;
+        float mMultiplier;
+        float mNovelty;
+        float mPrevNovelty;
+        float mCandidateThreshold;
+        juce::int64 mFrameStart;
+        juce::int64 mPrevFrameStart;
+        juce::int64 mLastOnset;
+        int mFramesSeen;
+        int mWindowSize;
+        int mNumBins;
+        // set by setArena(). the queue never comes from it
+        AudioArena* mArena;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,274 @@
+namespace atec
+{
+PitchDetector::PitchDetector()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+    mRingBuf.debug(mDebugFlag);
+
+    mSampleRate = 48000.0;
+    mThreshold = PITCHDEFAULTTHRESHOLD;
+    mMaxBlockSize = 0;
+    mWindowSize = PITCHDEFAULTWINDOWSIZE;
+    mMaxLag = 0;
+    mMinLag = 2;
+    mLagLimit = 0;
+    mFrameSize = 0;
+    mFftSize = 0;
+    mHop = PITCHDEFAULTHOP;
+    mSampsToNextHop = mHop;
+
+    if(mDebugFlag)
+        DBG("PitchDetector constructor called");
+}
+
+PitchDetector::~PitchDetector()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("PitchDetector destructor called");
+}
+
+void PitchDetector::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the ring buffer, mono mixdown and frame buffer come from arena from the next prepare() on. nullptr goes back to the heap
+void PitchDetector::setArena(AudioArena* arena)
+{
+    mArena = arena;
+    mRingBuf.setArena(arena);
+}
+
+// windowSize is how many samples each lag's difference is summed over, and minFreq the lowest pitch that can ever be detected. call from prepareToPlay()
+void PitchDetector::prepare(double sampleRate, int maxBlockSize, int windowSize, double minFreq)
+{
+    jassert(minFreq > 0.0);
+
+    mSampleRate = sampleRate;
+    mMaxBlockSize = maxBlockSize;
+    mWindowSize = windowSize;
+    // one lag past the lowest frequency's period, for the parabolic interpolation around it
+    mMaxLag = (int)std::ceil(mSampleRate / minFreq) + 1;
+    mFrameSize = mWindowSize + mMaxLag;
+    // big enough that the correlation of the window with the frame never wraps around
+    mFftSize = juce::nextPowerOfTwo(mFrameSize);
+
+    // the frame, plus the block written since the hop boundary it ends on. setSize() rounds down to whole blocks, so ask for one more
+    mRingBuf.setSize(1, mFrameSize + (2 * mMaxBlockSize), mMaxBlockSize);
+    AudioArena::setBufferSize(mArena, mMonoBuf, mMonoReservation, 1, mMaxBlockSize);
+    AudioArena::setBufferSize(mArena, mFrameBuf, mFrameReservation, 1, mFrameSize);
+
+    mFFT.reset(new juce::dsp::FFT((int)std::log2(mFftSize)));
+    mFftIn.allocate((size_t)mFftSize, true);
+    mFftOut.allocate((size_t)mFftSize, true);
+    mCorrBuf.allocate((size_t)mFftSize * 2, true);
+    mEnergy.allocate((size_t)mFrameSize + 1, true);
+    mDiff.allocate((size_t)mMaxLag + 1, true);
+
+    setFrequencyRange(minFreq, PITCHDEFAULTMAXFREQ);
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "PitchDetector prepare. mFrameSize: " + std::to_string(mFrameSize) + ", mFftSize: " + std::to_string(mFftSize);
+        DBG(post);
+    }
+}
+
+// clear the input history and the last estimate
+void PitchDetector::init()
+{
+    mRingBuf.init();
+    mSampsToNextHop = mHop;
+    mCurrent = Estimate();
+
+    for(int i = 0; i < 3; i++)
+        mEstimates.getSlot(i) = Estimate();
+}
+
+// all channels are summed, so pass the whole input buffer
+void PitchDetector::process(const juce::AudioBuffer<float>& buffer)
+{
+    int numSamps = buffer.getNumSamples();
+    int hopPos;
+
+    jassert(numSamps <= mMaxBlockSize);
+
+    mMonoBuf.copyFrom(0, 0, buffer, 0, 0, numSamps);
+
+    for(int channel = 1; channel < buffer.getNumChannels(); channel++)
+        mMonoBuf.addFrom(0, 0, buffer, channel, 0, numSamps);
+
+    mRingBuf.write(0, mMonoBuf, 0, numSamps, true);
+
+    // analyze the frame ending at every hop boundary inside this block
+    for(hopPos = mSampsToNextHop; hopPos <= numSamps; hopPos += mHop)
+        analyze(numSamps - hopPos);
+
+    mSampsToNextHop = hopPos - numSamps;
+}
+
+// analyzes the frame that ends delaySamps before the ring buffer's write index
+void PitchDetector::analyze(int delaySamps)
+{
+    Estimate& estimate = mEstimates.getWriteBuffer();
+    const float* frame = mFrameBuf.getReadPointer(0);
+    float* fftIn = reinterpret_cast<float*>(mFftIn.get());
+    const float* fftOut = reinterpret_cast<const float*>(mFftOut.get());
+    float* corr = mCorrBuf.get();
+    double* energy = mEnergy.get();
+    float* diff = mDiff.get();
+    double runningSum = 0.0;
+    int half = mFftSize / 2;
+    int tau;
+
+    mRingBuf.readUnsafe(0, mFrameSize + delaySamps, mFrameBuf, 0, mFrameSize);
+
+    estimate = Estimate();
+    estimate.hopIndex = mCurrent.hopIndex + 1;
+
+    energy[0] = 0.0;
+    for(int j = 0; j < mFrameSize; j++)
+        energy[j + 1] = energy[j] + (double)frame[j] * frame[j];
+
+    if(energy[mWindowSize] <= 0.0)
+    {
+        mCurrent = estimate;
+        mEstimates.publish();
+        return;
+    }
+
+    // the window goes in the real part and the whole frame in the imaginary part, so one complex FFT transforms both
+    for(int j = 0; j < mFrameSize; j++)
+    {
+        fftIn[j*2] = (j < mWindowSize) ? frame[j] : 0.0f;
+        fftIn[j*2 + 1] = frame[j];
+    }
+
+    juce::FloatVectorOperations::clear(fftIn + (mFrameSize * 2), (mFftSize - mFrameSize) * 2);
+    mFFT->perform(mFftIn.get(), mFftOut.get(), false);
+
+    // pull the two spectra back apart with the conjugate symmetry of real signals, and multiply the window's conjugate by the frame's. W[k] = (Z[k] + Z*[N-k])/2 and F[k] = (Z[k] - Z*[N-k])/2i
+    for(int k = 0; k <= half; k++)
+    {
+        int mirror = (mFftSize - k) & (mFftSize - 1);
+        float zRe = fftOut[k*2];
+        float zIm = fftOut[k*2 + 1];
+        float mRe = fftOut[mirror*2];
+        float mIm = -fftOut[mirror*2 + 1];
+        float wRe = 0.5f * (zRe + mRe);
+        float wIm = 0.5f * (zIm + mIm);
+        float fRe = 0.5f * (zIm - mIm);
+        float fIm = -0.5f * (zRe - mRe);
+
+        corr[k*2] = wRe * fRe + wIm * fIm;
+        corr[k*2 + 1] = wRe * fIm - wIm * fRe;
+    }
+
+    // corr[tau] is now the sum of window[j] * frame[j + tau]
+    mFFT->performRealOnlyInverseTransform(corr);
+
+    // difference function, and its cumulative mean normalization in the same pass
+    diff[0] = 1.0f;
+    for(tau = 1; tau <= mMaxLag; tau++)
+    {
+        double d = energy[mWindowSize] + (energy[tau + mWindowSize] - energy[tau]) - 2.0 * corr[tau];
+
+        // rounding can take a near perfect match just under 0
+        d = juce::jmax(0.0, d);
+        runningSum += d;
+        diff[tau] = (runningSum > 0.0) ? (float)(d * tau / runningSum) : 1.0f;
+    }
+
+    // the first dip under the threshold, followed down to its lowest point
+    for(tau = mMinLag; tau < mLagLimit; tau++)
+    {
+        if(diff[tau] < mThreshold)
+        {
+            while(tau + 1 < mLagLimit && diff[tau + 1] < diff[tau])
+                tau++;
+
+            break;
+        }
+    }
+
+    // nothing got under the threshold, so take the lowest point overall
+    if(tau >= mLagLimit)
+    {
+        tau = mMinLag;
+
+        for(int i = mMinLag + 1; i < mLagLimit; i++)
+            if(diff[i] < diff[tau])
+                tau = i;
+    }
+
+    {
+        float prev = diff[tau - 1];
+        float next = diff[tau + 1];
+        float curve = prev - 2.0f * diff[tau] + next;
+        float shift = (curve > 0.0f) ? juce::jlimit(-0.5f, 0.5f, 0.5f * (prev - next) / curve) : 0.0f;
+
+        estimate.frequencyHz = (float)(mSampleRate / (tau + shift));
+        estimate.confidence = juce::jlimit(0.0f, 1.0f, 1.0f - diff[tau]);
+    }
+
+    mCurrent = estimate;
+    mEstimates.publish();
+}
+
+// how often to estimate, in samples. doesn't allocate, so it's safe to change any time
+void PitchDetector::setHop(int hop)
+{
+    mHop = juce::jmax(1, hop);
+    mSampsToNextHop = juce::jmin(mSampsToNextHop, mHop);
+}
+
+int PitchDetector::getHop()
+{
+    return mHop;
+}
+
+// limits the search to this range. minFreq can't go below the one given to prepare()
+void PitchDetector::setFrequencyRange(double minFreq, double maxFreq)
+{
+    jassert(mMaxLag > 0); // call prepare() first
+    jassert(maxFreq > minFreq);
+
+    // the lag search stops one short of mMaxLag, so there's always a neighbor on each side to interpolate with
+    mLagLimit = juce::jlimit(3, mMaxLag, (int)std::ceil(mSampleRate / minFreq) + 1);
+    mMinLag = juce::jlimit(2, mLagLimit - 1, (int)std::floor(mSampleRate / maxFreq));
+}
+
+void PitchDetector::setThreshold(float threshold)
+{
+    mThreshold = juce::jlimit(0.0f, 1.0f, threshold);
+}
+
+int PitchDetector::getFftSize()
+{
+    return mFftSize;
+}
+
+// the frame ends at the newest sample, so an estimate describes audio centered about half this long ago
+int PitchDetector::getLatencySamps()
+{
+    return mFrameSize;
+}
+
+// the estimate from the last analyzed hop, for the audio thread
+const PitchDetector::Estimate& PitchDetector::getCurrentEstimate()
+{
+    return mCurrent;
+}
+
+// for one reader thread (e.g. the GUI timer). never blocks. hopIndex tells you whether it's new
+PitchDetector::Estimate PitchDetector::getLatestEstimate()
+{
+    mEstimates.update();
+
+    return mEstimates.getReadBuffer();
+}
+} // namespace atec
@@ -0,0 +1,101 @@
+/*
+
+    Streaming pitch detection (YIN), for tuners and harmonizers. Feed it every input block with process(), and it estimates a frequency and a confidence every hop samples.
+
+    The input (all channels summed) goes into a RingBuffer, and each hop the newest windowSize + maxLag samples are read back out as the analysis frame. YIN's difference function d(tau) = sum of (x[j] - x[j+tau])^2 over the window is an O(N^2) loop when done directly. Here it's split into two energies and an autocorrelation, d(tau) = e(0) + e(tau) - 2r(tau). The energies come from running sums, and the autocorrelation for every lag at once comes from FFTs. The window and the frame are packed into the real and imaginary parts of a single complex FFT, so each hop costs:
+    - one complex FFT and one real-only inverse FFT, both of fftSize = the next power of 2 >= windowSize + maxLag (2048 with the defaults at 48k)
+    - a handful of straight passes over the frame and the lags
+    That's the same every hop, however noisy or pitched the input is. Several hops can land in one block, so a block costs that much per hop boundary it crosses.
+
+    From the difference function on, it's standard YIN: cumulative mean normalization, the first dip below the threshold (or the lowest point, if nothing dips that far), and parabolic interpolation around it. Confidence is 1 - the normalized difference at the chosen lag, so a clean periodic signal is close to 1 and noise is well under the threshold's complement.
+
+    Results go out through a TripleBuffer, like FeatureExtractor: getCurrentEstimate() on the audio thread, getLatestEstimate() from one other thread (the GUI), without locking.
+
+    NOTE:
+    - minFreq in prepare() sets the longest lag, so it sets the FFT size and the latency (windowSize + maxLag samples). setFrequencyRange() can narrow the range afterward, but not go below it
+    - the frequency is reported even when confidence is low. check the confidence against your own voicing threshold before trusting it
+    - silence reports 0 Hz with 0 confidence
+
+ */
+
+#include "../buffering/atec_RingBuffer.h"
+#include "../utilities/atec_TripleBuffer.h"
+
+namespace atec
+{
+    #define PITCHDEFAULTWINDOWSIZE 1024
+    #define PITCHDEFAULTHOP 256
+    #define PITCHDEFAULTMINFREQ 50.0
+    #define PITCHDEFAULTMAXFREQ 2000.0
+    // the normalized difference a dip has to get under to count. 0.1 to 0.15 is the usual YIN range
+    #define PITCHDEFAULTTHRESHOLD 0.12f
+
+    class PitchDetector
+    {
+    public:
+        struct Estimate
+        {
+            float frequencyHz = 0.0f;
+            // 0 to 1
+            float confidence = 0.0f;
+            // counts up from 0 with every analyzed hop since init()
+            juce::int64 hopIndex = -1;
+        };
+
+        PitchDetector();
+        ~PitchDetector();
+
+        void debug(bool d);
+        void prepare(double sampleRate, int maxBlockSize, int windowSize, double minFreq);
+        void setArena(AudioArena* arena);
+        void init();
+        void process(const juce::AudioBuffer<float>& buffer);
+        void setHop(int hop);
+        int getHop();
+        void setFrequencyRange(double minFreq, double maxFreq);
+        void setThreshold(float threshold);
+        int getFftSize();
+        int getLatencySamps();
+        const Estimate& getCurrentEstimate();
+        Estimate getLatestEstimate();
+
+    private:
+        void analyze(int delaySamps);
+
+        RingBuffer mRingBuf;
+        juce::AudioBuffer<float> mMonoBuf;
+        // the newest windowSize + maxLag samples, oldest first
+        juce::AudioBuffer<float> mFrameBuf;
+
+        std::unique_ptr<juce::dsp::FFT> mFFT;
+        juce::HeapBlock<juce::dsp::Complex<float>> mFftIn;
+        juce::HeapBlock<juce::dsp::Complex<float>> mFftOut;
+        // 2 * fftSize floats: the cross spectrum in, the autocorrelation out
+        juce::HeapBlock<float> mCorrBuf;
+        // running sums of squares over the frame, in double since they're subtracted from each other
+        juce::HeapBlock<double> mEnergy;
+        // the cumulative mean normalized difference, one per lag
+        juce::HeapBlock<float> mDiff;
+
+        TripleBuffer<Estimate> mEstimates;
+        // the audio thread's copy of the newest estimate, separate from the TripleBuffer slots
+        Estimate mCurrent;
+
+        double mSampleRate;
+        float mThreshold;
+        int mMaxBlockSize;
+        int mWindowSize;
+        int mMaxLag;
+        int mMinLag;
+        int mLagLimit;
+        int mFrameSize;
+        int mFftSize;
+        int mHop;
+        int mSampsToNextHop;
+        // set by setArena()
+        AudioArena* mArena;
+        AudioArena::Reservation mMonoReservation;
+        AudioArena::Reservation mFrameReservation;
+        bool mDebugFlag;
+    };
+} // namespace atec
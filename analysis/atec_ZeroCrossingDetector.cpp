@@ -0,0 +1,165 @@
+namespace atec
+{
+ZeroCrossingDetector::ZeroCrossingDetector()
+{
+    mDebugFlag = false;
+
+    mNumChannels = 0;
+    mNumOverflowed = 0;
+
+    setThresholdDb(ZCDEFAULTTHRESHDB);
+
+    if(mDebugFlag)
+        DBG("ZeroCrossingDetector constructor called");
+}
+
+ZeroCrossingDetector::~ZeroCrossingDetector()
+{
+    if(mDebugFlag)
+        DBG("ZeroCrossingDetector destructor called");
+}
+
+void ZeroCrossingDetector::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// allocates the per channel state. call from prepareToPlay()
+void ZeroCrossingDetector::prepare(int numChannels)
+{
+    mNumChannels = numChannels;
+
+    mLastSamples.resize(mNumChannels);
+    mSampleCounts.resize(mNumChannels);
+    mNumCrossings.resize(mNumChannels);
+    mNumSamps.resize(mNumChannels);
+
+    init();
+}
+
+void ZeroCrossingDetector::init()
+{
+    mLastSamples.fill(0.0f);
+    mSampleCounts.fill(0);
+    mNumCrossings.fill(0);
+    mNumSamps.fill(0);
+
+    mNumOverflowed = 0;
+}
+
+void ZeroCrossingDetector::setThresholdDb(double threshDb)
+{
+    mThreshDb = threshDb;
+    mThreshGain = juce::Decibels::decibelsToGain((float)threshDb);
+}
+
+double ZeroCrossingDetector::getThresholdDb()
+{
+    return mThreshDb;
+}
+
+// finds every crossing in the block that's quieter than the threshold and writes its position into positions, up to capacity.
+// returns how many positions were written. pass nullptr and 0 to only update the zero-crossing rate
+int ZeroCrossingDetector::process(int channel, const float* samples, int numSamps, juce::int64* positions, int capacity)
+{
+    juce::int64 startSample = mSampleCounts.getUnchecked(channel);
+    float prevSample = mLastSamples.getUnchecked(channel);
+    juce::uint32 prevBits, bits;
+    int crossings = 0;
+    int found = 0;
+
+    if(numSamps <= 0)
+        return 0;
+
+    std::memcpy(&prevBits, &prevSample, sizeof(prevBits));
+    std::memcpy(&bits, samples, sizeof(bits));
+
+    // the crossing between the last block and this one. there's no previous block at the very start
+    if(startSample > 0)
+        crossings += (int)signFlip(prevBits, bits);
+
+    for(int i = 1; i < numSamps; i++)
+    {
+        juce::uint32 a, b;
+
+        std::memcpy(&a, samples + i - 1, sizeof(a));
+        std::memcpy(&b, samples + i, sizeof(b));
+
+        crossings += (int)signFlip(a, b);
+    }
+
+    // only go looking for positions if there's anything to find
+    if(capacity > 0 && crossings > 0)
+    {
+        for(int i = (startSample > 0) ? 0 : 1; i < numSamps; i++)
+        {
+            float a = (i == 0) ? prevSample : samples[i - 1];
+            juce::uint32 aBits;
+            int slot;
+
+            std::memcpy(&aBits, &a, sizeof(aBits));
+            std::memcpy(&bits, samples + i, sizeof(bits));
+
+            // branch-free compaction. once the buffer is full, the last slot just gets its own value written back
+            slot = juce::jmin(found, capacity - 1);
+            positions[slot] = (found < capacity) ? startSample + i - 1 : positions[slot];
+            found += (int)signFlip(aBits, bits) & (int)(std::fabs(a) < mThreshGain);
+        }
+
+        if(found > capacity)
+        {
+            mNumOverflowed += found - capacity;
+            found = capacity;
+        }
+    }
+
+    mLastSamples.set(channel, samples[numSamps - 1]);
+    mSampleCounts.set(channel, startSample + numSamps);
+    mNumCrossings.set(channel, crossings);
+    mNumSamps.set(channel, numSamps);
+
+    return found;
+}
+
+// 1 if the sign bit flips between two nonzero samples, else 0. XOR of the raw bits has the sign bit set wherever the sign flips,
+// and shifting the sign bit out leaves zero only for +0.0 and -0.0, so silence (which can hold either) never crosses
+juce::uint32 ZeroCrossingDetector::signFlip(juce::uint32 a, juce::uint32 b)
+{
+    return ((a ^ b) >> 31) & (juce::uint32)((a << 1) != 0) & (juce::uint32)((b << 1) != 0);
+}
+
+int ZeroCrossingDetector::process(int channel, const juce::AudioBuffer<float>& buffer, juce::int64* positions, int capacity)
+{
+    return process(channel, buffer.getReadPointer(channel), buffer.getNumSamples(), positions, capacity);
+}
+
+// every crossing in the most recent block, including one between that block and the one before it
+int ZeroCrossingDetector::getNumCrossings(int channel)
+{
+    return mNumCrossings[channel];
+}
+
+// crossings per sample in the most recent block
+double ZeroCrossingDetector::getZeroCrossingRate(int channel)
+{
+    if(mNumSamps[channel] == 0)
+        return 0.0;
+
+    return (double)mNumCrossings[channel] / (double)mNumSamps[channel];
+}
+
+juce::int64 ZeroCrossingDetector::getSampleCount(int channel)
+{
+    return mSampleCounts[channel];
+}
+
+juce::int64 ZeroCrossingDetector::getNumOverflowed()
+{
+    return mNumOverflowed;
+}
+
+void ZeroCrossingDetector::resetNumOverflowed()
+{
+    mNumOverflowed = 0;
+}
+} // namespace atec
@@ -0,0 +1,58 @@
+/*
+
+    Streaming zero-crossing detection and zero-crossing rate, for running on every live input block.
+
+    Compared with Utilities::getZeroCrossingPoints() and getZeroCrossingRate():
+    - the last sample of each block is kept per channel, so crossings that fall between two blocks aren't missed
+    - a crossing is a change in the float sign bit between two nonzero samples, found with XOR and shift instead of two getSign() calls. the inner loop has no branches, so it vectorizes
+    - the dB threshold is converted to gain once, in setThresholdDb(), not once per sample
+    - crossing positions go into a fixed-capacity buffer the caller owns. anything past its capacity is counted in getNumOverflowed() instead of allocating
+
+    Crossing positions are absolute sample counts since init(), of the sample before the crossing (the same sample getZeroCrossingPoints() reports). For a crossing between blocks, that's the last sample of the previous block.
+
+    NOTE:
+    - +0.0 and -0.0 are both zero, with no sign of their own, so digital silence never crosses however its sign bits fall. getSign() agrees on that much
+    - unlike getZeroCrossingPoints(), a step to or from an exact zero isn't a crossing either. a signal that touches zero and goes back doesn't cross, and one that passes through an exact zero sample on its way to the other side doesn't get counted
+    - low-level noise around zero still crosses, and those crossings are usually quiet enough to pass the threshold. gate the input first if that matters
+    - the threshold only applies to the reported positions. getZeroCrossingRate() counts every crossing
+
+ */
+
+namespace atec
+{
+    #define ZCDEFAULTTHRESHDB -60.0
+
+    class ZeroCrossingDetector
+    {
+    public:
+        ZeroCrossingDetector();
+        ~ZeroCrossingDetector();
+
+        void debug(bool d);
+        void prepare(int numChannels);
+        void init();
+        void setThresholdDb(double threshDb);
+        double getThresholdDb();
+        int process(int channel, const float* samples, int numSamps, juce::int64* positions, int capacity);
+        int process(int channel, const juce::AudioBuffer<float>& buffer, juce::int64* positions, int capacity);
+        int getNumCrossings(int channel);
+        double getZeroCrossingRate(int channel);
+        juce::int64 getSampleCount(int channel);
+        juce::int64 getNumOverflowed();
+        void resetNumOverflowed();
+
+    private:
+        juce::Array<float> mLastSamples;
+        juce::Array<juce::int64> mSampleCounts;
+        // every crossing in the most recent block, threshold or not
+        juce::Array<int> mNumCrossings;
+        juce::Array<int> mNumSamps;
+        juce::int64 mNumOverflowed;
+        double mThreshDb;
+        float mThreshGain;
+        int mNumChannels;
+        bool mDebugFlag;
+
+        static juce::uint32 signFlip(juce::uint32 a, juce::uint32 b);
+    };
+} // namespace atec
@@ -22,7 +22,34 @@
 
 #include "atec_core.h"
 
+#if AUDIOARENAUSEMMAP
+ #include <sys/mman.h>
+#endif
+
 #include "lfo/atec_LFO.cpp"
+#include "buffering/atec_AudioArena.cpp"
 #include "buffering/atec_OlaBufferStereo.cpp"
+#include "buffering/atec_OlaWorkerPool.cpp"
+#include "buffering/atec_MultiResAnalyzer.cpp"
 #include "buffering/atec_RingBuffer.cpp"
+#include "buffering/atec_MonotonicDeque.cpp"
+#include "buffering/atec_RunningSum.cpp"
+#include "buffering/atec_SlidingWindowStats.cpp"
+#include "convolution/atec_UniformConvolver.cpp"
+#include "convolution/atec_NonUniformConvolver.cpp"
 #include "utilities/atec_Utilities.cpp"
+#include "utilities/atec_FastRandom.cpp"
+#include "resampling/atec_PolyphaseResampler.cpp"
+#include "spectral/atec_SpectralFilter.cpp"
+#include "spectral/atec_PhaseVocoder.cpp"
+#include "spectral/atec_BandMapper.cpp"
+#include "analysis/atec_ZeroCrossingDetector.cpp"
+#include "analysis/atec_FeatureExtractor.cpp"
+#include "analysis/atec_PitchDetector.cpp"
+#include "analysis/atec_OnsetDetector.cpp"
+#include "analysis/atec_BatchAnalyzer.cpp"
+#include "synthesis/atec_SamplerEngine.cpp"
+#include "synthesis/atec_GranularEngine.cpp"
+#include "effects/atec_DopplerPitchShifter.cpp"
+#include "effects/atec_LookaheadLimiter.cpp"
+#include "modulation/atec_ModulationMatrix.cpp"
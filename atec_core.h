@@ -17,6 +17,30 @@
 #include <juce_dsp/juce_dsp.h>
 
 #include "lfo/atec_LFO.h"
+#include "buffering/atec_AudioArena.h"
 #include "buffering/atec_OlaBufferStereo.h"
+#include "buffering/atec_OlaWorkerPool.h"
+#include "buffering/atec_MultiResAnalyzer.h"
 #include "buffering/atec_RingBuffer.h"
+#include "buffering/atec_MonotonicDeque.h"
+#include "buffering/atec_RunningSum.h"
+#include "buffering/atec_SlidingWindowStats.h"
+#include "convolution/atec_UniformConvolver.h"
+#include "convolution/atec_NonUniformConvolver.h"
 #include "utilities/atec_Utilities.h"
+#include "utilities/atec_TripleBuffer.h"
+#include "utilities/atec_FastRandom.h"
+#include "resampling/atec_PolyphaseResampler.h"
+#include "spectral/atec_SpectralFilter.h"
+#include "spectral/atec_PhaseVocoder.h"
+#include "spectral/atec_BandMapper.h"
+#include "analysis/atec_ZeroCrossingDetector.h"
+#include "analysis/atec_FeatureExtractor.h"
+#include "analysis/atec_PitchDetector.h"
+#include "analysis/atec_OnsetDetector.h"
+#include "analysis/atec_BatchAnalyzer.h"
+#include "synthesis/atec_SamplerEngine.h"
+#include "synthesis/atec_GranularEngine.h"
+#include "effects/atec_DopplerPitchShifter.h"
+#include "effects/atec_LookaheadLimiter.h"
+#include "modulation/atec_ModulationMatrix.h"
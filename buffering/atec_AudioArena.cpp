@@ -0,0 +1,176 @@
+namespace atec
+{
+AudioArena::AudioArena()
+{
+    mDebugFlag = false;
+
+    mBlock = nullptr;
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mCapacity = 0;
+    mUsed = 0;
+    mRequested = 0;
+    mGeneration = 0;
+    mHugePages = false;
+
+    if(mDebugFlag)
+        DBG("AudioArena constructor called");
+}
+
+AudioArena::~AudioArena()
+{
+    // the mapping isn't a smart pointer, so it's handed back here
+    release();
+
+    if(mDebugFlag)
+        DBG("AudioArena destructor called");
+}
+
+void AudioArena::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// replaces the block with a fresh, zeroed one of at least numBytes. call from prepareToPlay(), before preparing any buffers that use it
+void AudioArena::prepare(size_t numBytes, bool useHugePages)
+{
+    release();
+
+    mCapacity = getAlignedSize(numBytes);
+    mHugePages = false;
+
+#if AUDIOARENAUSEMMAP
+    {
+        size_t pageSize = useHugePages ? (size_t)AUDIOARENAHUGEPAGESIZE : (size_t)AUDIOARENAALIGNMENT;
+        // huge pages have to start on a huge page boundary, so map one extra and start at the first boundary in it
+        size_t mappingSize = ((mCapacity + pageSize - 1) / pageSize) * pageSize + (useHugePages ? pageSize : 0);
+        void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if(mapping != MAP_FAILED)
+        {
+            std::uintptr_t base = reinterpret_cast<std::uintptr_t>(mapping);
+
+            base = (base + pageSize - 1) & ~(std::uintptr_t)(pageSize - 1);
+            mMapping = mapping;
+            mMappingSize = mappingSize;
+            mBlock = reinterpret_cast<char*>(base);
+
+#if defined(MADV_HUGEPAGE)
+            if(useHugePages)
+                mHugePages = (madvise(mBlock, ((mCapacity + pageSize - 1) / pageSize) * pageSize, MADV_HUGEPAGE) == 0);
+#endif
+        }
+    }
+#endif
+
+    // no mmap(), or it failed. an aligned heap block does everything but the huge pages
+    if(mBlock == nullptr)
+    {
+        std::uintptr_t base;
+
+        mHeapBlock.allocate(mCapacity + AUDIOARENAALIGNMENT, true);
+        base = reinterpret_cast<std::uintptr_t>(mHeapBlock.get());
+        base = (base + AUDIOARENAALIGNMENT - 1) & ~(std::uintptr_t)(AUDIOARENAALIGNMENT - 1);
+        mBlock = reinterpret_cast<char*>(base);
+    }
+
+    reset();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "AudioArena prepare. mCapacity: " + std::to_string(mCapacity) + ", huge pages: " + std::to_string(mHugePages);
+        DBG(post);
+    }
+}
+
+// start carving from the beginning again. everything carved before is invalid
+void AudioArena::reset()
+{
+    mUsed = 0;
+    mRequested = 0;
+    mGeneration++;
+}
+
+// numBytes, 64 byte aligned, or nullptr if there isn't room
+void* AudioArena::allocateBytes(size_t numBytes)
+{
+    size_t alignedSize = getAlignedSize(numBytes);
+    void* result;
+
+    mRequested += alignedSize;
+
+    if(mBlock == nullptr || mUsed + alignedSize > mCapacity)
+    {
+        if(mDebugFlag)
+            DBG("AudioArena out of room, " + std::to_string(mRequested) + " bytes requested so far");
+
+        return nullptr;
+    }
+
+    result = mBlock + mUsed;
+    mUsed += alignedSize;
+
+    return result;
+}
+
+size_t AudioArena::getCapacity()
+{
+    return mCapacity;
+}
+
+size_t AudioArena::getUsedBytes()
+{
+    return mUsed;
+}
+
+// what everything carved since the last reset() needed, fitting or not. prepare() with this to fit the whole graph
+size_t AudioArena::getRequestedBytes()
+{
+    return mRequested;
+}
+
+// true if the kernel took the huge page hint
+bool AudioArena::isHugePageBacked()
+{
+    return mHugePages;
+}
+
+// rounded up to the next multiple of AUDIOARENAALIGNMENT
+size_t AudioArena::getAlignedSize(size_t numBytes)
+{
+    return (numBytes + AUDIOARENAALIGNMENT - 1) & ~(size_t)(AUDIOARENAALIGNMENT - 1);
+}
+
+// what allocateChannels() carves for this: the pointer array plus every channel, each rounded up to the alignment
+size_t AudioArena::getChannelsSize(size_t sampleSize, int numChannels, int numSamples)
+{
+    return getAlignedSize(sizeof(void*) * (size_t)numChannels) + getAlignedSize(sampleSize * (size_t)numSamples) * (size_t)numChannels;
+}
+
+// false if numBytes more won't fit. they still count toward getRequestedBytes()
+bool AudioArena::hasRoom(size_t numBytes)
+{
+    if(mBlock != nullptr && mUsed + numBytes <= mCapacity)
+        return true;
+
+    mRequested += numBytes;
+
+    return false;
+}
+
+void AudioArena::release()
+{
+#if AUDIOARENAUSEMMAP
+    if(mMapping != nullptr)
+        munmap(mMapping, mMappingSize);
+#endif
+
+    mHeapBlock.free();
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mBlock = nullptr;
+    mCapacity = 0;
+    mUsed = 0;
+}
+} // namespace atec
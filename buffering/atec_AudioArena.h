@@ -0,0 +1,223 @@
+/*
+
+    One contiguous block of memory for all of a plugin instance's audio buffers, instead of a separate heap allocation per AudioBuffer.
+
+    With hundreds of instances, every RingBuffer and OlaBufferStereo allocating on its own scatters their buffers across the heap, and the audio thread pays for it in cache and TLB misses. Here the instance makes one AudioArena in prepareToPlay(), hands it to its buffers with setArena(), and they carve their storage out of it in order, packed next to each other:
+    - every allocation starts on a 64 byte boundary (a cache line, and the widest SIMD load), and so does every channel
+    - carving is a pointer bump. there's no per-buffer heap call and nothing to free one at a time; reset() rewinds the whole thing
+    - on POSIX systems the block comes straight from mmap(). with huge pages asked for, it's aligned and sized to 2MB pages and marked MADV_HUGEPAGE on Linux, so a whole processing graph can sit in a handful of TLB entries. elsewhere it's an aligned heap block
+
+    Sizing: prepare() it with the total the graph needs. if a buffer doesn't fit, it quietly falls back to allocating on its own, and getRequestedBytes() keeps counting, so after one prepareToPlay() it tells you exactly what to prepare() with next time.
+
+    NOTE:
+    - prepare() and reset() invalidate everything carved so far. call them from prepareToPlay(), then setSize()/prepare() every buffer that uses the arena again
+    - the arena has to outlive every buffer that uses it, so declare it first
+    - not thread safe. all carving happens in prepareToPlay()
+    - plain arrays (per-bin spectra, FFT work buffers) use ArenaBlock in place of juce::HeapBlock
+    - buffers that get resized again (e.g. OlaBufferStereo::init() on every setter call) keep a Reservation and pass it back in. while it's big enough, and the arena hasn't been reset since, they get the same memory back instead of stranding it and carving more. a request that didn't fit is only counted once per Reservation, so getRequestedBytes() stays exact
+
+ */
+
+#ifndef AUDIO_ARENA_H
+#define AUDIO_ARENA_H
+
+namespace atec
+{
+    #define AUDIOARENAALIGNMENT 64
+    #define AUDIOARENAHUGEPAGESIZE (2 * 1024 * 1024)
+
+    #if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID || JUCE_MAC || JUCE_IOS
+     #define AUDIOARENAUSEMMAP 1
+    #else
+     #define AUDIOARENAUSEMMAP 0
+    #endif
+
+    class AudioArena
+    {
+    public:
+        // what one buffer was carved last time
+        struct Reservation
+        {
+            void* channels = nullptr;
+            int numChannels = 0;
+            int numSamples = 0;
+            // what the last request that didn't fit added to mRequested, so asking again doesn't count it twice
+            size_t failedBytes = 0;
+            juce::uint32 generation = 0;
+        };
+
+        AudioArena();
+        ~AudioArena();
+
+        void debug(bool d);
+        void prepare(size_t numBytes, bool useHugePages);
+        void reset();
+        void* allocateBytes(size_t numBytes);
+        size_t getCapacity();
+        size_t getUsedBytes();
+        size_t getRequestedBytes();
+        bool isHugePageBacked();
+        static size_t getAlignedSize(size_t numBytes);
+        static size_t getChannelsSize(size_t sampleSize, int numChannels, int numSamples);
+
+        template <typename T>
+        T* allocate(size_t numElements)
+        {
+            return static_cast<T*>(allocateBytes(sizeof(T) * numElements));
+        }
+
+        // numChannels channels of numSamples samples, each starting on a 64 byte boundary, plus the array of channel pointers. all or nothing
+        template <typename SampleType>
+        SampleType** allocateChannels(int numChannels, int numSamples)
+        {
+            size_t channelBytes = getAlignedSize(sizeof(SampleType) * (size_t)numSamples);
+            size_t pointerBytes = getAlignedSize(sizeof(SampleType*) * (size_t)numChannels);
+            SampleType** channels;
+            char* data;
+
+            if(!hasRoom(getChannelsSize(sizeof(SampleType), numChannels, numSamples)))
+                return nullptr;
+
+            channels = static_cast<SampleType**>(allocateBytes(pointerBytes));
+            data = static_cast<char*>(allocateBytes(channelBytes * (size_t)numChannels));
+
+            for(int channel = 0; channel < numChannels; channel++)
+                channels[channel] = reinterpret_cast<SampleType*>(data + channelBytes * (size_t)channel);
+
+            return channels;
+        }
+
+        // the same, but reusing what reservation got last time if it's still valid and big enough
+        template <typename SampleType>
+        SampleType** allocateChannels(Reservation& reservation, int numChannels, int numSamples)
+        {
+            SampleType** channels;
+
+            // anything carved before the last reset() is gone
+            if(reservation.generation != mGeneration)
+            {
+                reservation = Reservation();
+                reservation.generation = mGeneration;
+            }
+
+            if(reservation.channels != nullptr && numChannels <= reservation.numChannels && numSamples <= reservation.numSamples)
+                return static_cast<SampleType**>(reservation.channels);
+
+            mRequested -= reservation.failedBytes;
+            reservation.failedBytes = 0;
+
+            channels = allocateChannels<SampleType>(numChannels, numSamples);
+
+            if(channels == nullptr)
+            {
+                reservation.failedBytes = getChannelsSize(sizeof(SampleType), numChannels, numSamples);
+                return nullptr;
+            }
+
+            reservation.channels = channels;
+            reservation.numChannels = numChannels;
+            reservation.numSamples = numSamples;
+
+            return channels;
+        }
+
+        // points buffer at cleared arena memory. false, with the buffer untouched, if there isn't room
+        template <typename SampleType>
+        bool allocateBuffer(juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples)
+        {
+            SampleType** channels = allocateChannels<SampleType>(numChannels, numSamples);
+
+            if(channels == nullptr)
+                return false;
+
+            buffer.setDataToReferTo(channels, numChannels, numSamples);
+            buffer.clear();
+
+            return true;
+        }
+
+        template <typename SampleType>
+        bool allocateBuffer(juce::AudioBuffer<SampleType>& buffer, Reservation& reservation, int numChannels, int numSamples)
+        {
+            SampleType** channels = allocateChannels<SampleType>(reservation, numChannels, numSamples);
+
+            if(channels == nullptr)
+                return false;
+
+            buffer.setDataToReferTo(channels, numChannels, numSamples);
+            buffer.clear();
+
+            return true;
+        }
+
+        // buffer.setSize(), but from arena if there's one with room. reservation belongs to the buffer, so sizing it again reuses the same memory
+        template <typename SampleType>
+        static void setBufferSize(AudioArena* arena, juce::AudioBuffer<SampleType>& buffer, Reservation& reservation, int numChannels, int numSamples)
+        {
+            if(arena == nullptr || !arena->allocateBuffer(buffer, reservation, numChannels, numSamples))
+                buffer.setSize(numChannels, numSamples);
+        }
+
+    private:
+        bool hasRoom(size_t numBytes);
+        void release();
+
+        // the aligned start of the block, and what has to be handed back to free it
+        char* mBlock;
+        void* mMapping;
+        size_t mMappingSize;
+        juce::HeapBlock<char> mHeapBlock;
+
+        size_t mCapacity;
+        size_t mUsed;
+        // everything asked for since the last reset(), including what didn't fit
+        size_t mRequested;
+        // bumped by reset(), so Reservations from before it are known to be stale
+        juce::uint32 mGeneration;
+        bool mHugePages;
+        bool mDebugFlag;
+    };
+
+    // a drop-in for juce::HeapBlock in classes that take an arena. allocate() carves from the arena when there's one with room, and falls back to the heap otherwise.
+    // it keeps its own Reservation, so allocating again at the same size or smaller gets the same arena memory back
+    template <typename T>
+    class ArenaBlock
+    {
+    public:
+        // numElements cleared to zero. only for plain data, since no constructors are run
+        void allocate(AudioArena* arena, size_t numElements)
+        {
+            T** channels = (arena != nullptr) ? arena->allocateChannels<T>(mReservation, 1, (int)numElements) : nullptr;
+
+            if(channels != nullptr)
+            {
+                mHeapBlock.free();
+                mData = channels[0];
+                std::memset(mData, 0, sizeof(T) * numElements);
+            }
+            else
+            {
+                mHeapBlock.allocate(numElements, true);
+                mData = mHeapBlock.get();
+            }
+        }
+
+        // like HeapBlock::swapWith(), for ping-ponging this frame's and the last frame's arrays
+        void swapWith(ArenaBlock<T>& other)
+        {
+            mHeapBlock.swapWith(other.mHeapBlock);
+            std::swap(mReservation, other.mReservation);
+            std::swap(mData, other.mData);
+        }
+
+        T* get() const { return mData; }
+        operator T*() const { return mData; }
+
+    private:
+        juce::HeapBlock<T> mHeapBlock;
+        AudioArena::Reservation mReservation;
+        T* mData = nullptr;
+    };
+} // namespace atec
+
+#endif
@@ -0,0 +1,84 @@
+namespace atec
+{
+MonotonicDeque::MonotonicDeque()
+{
+    mDebugFlag = false;
+
+    // no storage until setStorage()
+    mValues = nullptr;
+    mIndices = nullptr;
+    mCapacity = 0;
+    mHead = 0;
+    mCount = 0;
+}
+
+MonotonicDeque::~MonotonicDeque()
+{
+    // the storage belongs to the caller, so nothing to delete
+}
+
+void MonotonicDeque::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// capacity entries in each of values and indices. empties the deque
+void MonotonicDeque::setStorage(float* values, juce::int64* indices, int capacity)
+{
+    mValues = values;
+    mIndices = indices;
+    mCapacity = capacity;
+
+    clear();
+}
+
+void MonotonicDeque::clear()
+{
+    mHead = 0;
+    mCount = 0;
+}
+
+// add the value at index, which is one past the last one pushed, and forget anything windowSize or more samples older
+void MonotonicDeque::push(float value, juce::int64 index, int windowSize)
+{
+    int back;
+
+    jassert(windowSize <= mCapacity);
+
+    // the front leaves the window first, which frees a slot before the new value needs one
+    if(mCount > 0 && mIndices[mHead] <= index - windowSize)
+    {
+        mHead = (mHead + 1 == mCapacity) ? 0 : mHead + 1;
+        mCount--;
+    }
+
+    // anything at the back that's no bigger can never be the max again
+    while(mCount > 0)
+    {
+        back = mHead + mCount - 1;
+        back -= (back >= mCapacity) ? mCapacity : 0;
+
+        if(mValues[back] > value)
+            break;
+
+        mCount--;
+    }
+
+    back = mHead + mCount;
+    back -= (back >= mCapacity) ? mCapacity : 0;
+    mValues[back] = value;
+    mIndices[back] = index;
+    mCount++;
+}
+
+bool MonotonicDeque::isEmpty() const
+{
+    return mCount == 0;
+}
+
+// the largest value in the window. only meaningful when the deque isn't empty
+float MonotonicDeque::getMax() const
+{
+    return mValues[mHead];
+}
+} // namespace atec
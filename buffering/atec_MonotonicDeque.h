@@ -0,0 +1,45 @@
+/*
+
+    The largest value over a sliding window of a sample stream, in O(1) per sample on average however long the window is.
+
+    A new value throws out every older value at the back that it beats, since those can never be the max again, and the front drops off once it's a window length old. Every value goes in and out once. The front is always the window's max. For a sliding min, push negated values and negate getMax().
+
+    SlidingWindowStats and LookaheadLimiter both keep one of these per channel.
+
+    NOTE:
+    - the caller owns the storage: capacity values and capacity indices, handed over with setStorage(). that way many deques can share one allocation, or come out of an arena
+    - the window passed to push() can be anything up to the capacity. the front is dropped before anything is added, so a window of exactly capacity never overflows
+    - indices only need to go up by one per push(). they're int64, so they don't wrap in any realistic session
+
+ */
+
+#ifndef MONOTONIC_DEQUE_H
+#define MONOTONIC_DEQUE_H
+
+namespace atec
+{
+    class MonotonicDeque
+    {
+    public:
+        MonotonicDeque();
+        ~MonotonicDeque();
+
+        void debug(bool d);
+        void setStorage(float* values, juce::int64* indices, int capacity);
+        void clear();
+        void push(float value, juce::int64 index, int windowSize);
+        bool isEmpty() const;
+        float getMax() const;
+
+    private:
+        // a circular buffer of (index, value) pairs, in decreasing order of value from the front
+        float* mValues;
+        juce::int64* mIndices;
+        int mCapacity;
+        int mHead;
+        int mCount;
+        bool mDebugFlag;
+    };
+} // namespace atec
+
+#endif
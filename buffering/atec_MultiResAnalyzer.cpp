@@ -0,0 +1,207 @@
+namespace atec
+{
+MultiResAnalyzer::MultiResAnalyzer()
+{
+    mDebugFlag = false;
+    mRingBuf.debug(mDebugFlag);
+
+    mNumChannels = 2;
+    mOwnerBlockSize = MULTIRESDEFAULTOWNERBLOCKSIZE;
+    mSampleCount = 0;
+
+    if(mDebugFlag)
+        DBG("MultiResAnalyzer constructor called");
+}
+
+MultiResAnalyzer::~MultiResAnalyzer()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("MultiResAnalyzer destructor called");
+}
+
+void MultiResAnalyzer::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// only the shared ring buffer comes from arena. each resolution's spectrum is resized by addResolution(), so it stays on the heap. call before prepare()
+void MultiResAnalyzer::setArena(AudioArena* arena)
+{
+    mRingBuf.setArena(arena);
+}
+
+// windowSize must be a power of 2 for juce::dsp::FFT. call before prepare()
+int MultiResAnalyzer::addResolution(int windowSize, int hop)
+{
+    jassert(juce::isPowerOfTwo(windowSize));
+    jassert(hop > 0);
+
+    auto* res = new Resolution();
+
+    res->windowSize = windowSize;
+    res->hop = hop;
+    res->offset = 0;
+    res->nextFrameEnd = 0;
+    res->frameEndSample = 0;
+    res->frameFlag = false;
+
+    mResolutions.add(res);
+
+    return mResolutions.size() - 1;
+}
+
+void MultiResAnalyzer::clearResolutions()
+{
+    mResolutions.clear();
+}
+
+// allocates everything. call from prepareToPlay(), after all the addResolution() calls
+void MultiResAnalyzer::prepare(int numChannels, int ownerBlockSize)
+{
+    int maxWindowSize = 0;
+
+    mNumChannels = numChannels;
+    mOwnerBlockSize = ownerBlockSize;
+
+    for(int i = 0; i < mResolutions.size(); i++)
+    {
+        auto* res = mResolutions[i];
+        int rank = 0;
+
+        // count how many resolutions are cheaper than this one
+        for(int j = 0; j < mResolutions.size(); j++)
+            if(mResolutions[j]->windowSize < res->windowSize || (mResolutions[j]->windowSize == res->windowSize && j < i))
+                rank++;
+
+        // stagger hop boundaries by one host block per rank. with power of 2 hops, that keeps the larger FFTs out of each other's blocks
+        res->offset = (rank * mOwnerBlockSize) % res->hop;
+
+        res->fft.reset(new juce::dsp::FFT((int)std::log2(res->windowSize)));
+        res->window.reset(new juce::dsp::WindowingFunction<float>(res->windowSize, juce::dsp::WindowingFunction<float>::hann, false));
+        res->spectrum.setSize(mNumChannels, res->windowSize * 2);
+
+        maxWindowSize = juce::jmax(maxWindowSize, res->windowSize);
+    }
+
+    // one shared history for every resolution. frames end at most a block before the newest sample, so the largest window plus a couple of blocks is plenty
+    mRingBuf.setSize(mNumChannels, maxWindowSize + (mOwnerBlockSize * 2), mOwnerBlockSize);
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "MultiResAnalyzer prepare. resolutions: " + std::to_string(mResolutions.size()) + ", ring buffer size: " + std::to_string(mRingBuf.getSize());
+        DBG(post);
+    }
+}
+
+// start the analysis over from silence
+void MultiResAnalyzer::init()
+{
+    mRingBuf.init();
+    mSampleCount = 0;
+
+    for(auto* res : mResolutions)
+    {
+        res->nextFrameEnd = res->offset + res->hop;
+        res->frameEndSample = 0;
+        res->frameFlag = false;
+        res->spectrum.clear();
+    }
+}
+
+void MultiResAnalyzer::process(juce::AudioBuffer<float>& inBuf)
+{
+    juce::int64 blockEnd;
+
+    // unlike OlaBufferStereo, advance right away. frames are read relative to the newest sample, so they can include this block
+    mRingBuf.write(inBuf);
+
+    blockEnd = mSampleCount + inBuf.getNumSamples();
+
+    for(auto* res : mResolutions)
+    {
+        if(res->nextFrameEnd <= blockEnd)
+        {
+            juce::int64 frameEnd;
+
+            // if the hop is shorter than the block, several frames fell due. only the newest one is worth analyzing
+            frameEnd = res->nextFrameEnd + (((blockEnd - res->nextFrameEnd) / res->hop) * res->hop);
+
+            analyzeFrame(*res, (int)(blockEnd - frameEnd));
+
+            res->frameEndSample = frameEnd;
+            res->frameFlag = true;
+            res->nextFrameEnd = frameEnd + res->hop;
+        }
+    }
+
+    mSampleCount = blockEnd;
+}
+
+// window and FFT the frame that ends delaySamps samples before the newest sample in the ring buffer
+void MultiResAnalyzer::analyzeFrame(Resolution& res, int delaySamps)
+{
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        float* specPtr = res.spectrum.getWritePointer(channel);
+
+        mRingBuf.readUnsafe(channel, res.windowSize + delaySamps, res.spectrum, channel, res.windowSize);
+
+        // the FFT works in place over 2N floats, so the upper half has to start out empty
+        juce::FloatVectorOperations::clear(specPtr + res.windowSize, res.windowSize);
+
+        res.window->multiplyWithWindowingTable(specPtr, res.windowSize);
+        res.fft->performRealOnlyForwardTransform(specPtr);
+    }
+}
+
+int MultiResAnalyzer::getNumResolutions()
+{
+    return mResolutions.size();
+}
+
+int MultiResAnalyzer::getWindowSize(int resolution)
+{
+    return mResolutions[resolution]->windowSize;
+}
+
+int MultiResAnalyzer::getHop(int resolution)
+{
+    return mResolutions[resolution]->hop;
+}
+
+int MultiResAnalyzer::getHopOffset(int resolution)
+{
+    return mResolutions[resolution]->offset;
+}
+
+bool MultiResAnalyzer::getFrameFlag(int resolution)
+{
+    return mResolutions[resolution]->frameFlag;
+}
+
+void MultiResAnalyzer::clearFrameFlag(int resolution)
+{
+    mResolutions[resolution]->frameFlag = false;
+}
+
+// the sample count (since init()) one past the last sample in the current frame
+juce::int64 MultiResAnalyzer::getFrameEndSample(int resolution)
+{
+    return mResolutions[resolution]->frameEndSample;
+}
+
+// windowSize complex bins, laid out the way juce::dsp::FFT::performRealOnlyForwardTransform() leaves them
+juce::dsp::Complex<float>* MultiResAnalyzer::getSpectrum(int resolution, int channel)
+{
+    return reinterpret_cast<juce::dsp::Complex<float>*>(mResolutions[resolution]->spectrum.getWritePointer(channel));
+}
+
+const atec::RingBuffer& MultiResAnalyzer::getRingBufRef()
+{
+    return mRingBuf;
+}
+} // namespace atec
@@ -0,0 +1,69 @@
+/*
+
+    Multi-resolution STFT analysis (e.g. 256, 1024 and 4096 point) of one multichannel input.
+
+    Every resolution reads its frames out of the same RingBuffer, which only has to hold the largest window plus a couple of blocks. Compare that with one OlaBufferStereo per resolution, where each one keeps its own 2x window copy of the input.
+
+    All hop boundaries are counted on one shared sample clock. Each resolution's frames end exactly on (offset + k * hop), even if that falls partway through a host block. The offsets are chosen in prepare() so the larger resolutions fall due on different host blocks and their FFTs don't all land in the same callback. getFrameEndSample() reports exactly where each frame ends, so results from different resolutions can still be lined up.
+
+    USAGE:
+    - addResolution() for each window size/hop you need, then prepare() from prepareToPlay()
+    - call process() once per block. afterwards, any resolution with getFrameFlag() set has a fresh spectrum in getSpectrum()
+    - spectra are full N-point real-only FFT results, so they can go straight into the Utilities getFft*Spec() helpers
+
+ */
+
+#include "atec_RingBuffer.h"
+
+namespace atec
+{
+    #define MULTIRESDEFAULTOWNERBLOCKSIZE 1024
+
+    class MultiResAnalyzer
+    {
+    public:
+        MultiResAnalyzer();
+        ~MultiResAnalyzer();
+
+        void debug(bool d);
+        int addResolution(int windowSize, int hop);
+        void clearResolutions();
+        void prepare(int numChannels, int ownerBlockSize);
+        void setArena(AudioArena* arena);
+        void init();
+        void process(juce::AudioBuffer<float>& inBuf);
+        int getNumResolutions();
+        int getWindowSize(int resolution);
+        int getHop(int resolution);
+        int getHopOffset(int resolution);
+        bool getFrameFlag(int resolution);
+        void clearFrameFlag(int resolution);
+        juce::int64 getFrameEndSample(int resolution);
+        juce::dsp::Complex<float>* getSpectrum(int resolution, int channel);
+        const atec::RingBuffer& getRingBufRef();
+
+    private:
+        struct Resolution
+        {
+            int windowSize;
+            int hop;
+            int offset;
+            juce::int64 nextFrameEnd;
+            juce::int64 frameEndSample;
+            bool frameFlag;
+            std::unique_ptr<juce::dsp::FFT> fft;
+            std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+            // 2 * windowSize floats per channel. the frame goes in the first half and the FFT runs in place
+            juce::AudioBuffer<float> spectrum;
+        };
+
+        void analyzeFrame(Resolution& res, int delaySamps);
+
+        juce::OwnedArray<Resolution> mResolutions;
+        RingBuffer mRingBuf;
+        juce::int64 mSampleCount;
+        int mNumChannels;
+        int mOwnerBlockSize;
+        bool mDebugFlag;
+    };
+} // namespace atec
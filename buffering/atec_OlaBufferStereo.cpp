@@ -1,6 +1,6 @@
 namespace atec
 {
-OlaBufferStereo::OlaBufferStereo()
+OlaBufferStereo::OlaBufferStereo() : mPendingFraming(0)
 {
     mDebugFlag = false;
     mRingBuf.debug(mDebugFlag);
@@ -10,6 +10,23 @@ OlaBufferStereo::OlaBufferStereo()
     mWindowSize = OLABUFDEFAULTSIZE;
     mOverlap = OLABUFDEFAULTOVERLAP;
 
+    // async mode is off until setWorkerPool() is called
+    mWorkerPool = nullptr;
+    mLatencyHops = 0;
+
+    // everything on the heap until setArena() is called
+    mArena = nullptr;
+    mOverlapChansL = nullptr;
+    mOverlapChansR = nullptr;
+    mFadeChansL = nullptr;
+    mFadeChansR = nullptr;
+
+    // no capacity is reserved until prepare() is called, so the setters behave the old way until then
+    mMaxWindowSize = 0;
+    mMaxOverlap = 0;
+    mMaxOwnerBlockSize = 0;
+    mCapacityReserved = false;
+
     // initialize the buffers so there isn't garbage in them
     init();
 
@@ -36,25 +53,98 @@ void OlaBufferStereo::debug(bool d)
 // if host block size changes, best to call this and start buffering process over
 void OlaBufferStereo::init()
 {
+    int maxNumChannels, ringBufSize;
+
+    // the reserved capacity always has to cover the current settings
+    mMaxWindowSize = juce::jmax(mMaxWindowSize, mWindowSize);
+    mMaxOverlap = juce::jmax(mMaxOverlap, mOverlap);
+    mMaxOwnerBlockSize = juce::jmax(mMaxOwnerBlockSize, mOwnerBlockSize);
+
     mHop = mWindowSize/(double)mOverlap;
+
+    // hand back any frames still out with the worker pool before the channels they belong to go away
+    if(mWorkerPool != nullptr)
+        for(int channel = 0; channel < mWorkerSlots.size(); ++channel)
+            mWorkerPool->cancel(mWorkerSlots[channel]);
+
+    mNumOverlapChannels = mOverlap + mLatencyHops;
+    maxNumChannels = mMaxOverlap + mLatencyHops;
     
-    mProcessFlags.resize(mOverlap);
+    mProcessFlags.resize(maxNumChannels);
+    mWorkerSlots.resize(maxNumChannels);
+    mFrameStarts.resize(maxNumChannels);
+
+    // make the overlap buffers big enough for the largest framing first, then shrink them to the current one.
+    // with avoidReallocating set, AudioBuffer just re-points its channels into the memory it already has, so switchFraming() can do the same thing on the audio thread.
+    // arena storage is carved for the largest framing too, and re-pointed the same way by resizeOverlapBuf(). it's only carved the first time, or when the capacity grows
+    mOverlapChansL = nullptr;
+    mOverlapChansR = nullptr;
+    mFadeChansL = nullptr;
+    mFadeChansR = nullptr;
+
+    if(mArena != nullptr)
+    {
+        mOverlapChansL = mArena->allocateChannels<float>(mOverlapReservationL, maxNumChannels, mMaxWindowSize);
+        mOverlapChansR = mArena->allocateChannels<float>(mOverlapReservationR, maxNumChannels, mMaxWindowSize);
+        mFadeChansL = mArena->allocateChannels<float>(mFadeReservationL, maxNumChannels, mMaxWindowSize);
+        mFadeChansR = mArena->allocateChannels<float>(mFadeReservationR, maxNumChannels, mMaxWindowSize);
+
+        // all four or none, so the swap in switchFraming() always swaps like with like
+        if(mOverlapChansL == nullptr || mOverlapChansR == nullptr || mFadeChansL == nullptr || mFadeChansR == nullptr)
+        {
+            mOverlapChansL = nullptr;
+            mOverlapChansR = nullptr;
+            mFadeChansL = nullptr;
+            mFadeChansR = nullptr;
+        }
+    }
+
+    if(mOverlapChansL != nullptr)
+    {
+        mFadeBufL.setDataToReferTo(mFadeChansL, maxNumChannels, mMaxWindowSize);
+        mFadeBufR.setDataToReferTo(mFadeChansR, maxNumChannels, mMaxWindowSize);
+    }
+    else
+    {
+        mOverlapBufL.setSize(maxNumChannels, mMaxWindowSize);
+        mOverlapBufR.setSize(maxNumChannels, mMaxWindowSize);
+        mFadeBufL.setSize(maxNumChannels, mMaxWindowSize);
+        mFadeBufR.setSize(maxNumChannels, mMaxWindowSize);
+    }
 
-    // make a buffer with mOverlap channels, each one the same size as the ring buffer
-    mOverlapBufL.setSize(mOverlap, mWindowSize);
-    mOverlapBufR.setSize(mOverlap, mWindowSize);
+    resizeOverlapBuf(mOverlapBufL, mOverlapChansL, mNumOverlapChannels, mWindowSize);
+    resizeOverlapBuf(mOverlapBufR, mOverlapChansR, mNumOverlapChannels, mWindowSize);
+
+    if(mArena == nullptr || !mArena->allocateBuffer(mFadeScratch, mFadeScratchReservation, 2, mMaxOwnerBlockSize))
+        mFadeScratch.setSize(2, mMaxOwnerBlockSize);
     
     // always 2 channels for stereo
-    // make the RingBuffer size a multiple of the window size for OLA. 2x should be safe
+    // the RingBuffer has to hold enough history to rebuild every channel of the largest framing in switchFraming(): a block, a window, and one hop per remaining channel.
+    // 2x the largest window plus a couple of blocks covers that, and async mode needs mLatencyHops more hops on top
     // we must know mOwnerBlockSize before init(), so init() will be called in prepareToPlay()
-    mRingBuf.setSize(2, mWindowSize * 2, mOwnerBlockSize);
+    ringBufSize = (mMaxWindowSize * (2 + mLatencyHops)) + (mMaxOwnerBlockSize * 2);
+    mRingBuf.setSize(2, ringBufSize, mOwnerBlockSize);
     
     mRingBuf.init();
     mOverlapBufL.clear();
     mOverlapBufR.clear();
+    mFadeBufL.clear();
+    mFadeBufR.clear();
     mProcessFlags.fill(false);
+    mWorkerSlots.fill(-1);
+    mFrameStarts.fill(0);
 
     mOverlapBufTargetChannel = 0;
+    mSamplesWritten = 0;
+    // start out due for a frame, so the very first block fills one like it always has
+    mSamplesSinceFill = mHop;
+
+    mRequestedWindowSize = mWindowSize;
+    mRequestedOverlap = mOverlap;
+    mPendingFraming.store(0);
+    mFading = false;
+    mFadePos = 0;
+    mFadeLength = 0;
 
     if(mDebugFlag)
     {
@@ -68,6 +158,21 @@ void OlaBufferStereo::init()
     }
 }
 
+// call this from prepareToPlay() to reserve everything up front. ownerBlockSize should be the host's maximum block size
+void OlaBufferStereo::prepare(int windowSize, int overlap, int ownerBlockSize, int maxWindowSize, int maxOverlap)
+{
+    mWindowSize = windowSize;
+    mOverlap = overlap;
+    mOwnerBlockSize = ownerBlockSize;
+
+    mMaxWindowSize = juce::jmax(windowSize, maxWindowSize);
+    mMaxOverlap = juce::jmax(overlap, maxOverlap);
+    mMaxOwnerBlockSize = ownerBlockSize;
+    mCapacityReserved = true;
+
+    init();
+}
+
 void OlaBufferStereo::fillRingBuf(juce::AudioBuffer<float>& inBuf)
 {
     // use special writeNoAdvance() method so we can manually advance the RingBuffer write index after all of the OLA work is done
@@ -79,38 +184,45 @@ void OlaBufferStereo::fillRingBuf(juce::AudioBuffer<float>& inBuf)
 // call this after fillRingBuf()
 void OlaBufferStereo::fillOverlapBuf()
 {
-    int ringBufWriteIdx = mRingBuf.getWriteIdx();
-//    int ringBufSize = mRingBuf.getSize();
-    // if we hit a window hop boundary by advancing mRingBufWriteIdx on the last iteration, copy the most recent mRingBufSize samples from the ring buffer to the current overlap buffer target channel, then advance mOverlapBufTargetChannel to point to the next channel in mOverlapBuf
-    if(ringBufWriteIdx % mHop == 0)
+    // pick up a framing change from setWindowSize()/setOverlap(). only switch on the block right after a frame was filled, so the outgoing framing has as much of a complete hop left as possible to crossfade over
+    if(!mFading && mSamplesSinceFill > 0 && mSamplesSinceFill <= mOwnerBlockSize)
     {
-        juce::AudioBuffer<float> ringBufContents;
-        ringBufContents.setSize(2, mWindowSize);
-        ringBufContents.clear();
-        
-        mRingBuf.read(ringBufContents, mWindowSize);
-        
-        for (int stereoChannel = 0; stereoChannel < 2; ++stereoChannel)
+        juce::int64 pending = mPendingFraming.exchange(0);
+
+        if(pending != 0)
+            switchFraming((int)(pending >> 32), (int)(pending & 0xffffffff));
+    }
+
+    // if we hit a window hop boundary, copy the most recent mWindowSize samples from the ring buffer to the current overlap buffer target channel, then advance mOverlapBufTargetChannel to point to the next channel in mOverlapBuf
+    if(mSamplesSinceFill >= mHop)
+    {
+        fillFrame(mOverlapBufTargetChannel, 0);
+
+        if(mWorkerPool != nullptr)
         {
-            switch(stereoChannel)
-            {
-                case 0:
-                    mOverlapBufL.copyFrom(mOverlapBufTargetChannel, 0, ringBufContents, stereoChannel, 0, mWindowSize);
-                    break;
-                case 1:
-                    mOverlapBufR.copyFrom(mOverlapBufTargetChannel, 0, ringBufContents, stereoChannel, 0, mWindowSize);
-                    break;
-                default:
-                    break;
-            }
-        }
+            // the frame that went out to the pool mLatencyHops hops ago is due for output starting with this block, so bring it back first
+            int dueChannel = (mOverlapBufTargetChannel - mLatencyHops + mNumOverlapChannels) % mNumOverlapChannels;
+
+            // if the worker missed its deadline, the channel just keeps the unprocessed frame
+            if(mWorkerSlots[dueChannel] >= 0)
+                mWorkerPool->collect(mWorkerSlots[dueChannel], mOverlapBufL.getWritePointer(dueChannel), mOverlapBufR.getWritePointer(dueChannel));
 
-        // turn on the flag to indicate this overlap channel is ready for processing
-        mProcessFlags.set(mOverlapBufTargetChannel, true);
+            mWorkerSlots.set(dueChannel, -1);
+
+            // then send the new frame off. if the pool is full, this is -1 and the frame goes out unprocessed
+            mWorkerSlots.set(mOverlapBufTargetChannel, mWorkerPool->submit(mOverlapBufL.getReadPointer(mOverlapBufTargetChannel), mOverlapBufR.getReadPointer(mOverlapBufTargetChannel)));
+        }
+        else
+        {
+            // turn on the flag to indicate this overlap channel is ready for processing
+            mProcessFlags.set(mOverlapBufTargetChannel, true);
+        }
 
         // advance the target channel for next time
         mOverlapBufTargetChannel++;
-        mOverlapBufTargetChannel = mOverlapBufTargetChannel % mOverlap;
+        mOverlapBufTargetChannel = mOverlapBufTargetChannel % mNumOverlapChannels;
+
+        mSamplesSinceFill = 0;
     }
 }
 
@@ -131,6 +243,10 @@ void OlaBufferStereo::outputOlaBlock(juce::AudioBuffer<float>& outBuf)
 
     if(numChannels > 1)
     {
+        int fadeSamps = 0;
+        float fadeStart = 1.0f;
+        float fadeEnd = 1.0f;
+
         if(mDebugFlag)
         {
             if(bufSize > mHop)
@@ -141,69 +257,38 @@ void OlaBufferStereo::outputOlaBlock(juce::AudioBuffer<float>& outBuf)
             }
         }
 
+        // during a crossfade, work out how far through it this block goes. if the fade ends partway through the block, the rest of the block is all new framing
+        if(mFading)
+        {
+            fadeSamps = juce::jmin(bufSize, mFadeLength - mFadePos, mFadeScratch.getNumSamples());
+            fadeStart = mFadePos/(float)mFadeLength;
+            fadeEnd = (mFadePos + fadeSamps)/(float)mFadeLength;
+        }
+
         for(int stereoChannel = 0; stereoChannel < 2; ++stereoChannel)
         {
+            const juce::AudioBuffer<float>& overlapBuf = (stereoChannel == 0) ? mOverlapBufL : mOverlapBufR;
+
             // since we've already buffered to the ring buf by the time this method is called, start with an empty buffer for both channels. otherwise, we'll be adding to what's already in the buffer, creating little echos
             outBuf.clear(stereoChannel, 0, bufSize);
 
-            for(int overlapChannel = 0; overlapChannel < mOverlap; ++overlapChannel)
-            {
-                int thisChannel, startIdx, ringBufWriteIdx;
-
-                ringBufWriteIdx = mRingBuf.getWriteIdx();
-                
-                // the upcoming target channel is the oldest, so start the process there
-                thisChannel = mOverlapBufTargetChannel + overlapChannel;
-                thisChannel = thisChannel % mOverlap;
-
-                // we'll make the startIdx for reading out of the overlap buffer channel track the RingBuffer write index.
-                // since the RingBuffer size is set up to be a multiple of the OlaBufferStereo window size, we can just mod by mWindowSize
-                startIdx = (ringBufWriteIdx % mWindowSize);
-                // by subtracting a multiple of the hop size relative to the given overlap buffer channel we're processing, we grab the correct portion from each overlap buffer channel
-                startIdx -= (mHop * thisChannel);
-                
-                // could go negative, and if so, we should wrap around to the end of this overlap buffer channel
-                if(startIdx < 0)
-                    startIdx += mWindowSize;
-
-                if(false)
-                    std::printf("OlaBufferStereo>> mOverlapBufTargetChannel: %i, thisChannel: %i, startIdx: %i\n", mOverlapBufTargetChannel, thisChannel, startIdx);
-
-                switch(stereoChannel)
-                {
-                    case 0:
-                        // as long as we'll stay in bounds going bufSize samples beyond the startIdx, we can do one call to addFrom() and mix in bufSize samples
-                        if(startIdx + bufSize < mWindowSize)
-                            outBuf.addFrom(stereoChannel, 0, mOverlapBufL, thisChannel, startIdx, bufSize);
-                        else
-                        {
-                            // otherwise, we need to do two addFrom() calls.
-                            int numSamps = mWindowSize - startIdx;
-                            
-                            // the first adds the samples from startIdx to the end of the overlap buffer channel
-                            outBuf.addFrom(stereoChannel, 0, mOverlapBufL, thisChannel, startIdx, numSamps);
-                            // the second adds samples from the beginning of the overlap buffer channel to the end of the output buffer
-                            outBuf.addFrom(stereoChannel, numSamps, mOverlapBufL, thisChannel, 0, bufSize - numSamps);
-                        }
-                        break;
-                    case 1:
-                        if(startIdx + bufSize < mWindowSize)
-                            outBuf.addFrom(stereoChannel, 0, mOverlapBufR, thisChannel, startIdx, bufSize);
-                        else
-                        {
-                            int numSamps = mWindowSize - startIdx;
-
-                            outBuf.addFrom(stereoChannel, 0, mOverlapBufR, thisChannel, startIdx, numSamps);
-                            outBuf.addFrom(stereoChannel, numSamps, mOverlapBufR, thisChannel, 0, bufSize - numSamps);
-                        }
-                        break;
-                    default:
-                        break;
-                }
-            }
+            addOverlapChannels(outBuf, stereoChannel, overlapBuf, mNumOverlapChannels, mOverlapBufTargetChannel, mWindowSize, mHop, mSamplesSinceFill, bufSize);
 
             // reduce gain based on overlap.
             outBuf.applyGain(stereoChannel, 0, bufSize, 1.0f/(double)mOverlap);
+
+            if(fadeSamps > 0)
+            {
+                const juce::AudioBuffer<float>& fadeBuf = (stereoChannel == 0) ? mFadeBufL : mFadeBufR;
+
+                // fade the new framing in
+                outBuf.applyGainRamp(stereoChannel, 0, fadeSamps, fadeStart, fadeEnd);
+
+                // and mix in the old framing, fading out. it gets its own overlap gain since it may have a different overlap
+                mFadeScratch.clear(stereoChannel, 0, fadeSamps);
+                addOverlapChannels(mFadeScratch, stereoChannel, fadeBuf, mFadeNumChannels, mFadeTargetChannel, mFadeWindowSize, mFadeHop, mFadeSamplesSinceFill, fadeSamps);
+                outBuf.addFromWithRamp(stereoChannel, 0, mFadeScratch.getReadPointer(stereoChannel), fadeSamps, (1.0f - fadeStart)/(float)mFadeOverlap, (1.0f - fadeEnd)/(float)mFadeOverlap);
+            }
         }
     }
 }
@@ -212,6 +297,18 @@ void OlaBufferStereo::outputOlaBlock(juce::AudioBuffer<float>& outBuf)
 void OlaBufferStereo::advanceWriteIdx(int n)
 {
     mRingBuf.advanceWriteIdx(n);
+
+    mSamplesSinceFill += n;
+    mSamplesWritten += n;
+
+    if(mFading)
+    {
+        mFadeSamplesSinceFill += n;
+        mFadePos += n;
+
+        if(mFadePos >= mFadeLength)
+            mFading = false;
+    }
 }
 
 int OlaBufferStereo::getWindowSize()
@@ -219,10 +316,19 @@ int OlaBufferStereo::getWindowSize()
     return mWindowSize;
 }
 
+// within the prepared capacity, the switch happens in the next fillOverlapBuf(). that callback copies every new frame out of the ring buffer, and the owner has every one of them to process, so expect it to cost up to mOverlap + mLatencyHops hops' worth of work at once
 void OlaBufferStereo::setWindowSize(int N)
 {
-    mWindowSize = N;
-    init();
+    mRequestedWindowSize = N;
+
+    if(isWithinCapacity(mRequestedWindowSize, mRequestedOverlap))
+        requestFraming();
+    else
+    {
+        mWindowSize = mRequestedWindowSize;
+        mOverlap = mRequestedOverlap;
+        init();
+    }
 }
 
 int OlaBufferStereo::getOverlap()
@@ -230,10 +336,19 @@ int OlaBufferStereo::getOverlap()
     return mOverlap;
 }
 
+// same one-callback spike as setWindowSize(), with the new overlap's channel count
 void OlaBufferStereo::setOverlap(int o)
 {
-    mOverlap = o;
-    init();
+    mRequestedOverlap = o;
+
+    if(isWithinCapacity(mRequestedWindowSize, mRequestedOverlap))
+        requestFraming();
+    else
+    {
+        mWindowSize = mRequestedWindowSize;
+        mOverlap = mRequestedOverlap;
+        init();
+    }
 }
 
 int OlaBufferStereo::getOwnerBlockSize()
@@ -244,9 +359,68 @@ int OlaBufferStereo::getOwnerBlockSize()
 void OlaBufferStereo::setOwnerBlockSize(int N)
 {
     mOwnerBlockSize = N;
+
+    // the ring buffer was sized for the largest block, so a smaller one only moves the read position. no need to clear anything
+    if(mCapacityReserved && N <= mMaxOwnerBlockSize)
+        mRingBuf.setOwnerBlockSize(N);
+    else
+        init();
+}
+
+// carve every buffer out of arena from the next prepare()/init() on. pass nullptr to go back to the heap. call from prepareToPlay(), before prepare()
+void OlaBufferStereo::setArena(AudioArena* arena)
+{
+    mArena = arena;
+    mRingBuf.setArena(arena);
+}
+
+// pass nullptr to go back to processing flagged frames on the audio thread. like the other setters, this calls init(), so call it from prepareToPlay()
+void OlaBufferStereo::setWorkerPool(OlaWorkerPool* pool, int latencyHops)
+{
+    // the pool copies its own window size in and out of every frame, so anything else reads past the end of the overlap channels or leaves part of the frame behind
+    jassert(pool == nullptr || pool->getWindowSize() == mWindowSize);
+
+    // cancel anything outstanding with the old pool before switching
+    if(mWorkerPool != nullptr)
+        for(int channel = 0; channel < mWorkerSlots.size(); ++channel)
+            mWorkerPool->cancel(mWorkerSlots[channel]);
+
+    mWorkerSlots.fill(-1);
+
+    mWorkerPool = pool;
+
+    // need at least one hop for the workers to do anything useful
+    if(mWorkerPool != nullptr)
+        mLatencyHops = juce::jmax(1, latencyHops);
+    else
+        mLatencyHops = 0;
+
     init();
 }
 
+int OlaBufferStereo::getLatencyHops()
+{
+    return mLatencyHops;
+}
+
+// the most frames this instance can have out with the pool at once, plus one for a late frame still being finished by a worker
+int OlaBufferStereo::getRequiredWorkerSlots()
+{
+    return mLatencyHops + 1;
+}
+
+// frames are read one owner block behind the write index, so the sync path is a window plus a block late. async mode adds mLatencyHops hops on top of that
+int OlaBufferStereo::getLatencySamples()
+{
+    return mWindowSize + mOwnerBlockSize + (mLatencyHops * mHop);
+}
+
+// where the frame in this overlap channel starts, counted in input samples since init(). it can be negative for the first few frames, which start in the silence before any input
+juce::int64 OlaBufferStereo::getFrameStartSample(int channel)
+{
+    return mFrameStarts[channel];
+}
+
 bool OlaBufferStereo::getProcessFlag(int channel)
 {
     bool state;
@@ -311,4 +485,136 @@ float* OlaBufferStereo::getWritePointerR(int channel)
 
     return ptr;
 }
+bool OlaBufferStereo::isWithinCapacity(int windowSize, int overlap)
+{
+    return mCapacityReserved && windowSize <= mMaxWindowSize && overlap <= mMaxOverlap && overlap > 0 && windowSize >= overlap;
+}
+
+// publish the requested framing for the audio thread. safe to call from any thread
+void OlaBufferStereo::requestFraming()
+{
+    juce::int64 pending = ((juce::int64)mRequestedWindowSize << 32) | (juce::int64)mRequestedOverlap;
+
+    mPendingFraming.store(pending);
+}
+
+// audio thread only. constant time apart from rebuilding the frames, and never allocates since the buffers already have room for the largest framing
+void OlaBufferStereo::switchFraming(int windowSize, int overlap)
+{
+    if(windowSize == mWindowSize && overlap == mOverlap)
+        return;
+
+    // only the overlap can change under a worker pool, which was prepared for one window size
+    jassert(mWorkerPool == nullptr || windowSize == mWorkerPool->getWindowSize());
+
+    // whatever the old framing still has out with the worker pool would only come due after the crossfade is over
+    if(mWorkerPool != nullptr)
+        for(int channel = 0; channel < mNumOverlapChannels; ++channel)
+            mWorkerPool->cancel(mWorkerSlots[channel]);
+
+    // the current framing becomes the outgoing one. swapping AudioBuffers just swaps their pointers
+    std::swap(mOverlapBufL, mFadeBufL);
+    std::swap(mOverlapBufR, mFadeBufR);
+    std::swap(mOverlapChansL, mFadeChansL);
+    std::swap(mOverlapChansR, mFadeChansR);
+
+    mFadeWindowSize = mWindowSize;
+    mFadeOverlap = mOverlap;
+    mFadeHop = mHop;
+    mFadeNumChannels = mNumOverlapChannels;
+    mFadeTargetChannel = mOverlapBufTargetChannel;
+    mFadeSamplesSinceFill = mSamplesSinceFill;
+
+    // the old framing stops filling frames now, so its output is only complete up until its next frame would have started. crossfade over that.
+    // if the hop is no bigger than a block, that's zero, so fade over one block anyway. the missing frame only contributes the leading edge of its window during that block
+    mFadeLength = juce::jmax(mHop - mSamplesSinceFill, mOwnerBlockSize);
+    mFadePos = 0;
+    mFading = true;
+
+    mWindowSize = windowSize;
+    mOverlap = overlap;
+    mHop = mWindowSize/(double)mOverlap;
+    mNumOverlapChannels = mOverlap + mLatencyHops;
+
+    resizeOverlapBuf(mOverlapBufL, mOverlapChansL, mNumOverlapChannels, mWindowSize);
+    resizeOverlapBuf(mOverlapBufR, mOverlapChansR, mNumOverlapChannels, mWindowSize);
+    mProcessFlags.fill(false);
+    mWorkerSlots.fill(-1);
+
+    // rather than waiting a whole window for the new framing to fill up, rebuild every channel from the history that's already in the ring buffer, as if the new framing had been running all along.
+    // it can't be spread across hops, since every one of these frames overlaps the very next output block. that makes this callback the expensive one
+    // the newest frame goes in the last channel so that the target channel wraps back around to 0
+    for(int hopsAgo = 0; hopsAgo < mNumOverlapChannels; hopsAgo++)
+    {
+        int channel = mNumOverlapChannels - 1 - hopsAgo;
+
+        fillFrame(channel, hopsAgo * mHop);
+
+        // in async mode, frames that aren't due yet go to the pool as usual. the ones that are already due get flagged, so the owner can process them inline. otherwise they play unprocessed, just like a missed deadline
+        if(mWorkerPool != nullptr && hopsAgo < mLatencyHops)
+            mWorkerSlots.set(channel, mWorkerPool->submit(mOverlapBufL.getReadPointer(channel), mOverlapBufR.getReadPointer(channel)));
+        else
+            mProcessFlags.set(channel, true);
+    }
+
+    mOverlapBufTargetChannel = 0;
+    mSamplesSinceFill = 0;
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "OlaBufferStereo switchFraming. mWindowSize: " + std::to_string(mWindowSize) + ", mOverlap: " + std::to_string(mOverlap) + ", mHop: " + std::to_string(mHop) + ", mFadeLength: " + std::to_string(mFadeLength);
+        DBG(post);
+    }
+}
+
+// copy the mWindowSize samples that end delaySamps samples before the newest readable sample into one overlap buffer channel
+void OlaBufferStereo::fillFrame(int channel, int delaySamps)
+{
+    mRingBuf.read(0, mWindowSize + delaySamps, mOverlapBufL, channel, mWindowSize);
+    mRingBuf.read(1, mWindowSize + delaySamps, mOverlapBufR, channel, mWindowSize);
+
+    // RingBuffer::read() stays a block behind the write index, which hasn't been advanced past the current block yet
+    mFrameStarts.set(channel, mSamplesWritten - mOwnerBlockSize - delaySamps - mWindowSize);
+}
+
+// mix one framing's overlap channels into outChannel of outBuf
+void OlaBufferStereo::addOverlapChannels(juce::AudioBuffer<float>& outBuf, int outChannel, const juce::AudioBuffer<float>& overlapBuf, int numChannels, int targetChannel, int windowSize, int hop, int samplesSinceFill, int numSamps)
+{
+    for(int overlapChannel = 0; overlapChannel < numChannels; ++overlapChannel)
+    {
+        int thisChannel, startIdx, hopsAgo;
+
+        // the upcoming target channel is the oldest, so start the process there
+        thisChannel = targetChannel + overlapChannel;
+        thisChannel = thisChannel % numChannels;
+
+        // the channel just before the target channel was filled on the most recent hop boundary, the one before that a hop earlier, and so on
+        hopsAgo = numChannels - 1 - overlapChannel;
+
+        // we'll make the startIdx for reading out of the overlap buffer channel track how far we are past the channel's hop boundary.
+        // in async mode a frame doesn't start playing until mLatencyHops hops after it was filled, so back up by that much too
+        startIdx = (hopsAgo - mLatencyHops) * hop;
+        startIdx += samplesSinceFill;
+
+        // if it's negative, this frame is still out with the worker pool and isn't due yet. if it's past the end of the window, the frame is used up, which only happens to an outgoing framing
+        if(startIdx < 0 || startIdx >= windowSize)
+            continue;
+
+        if(false)
+            std::printf("OlaBufferStereo>> targetChannel: %i, thisChannel: %i, startIdx: %i\n", targetChannel, thisChannel, startIdx);
+
+        // the last frame ends partway through the block if the host block size doesn't divide the hop evenly
+        outBuf.addFrom(outChannel, 0, overlapBuf, thisChannel, startIdx, juce::jmin(numSamps, windowSize - startIdx));
+    }
+}
+
+// the first numChannels channels, numSamples long. with arena storage that's re-pointing at the arena channels, which never allocates. otherwise it's setSize() with avoidReallocating, which does the same within the buffer's own memory
+void OlaBufferStereo::resizeOverlapBuf(juce::AudioBuffer<float>& buffer, float** arenaChannels, int numChannels, int numSamples)
+{
+    if(arenaChannels != nullptr)
+        buffer.setDataToReferTo(arenaChannels, numChannels, numSamples);
+    else
+        buffer.setSize(numChannels, numSamples, false, false, true);
+}
 } //namespace atec
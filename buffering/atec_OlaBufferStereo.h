@@ -5,10 +5,28 @@
     NOTE:
     - the host blocksize must be less than mHop! you will get clicks otherwise
  
+    RUNTIME FRAMING CHANGES:
+    - call prepare() from prepareToPlay() with the largest window size, overlap and host block size you'll ever want. everything is allocated there, once
+    - after that, setWindowSize(), setOverlap() and setOwnerBlockSize() don't allocate or clear any history, as long as they stay within that capacity. window/overlap changes are picked up by fillOverlapBuf() on the audio thread and crossfaded from the old framing to the new one
+    - the new framing is rebuilt from the ring buffer history, so every channel gets flagged for processing on the block of the switch. always size per-frame processing from getWindowSize() after fillOverlapBuf()
+    - that makes the switch a CPU spike: one callback does a whole window's worth of frame copies and per-frame processing instead of one hop's. leave headroom for it, or only switch framing where a late block won't matter
+    - without prepare(), or when asking for more than the reserved capacity, the setters fall back to calling init() like they always have
+ 
     TODO:
     - add .setRingBufSize() and .setOverlap() methods.
     - add methods for getting juce::AudioBuffer pointers directly, so we can use AudioBuffer methods
     - improve fillOverlapBuf() and outputOlaBlock() methods so they can handle host block sizes greater than or equal to mHop
+    - template on the sample type. it's float only for now, since the frames feed the FFT-based classes and OlaWorkerPool, which are float too
+ 
+    ARENA:
+    - setArena() before prepare() carves the overlap buffers, the fade buffers and the ring buffer out of an AudioArena instead of the heap. they're laid out for the largest framing, so runtime framing switches just re-point channels within them
+    - they're carved once. the init() every setter and setWorkerPool() call gets the same arena memory back, unless the capacity has to grow
+    - anything that doesn't fit in the arena falls back to the heap
+
+    ASYNC MODE:
+    - call setWorkerPool() with an OlaWorkerPool prepared for the same window size, and a latency budget in hops. the window size can't change while the pool is attached, but the overlap can. ready frames then go to the pool instead of raising mProcessFlags, and come back latencyHops hops later
+    - the extra latency is included in getLatencySamples(), so pass that to the host
+    - if a worker misses its deadline, the unprocessed frame is output instead. since outputOlaBlock() scales by 1/mOverlap, that's a clean pass-through of the dry signal
  
  */
 
@@ -19,6 +37,8 @@ namespace atec
     #define OLABUFDEFAULTSIZE 4096
     #define OLABUFDEFAULTOVERLAP 4
 
+    class OlaWorkerPool;
+
     class OlaBufferStereo
     {
     public:
@@ -27,6 +47,7 @@ namespace atec
 
         void debug(bool d);
         void init();
+        void prepare(int windowSize, int overlap, int ownerBlockSize, int maxWindowSize, int maxOverlap);
         void fillRingBuf(juce::AudioBuffer<float>& inBuf);
         void fillOverlapBuf();
         void doWindowing(int channel, juce::dsp::WindowingFunction<float>& window);
@@ -38,8 +59,14 @@ namespace atec
         void setOverlap(int o);
         int getOwnerBlockSize();
         void setOwnerBlockSize(int N);
+        void setWorkerPool(OlaWorkerPool* pool, int latencyHops);
+        void setArena(AudioArena* arena);
+        int getLatencyHops();
+        int getRequiredWorkerSlots();
+        int getLatencySamples();
         bool getProcessFlag(int channel);
         void clearProcessFlag(int channel);
+        juce::int64 getFrameStartSample(int channel);
         const juce::AudioBuffer<float>& getBufRefL();
         const juce::AudioBuffer<float>& getBufRefR();
         const atec::RingBuffer& getRingBufRef();
@@ -52,14 +79,70 @@ namespace atec
 
         juce::AudioBuffer<float> mOverlapBufL;
         juce::AudioBuffer<float> mOverlapBufR;
+        // the outgoing framing after a runtime switch. it stops capturing frames and is crossfaded out over what's left of its last hop
+        juce::AudioBuffer<float> mFadeBufL;
+        juce::AudioBuffer<float> mFadeBufR;
+        juce::AudioBuffer<float> mFadeScratch;
         RingBuffer mRingBuf;
+        OlaWorkerPool* mWorkerPool;
+        // with an arena, the overlap buffers' channel pointers for the largest framing, in arena memory. nullptr when they're on the heap
+        AudioArena* mArena;
+        float** mOverlapChansL;
+        float** mOverlapChansR;
+        float** mFadeChansL;
+        float** mFadeChansR;
+        // what each of them (and mFadeScratch) got from the arena, so init() gets the same memory back instead of carving more every time a setter calls it
+        AudioArena::Reservation mOverlapReservationL;
+        AudioArena::Reservation mOverlapReservationR;
+        AudioArena::Reservation mFadeReservationL;
+        AudioArena::Reservation mFadeReservationR;
+        AudioArena::Reservation mFadeScratchReservation;
 
         int mOwnerBlockSize;
         int mWindowSize;
         int mOverlap;
         int mHop;
+        // async mode holds on to each frame for mLatencyHops extra hops, so it needs mOverlap + mLatencyHops channels
+        int mLatencyHops;
+        int mNumOverlapChannels;
         int mOverlapBufTargetChannel;
+        int mSamplesSinceFill;
+        // input samples since init(), for telling callers where each frame came from
+        juce::int64 mSamplesWritten;
+
+        // capacity reserved by prepare()
+        int mMaxWindowSize;
+        int mMaxOverlap;
+        int mMaxOwnerBlockSize;
+        bool mCapacityReserved;
+
+        // the setters write the requested framing here, packed as (windowSize << 32) | overlap, and the audio thread picks it up. 0 means nothing pending
+        int mRequestedWindowSize;
+        int mRequestedOverlap;
+        std::atomic<juce::int64> mPendingFraming;
+
+        int mFadeWindowSize;
+        int mFadeOverlap;
+        int mFadeHop;
+        int mFadeNumChannels;
+        int mFadeTargetChannel;
+        int mFadeSamplesSinceFill;
+        int mFadeLength;
+        int mFadePos;
+        bool mFading;
+
         juce::Array<bool> mProcessFlags;
+        // the OlaWorkerPool slot each overlap channel is waiting on, or -1
+        juce::Array<int> mWorkerSlots;
+        // the input sample index of each overlap channel's first sample
+        juce::Array<juce::int64> mFrameStarts;
         bool mDebugFlag;
+
+        bool isWithinCapacity(int windowSize, int overlap);
+        void requestFraming();
+        void switchFraming(int windowSize, int overlap);
+        void fillFrame(int channel, int delaySamps);
+        void resizeOverlapBuf(juce::AudioBuffer<float>& buffer, float** arenaChannels, int numChannels, int numSamples);
+        void addOverlapChannels(juce::AudioBuffer<float>& outBuf, int outChannel, const juce::AudioBuffer<float>& overlapBuf, int numChannels, int targetChannel, int windowSize, int hop, int samplesSinceFill, int numSamps);
     };
 } // namespace atec
@@ -0,0 +1,236 @@
+namespace atec
+{
+OlaWorkerPool::Worker::Worker(OlaWorkerPool& pool) : juce::Thread("atec OlaWorkerPool"), mPool(pool)
+{
+}
+
+void OlaWorkerPool::Worker::run()
+{
+    int idleSpins = 0;
+
+    // the audio thread never wakes us, since notify() signals a WaitableEvent and that takes a lock. so keep going as long as there's work queued up,
+    // yield for a little while in case the next frame is right behind, then poll every OLAWORKERPOOLIDLEWAITMS until there's more
+    while(!threadShouldExit())
+    {
+        if(mPool.processNextSlot())
+            idleSpins = 0;
+        else if(idleSpins < OLAWORKERPOOLIDLESPINS)
+        {
+            idleSpins++;
+            juce::Thread::yield();
+        }
+        else
+            wait(OLAWORKERPOOLIDLEWAITMS);
+    }
+}
+
+OlaWorkerPool::OlaWorkerPool() : mNextTicket(0), mNumMissedDeadlines(0)
+{
+    mDebugFlag = false;
+
+    mNumSlots = 0;
+    mWindowSize = 0;
+
+    if(mDebugFlag)
+        DBG("OlaWorkerPool constructor called");
+}
+
+OlaWorkerPool::~OlaWorkerPool()
+{
+    release();
+
+    if(mDebugFlag)
+        DBG("OlaWorkerPool destructor called");
+}
+
+void OlaWorkerPool::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// only call this while the pool isn't prepared, since the workers read the callback without any locking
+void OlaWorkerPool::setFrameCallback(FrameCallback callback)
+{
+    jassert(mWorkers.size() == 0);
+
+    mFrameCallback = std::move(callback);
+}
+
+// allocates all slot storage and starts the worker threads. call from prepareToPlay(), never from the audio thread
+void OlaWorkerPool::prepare(int numSlots, int windowSize, int numThreads)
+{
+    release();
+
+    mNumSlots = juce::jmax(1, numSlots);
+    mWindowSize = windowSize;
+
+    mSlotBufL.setSize(mNumSlots, mWindowSize);
+    mSlotBufR.setSize(mNumSlots, mWindowSize);
+    mSlotBufL.clear();
+    mSlotBufR.clear();
+
+    mSlotStates.reset(new std::atomic<int>[mNumSlots]);
+    mSlotTickets.reset(new std::atomic<juce::uint32>[mNumSlots]);
+
+    for(int slot = 0; slot < mNumSlots; slot++)
+    {
+        mSlotStates[slot].store(slotFree);
+        mSlotTickets[slot].store(0);
+    }
+
+    mNextTicket.store(0);
+    mNumMissedDeadlines.store(0);
+
+    for(int i = 0; i < juce::jmax(1, numThreads); i++)
+        mWorkers.add(new Worker(*this))->startThread();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "OlaWorkerPool prepare. mNumSlots: " + std::to_string(mNumSlots) + ", mWindowSize: " + std::to_string(mWindowSize) + ", threads: " + std::to_string(mWorkers.size());
+        DBG(post);
+    }
+}
+
+void OlaWorkerPool::release()
+{
+    for(auto* worker : mWorkers)
+        worker->signalThreadShouldExit();
+
+    for(auto* worker : mWorkers)
+        worker->stopThread(1000);
+
+    mWorkers.clear();
+}
+
+// audio thread: copy a frame into a free slot and queue it. returns the slot index to hand back to collect(), or -1 if every slot is busy
+int OlaWorkerPool::submit(const float* frameL, const float* frameR)
+{
+    for(int slot = 0; slot < mNumSlots; slot++)
+    {
+        int expected = slotFree;
+
+        // claim the slot first so nobody else can grab it while we're copying into it
+        if(mSlotStates[slot].compare_exchange_strong(expected, slotClaimed))
+        {
+            juce::FloatVectorOperations::copy(mSlotBufL.getWritePointer(slot), frameL, mWindowSize);
+            juce::FloatVectorOperations::copy(mSlotBufR.getWritePointer(slot), frameR, mWindowSize);
+
+            mSlotTickets[slot].store(mNextTicket.fetch_add(1));
+            // no notify(). the workers poll, so publishing the state is all the handoff there is
+            mSlotStates[slot].store(slotQueued);
+
+            return slot;
+        }
+    }
+
+    mNumMissedDeadlines++;
+
+    return -1;
+}
+
+// audio thread: copy a finished frame back out of its slot and free the slot. returns false if the worker missed its deadline, in which case the frame buffers are left untouched
+bool OlaWorkerPool::collect(int slot, float* frameL, float* frameR)
+{
+    if(slot < 0 || slot >= mNumSlots)
+        return false;
+
+    if(mSlotStates[slot].load() == slotDone)
+    {
+        juce::FloatVectorOperations::copy(frameL, mSlotBufL.getReadPointer(slot), mWindowSize);
+        juce::FloatVectorOperations::copy(frameR, mSlotBufR.getReadPointer(slot), mWindowSize);
+
+        mSlotStates[slot].store(slotFree);
+
+        return true;
+    }
+
+    cancel(slot);
+
+    mNumMissedDeadlines++;
+
+    return false;
+}
+
+// give up on a slot without copying anything out, e.g. when the owner is re-initialized. safe to call with -1
+void OlaWorkerPool::cancel(int slot)
+{
+    if(slot < 0 || slot >= mNumSlots)
+        return;
+
+    // if no worker has started on it, just take it back
+    int expected = slotQueued;
+
+    if(!mSlotStates[slot].compare_exchange_strong(expected, slotFree))
+    {
+        // a worker is busy with it, so let that worker free the slot when it's done.
+        // if the worker finished in the meantime, the result is dropped for determinism
+        expected = slotWorking;
+
+        if(!mSlotStates[slot].compare_exchange_strong(expected, slotAbandoned) && expected == slotDone)
+            mSlotStates[slot].store(slotFree);
+    }
+}
+
+// worker thread: process the oldest queued slot, if there is one
+bool OlaWorkerPool::processNextSlot()
+{
+    int oldestSlot = -1;
+    juce::uint32 oldestTicket = 0;
+
+    for(int slot = 0; slot < mNumSlots; slot++)
+    {
+        if(mSlotStates[slot].load() == slotQueued)
+        {
+            juce::uint32 ticket = mSlotTickets[slot].load();
+
+            // tickets wrap, so compare the difference rather than the raw values
+            if(oldestSlot < 0 || (juce::int32)(ticket - oldestTicket) < 0)
+            {
+                oldestSlot = slot;
+                oldestTicket = ticket;
+            }
+        }
+    }
+
+    if(oldestSlot < 0)
+        return false;
+
+    int expected = slotQueued;
+
+    // another worker (or a collect() call) may have beaten us to it
+    if(!mSlotStates[oldestSlot].compare_exchange_strong(expected, slotWorking))
+        return true;
+
+    if(mFrameCallback)
+        mFrameCallback(mSlotBufL.getWritePointer(oldestSlot), mSlotBufR.getWritePointer(oldestSlot), mWindowSize);
+
+    expected = slotWorking;
+
+    // if the audio thread gave up on this slot while we were working, the result is stale and the slot can go straight back to the free list
+    if(!mSlotStates[oldestSlot].compare_exchange_strong(expected, slotDone))
+        mSlotStates[oldestSlot].store(slotFree);
+
+    return true;
+}
+
+int OlaWorkerPool::getNumSlots()
+{
+    return mNumSlots;
+}
+
+int OlaWorkerPool::getWindowSize()
+{
+    return mWindowSize;
+}
+
+int OlaWorkerPool::getNumMissedDeadlines()
+{
+    return mNumMissedDeadlines.load();
+}
+
+void OlaWorkerPool::resetNumMissedDeadlines()
+{
+    mNumMissedDeadlines.store(0);
+}
+} // namespace atec
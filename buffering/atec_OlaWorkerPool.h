@@ -0,0 +1,74 @@
+/*
+
+    A small pool of background threads for heavy per-frame work on OlaBufferStereo frames (denoising, matching EQ, etc).
+
+    Instead of processing a flagged overlap channel inside the audio callback, OlaBufferStereo can submit() the frame to this pool and collect() the result one or more hops later. That spreads the cost of each frame across the hop instead of spiking the callback once per hop, and lets idle cores do the work.
+
+    The audio thread never locks: each slot moves through a small set of atomic states (free -> claimed -> queued -> working -> done -> free). It doesn't wake the workers either, since Thread::notify() takes a mutex and could leave the callback waiting on a worker thread. Workers poll for queued slots instead, every OLAWORKERPOOLIDLEWAITMS when idle. If a frame hasn't finished by the time it's collected, collect() returns false and the late result is thrown away when the worker is done with it.
+
+    NOTE:
+    - set the frame callback before prepare(). it runs on the worker threads, so it must only touch the frame data it's handed
+    - the callback is responsible for windowing, since OlaBufferStereo::doWindowing() is never called on frames that go through the pool
+    - one pool can be shared by several OlaBufferStereo instances, as long as there are enough slots for all of them (see OlaBufferStereo::getRequiredWorkerSlots())
+
+ */
+
+namespace atec
+{
+    #define OLAWORKERPOOLDEFAULTSLOTS 8
+    #define OLAWORKERPOOLDEFAULTTHREADS 2
+    // idle workers poll the slots at this rate. it's the most a queued frame waits before a worker picks it up, so keep it well under a hop
+    #define OLAWORKERPOOLIDLEWAITMS 1
+    // how many times an idle worker yields before it goes back to polling
+    #define OLAWORKERPOOLIDLESPINS 64
+
+    class OlaWorkerPool
+    {
+    public:
+        using FrameCallback = std::function<void(float* frameL, float* frameR, int windowSize)>;
+
+        OlaWorkerPool();
+        ~OlaWorkerPool();
+
+        void debug(bool d);
+        void setFrameCallback(FrameCallback callback);
+        void prepare(int numSlots, int windowSize, int numThreads);
+        void release();
+        int submit(const float* frameL, const float* frameR);
+        bool collect(int slot, float* frameL, float* frameR);
+        void cancel(int slot);
+        int getNumSlots();
+        int getWindowSize();
+        int getNumMissedDeadlines();
+        void resetNumMissedDeadlines();
+
+    private:
+        enum SlotState {slotFree, slotClaimed, slotQueued, slotWorking, slotDone, slotAbandoned};
+
+        class Worker : public juce::Thread
+        {
+        public:
+            Worker(OlaWorkerPool& pool);
+            void run() override;
+
+        private:
+            OlaWorkerPool& mPool;
+        };
+
+        bool processNextSlot();
+
+        FrameCallback mFrameCallback;
+        juce::OwnedArray<Worker> mWorkers;
+        // one channel per slot
+        juce::AudioBuffer<float> mSlotBufL;
+        juce::AudioBuffer<float> mSlotBufR;
+        std::unique_ptr<std::atomic<int>[]> mSlotStates;
+        // submission order, so workers always pick up the oldest queued frame first
+        std::unique_ptr<std::atomic<juce::uint32>[]> mSlotTickets;
+        std::atomic<juce::uint32> mNextTicket;
+        std::atomic<int> mNumMissedDeadlines;
+        int mNumSlots;
+        int mWindowSize;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -1,12 +1,14 @@
 namespace atec
 {
-RingBuffer::RingBuffer()
+template <typename SampleType>
+BasicRingBuffer<SampleType>::BasicRingBuffer()
 {
     mDebugFlag = false;
 
     mBufSize = RINGBUFDEFAULTSIZE;
     mNumChan = RINGBUFDEFAULTCHAN;
     mOwnerBlockSize = RINGBUFDEFAULTOWNERBLOCKSIZE;
+    mArena = nullptr;
 
     mBuffer.setSize(mNumChan, mBufSize);
 
@@ -17,50 +19,62 @@ RingBuffer::RingBuffer()
         DBG("RingBuffer constructor called");
 }
 
-RingBuffer::~RingBuffer()
+template <typename SampleType>
+BasicRingBuffer<SampleType>::~BasicRingBuffer()
 {
     // using smart pointers only, so nothing to delete
     if(mDebugFlag)
         DBG("RingBuffer destructor called");
 }
 
-void RingBuffer::debug(bool d)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::debug(bool d)
 {
     mDebugFlag = d;
 }
 
 // if host block size changes, best to call this and start buffering process over
-void RingBuffer::init()
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::init()
 {
     mBuffer.clear();
     mWriteIdx = 0;
+
+    for(auto* stats : mStats)
+        stats->init();
 }
 
 // TODO: assumes mBuffer and inBuf have the same number of channels
-void RingBuffer::write(juce::AudioBuffer<float>& inBuf, bool advance)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::write(juce::AudioBuffer<SampleType>& inBuf, bool advance)
 {
     auto N = inBuf.getNumSamples();
 
     // TODO: safety check to make sure that inBuf numSamples <= mBuffer numSamples and inBuf numChan == mBuffer numChan
     for(int channel = 0; channel < mNumChan; channel++)
-    {
-        // copy a block from the host into our ring buffer starting at mRingBufWriteIdx
-        // TODO: protect wraparound
-        mBuffer.copyFrom(channel, mWriteIdx, inBuf, channel, 0, N);
-    }
+        write(channel, inBuf, channel, N, false);
     
     // advance by the host buffer size
     if(advance)
         advanceWriteIdx(N);
 }
 
-void RingBuffer::write(int destChannel, juce::AudioBuffer<float>& sourceBuf, int sourceChannel, int numSamps, bool advance)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::write(int destChannel, juce::AudioBuffer<SampleType>& sourceBuf, int sourceChannel, int numSamps, bool advance)
 {
     // TODO: safety check to make sure that inBuf numSamples <= mBuffer numSamples
 
     // copy a block from the host into our ring buffer starting at mRingBufWriteIdx
-    // TODO: protect wraparound
-    mBuffer.copyFrom(destChannel, mWriteIdx, sourceBuf, sourceChannel, 0, numSamps);
+    if(mWriteIdx + numSamps <= mBufSize)
+        mBuffer.copyFrom(destChannel, mWriteIdx, sourceBuf, sourceChannel, 0, numSamps);
+    else
+    {
+        // the buffer size is normally a multiple of the owner block size, so this only happens if the owner's block size changed without a resize
+        int firstSamps = mBufSize - mWriteIdx;
+
+        mBuffer.copyFrom(destChannel, mWriteIdx, sourceBuf, sourceChannel, 0, firstSamps);
+        mBuffer.copyFrom(destChannel, 0, sourceBuf, sourceChannel, firstSamps, numSamps - firstSamps);
+    }
     
     // advance by the host buffer size
     if(advance)
@@ -68,14 +82,16 @@ void RingBuffer::write(int destChannel, juce::AudioBuffer<float>& sourceBuf, int
 }
 
 // write one sample value in a given channel and at a given offset from the current write index position
-void RingBuffer::writeSample(int channel, int index, float sample)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::writeSample(int channel, int index, SampleType sample)
 {
     int thisIdx = (mWriteIdx + index) % mBufSize;
     
     mBuffer.setSample(channel, thisIdx, sample);
 }
 
-void RingBuffer::read(juce::AudioBuffer<float>& destBuf)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::read(juce::AudioBuffer<SampleType>& destBuf)
 {
     int numChannels, destBufSize;
     
@@ -102,7 +118,8 @@ void RingBuffer::read(juce::AudioBuffer<float>& destBuf)
 }
 
 // TODO: assumes mBuffer and destBuf have the same number of channels
-void RingBuffer::read(juce::AudioBuffer<float>& destBuf, int delaySamps)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::read(juce::AudioBuffer<SampleType>& destBuf, int delaySamps)
 {
     int numChannels, destBufSize;
     
@@ -128,7 +145,8 @@ void RingBuffer::read(juce::AudioBuffer<float>& destBuf, int delaySamps)
     }
 }
 
-void RingBuffer::read(int sourceChannel, int delaySamps, juce::AudioBuffer<float>& destBuf, int destChannel, int numSamps)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::read(int sourceChannel, int delaySamps, juce::AudioBuffer<SampleType>& destBuf, int destChannel, int numSamps)
 {
 //    int destBufSize = destBuf.getNumSamples();
     
@@ -150,7 +168,8 @@ void RingBuffer::read(int sourceChannel, int delaySamps, juce::AudioBuffer<float
 
 // this can be used if you don't want to guarantee a read index that's at least one host block size behind the write index.
 // if used with writeNoAdvance, this can be used to achieve the lowest latency
-void RingBuffer::readUnsafe(int sourceChannel, int delaySamps, juce::AudioBuffer<float>& destBuf, int destChannel, int numSamps)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::readUnsafe(int sourceChannel, int delaySamps, juce::AudioBuffer<SampleType>& destBuf, int destChannel, int numSamps)
 {
 //    int destBufSize = destBuf.getNumSamples();
     
@@ -171,7 +190,8 @@ void RingBuffer::readUnsafe(int sourceChannel, int delaySamps, juce::AudioBuffer
 }
 
 // TODO: assumes mBuffer and destBuf have the same number of channels
-void RingBuffer::readInterp(juce::AudioBuffer<float>& destBuf, double delaySamps)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::readInterp(juce::AudioBuffer<SampleType>& destBuf, double delaySamps)
 {
     int numChannels, destBufSize;
     
@@ -201,7 +221,8 @@ void RingBuffer::readInterp(juce::AudioBuffer<float>& destBuf, double delaySamps
     }
 }
 
-void RingBuffer::readInterp(int sourceChannel, double delaySamps, juce::AudioBuffer<float>& destBuf, int destChannel, int numSamps)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::readInterp(int sourceChannel, double delaySamps, juce::AudioBuffer<SampleType>& destBuf, int destChannel, int numSamps)
 {
 //    int destBufSize = destBuf.getNumSamples();
     
@@ -226,12 +247,12 @@ void RingBuffer::readInterp(int sourceChannel, double delaySamps, juce::AudioBuf
 }
 
 // pass in the channel number and destination buffer sample number along with the fractional delay time
-double RingBuffer::readInterpSample(int channel, int samp, double delaySamps)
+template <typename SampleType>
+SampleType BasicRingBuffer<SampleType>::readInterpSample(int channel, int samp, double delaySamps)
 //double RingBuffer::readInterpSamp(int channel, double delaySamps)
 {
-    double outSamp, readIdx;
-    
-    outSamp = 0.0f;
+    SampleType outSamp;
+    double readIdx;
     
     // calculate a safe readIdx
     // read start point should be mOwnerBlockSize samples behind the write index at a minimum
@@ -251,11 +272,11 @@ double RingBuffer::readInterpSample(int channel, int samp, double delaySamps)
     return outSamp;
 }
 
-double RingBuffer::readInterpSample(int channel, double sampInc, double* lastReadIdx)
+template <typename SampleType>
+SampleType BasicRingBuffer<SampleType>::readInterpSample(int channel, double sampInc, double* lastReadIdx)
 {
-    double outSamp, readIdx;
-    
-    outSamp = 0.0f;
+    SampleType outSamp;
+    double readIdx;
     
     // calculate a safe readIdx
     // read start point should be mOwnerBlockSize samples behind the write index at a minimum
@@ -281,36 +302,46 @@ double RingBuffer::readInterpSample(int channel, double sampInc, double* lastRea
     return outSamp;
 }
 
-int RingBuffer::getWriteIdx()
+template <typename SampleType>
+int BasicRingBuffer<SampleType>::getWriteIdx()
 {
     return mWriteIdx;
 }
 
 // call this at the end of a block
-void RingBuffer::advanceWriteIdx(int N)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::advanceWriteIdx(int N)
 {
     // advance mRingBufWriteIdx at the end of the processBlock call
     mWriteIdx += N;
     // wrap at mRingBufSize
     mWriteIdx = mWriteIdx % mBufSize;
+
+    // the block is final now, so the sliding window statistics can take it in
+    for(auto* stats : mStats)
+        stats->samplesWritten(N);
 }
 
-int RingBuffer::getOwnerBlockSize()
+template <typename SampleType>
+int BasicRingBuffer<SampleType>::getOwnerBlockSize()
 {
     return mOwnerBlockSize;
 }
 
-void RingBuffer::setOwnerBlockSize(int N)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::setOwnerBlockSize(int N)
 {
     mOwnerBlockSize = N;
 }
 
-int RingBuffer::getSize()
+template <typename SampleType>
+int BasicRingBuffer<SampleType>::getSize()
 {
     return mBufSize;
 }
 
-void RingBuffer::setSize(int numChan, int numSamps, int ownerBlockSize)
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::setSize(int numChan, int numSamps, int ownerBlockSize)
 {
     double thisSize;
     
@@ -325,9 +356,16 @@ void RingBuffer::setSize(int numChan, int numSamps, int ownerBlockSize)
     thisSize *= mOwnerBlockSize;
     
     mBufSize = thisSize;
+
+    // attached stats sized themselves for the old channels and length, and would read past the new buffer. cut them loose until they're prepare()d again
+    for(auto* stats : mStats)
+        stats->ringResized();
+
+    mStats.clearQuick();
     
-    // do the acutal AudioBuffer resize
-    mBuffer.setSize(mNumChan, mBufSize);
+    // do the acutal AudioBuffer resize, from the arena if there's one with room. resizing again reuses the same arena memory while it's big enough
+    if(mArena == nullptr || !mArena->allocateBuffer(mBuffer, mArenaReservation, mNumChan, mBufSize))
+        mBuffer.setSize(mNumChan, mBufSize);
     
     if(mDebugFlag)
     {
@@ -336,19 +374,45 @@ void RingBuffer::setSize(int numChan, int numSamps, int ownerBlockSize)
     }
 }
 
-const float* RingBuffer::getReadPointer(int channel)
+template <typename SampleType>
+const SampleType* BasicRingBuffer<SampleType>::getReadPointer(int channel)
 {
     return mBuffer.getReadPointer(channel);
 }
 
-float* RingBuffer::getWritePointer(int channel)
+template <typename SampleType>
+SampleType* BasicRingBuffer<SampleType>::getWritePointer(int channel)
 {
     return mBuffer.getWritePointer(channel);
 }
 
-const juce::AudioBuffer<float>& RingBuffer::getBufRef()
+template <typename SampleType>
+const juce::AudioBuffer<SampleType>& BasicRingBuffer<SampleType>::getBufRef()
 {
     return mBuffer;
 }
 
+// SlidingWindowStats::prepare() calls this, so there's usually no need to. allocates, so not from the audio thread
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::addStats(SlidingWindowStats* stats)
+{
+    mStats.addIfNotAlreadyThere(stats);
+}
+
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::removeStats(SlidingWindowStats* stats)
+{
+    mStats.removeFirstMatchingValue(stats);
+}
+
+// the next setSize() carves the buffer from arena instead of the heap. pass nullptr to go back to the heap. call from prepareToPlay(), before setSize()
+template <typename SampleType>
+void BasicRingBuffer<SampleType>::setArena(AudioArena* arena)
+{
+    mArena = arena;
+}
+
+// the two sample types processBlock() comes in
+template class BasicRingBuffer<float>;
+template class BasicRingBuffer<double>;
 } // namespace atec
@@ -1,40 +1,50 @@
 /*
 
+    TEMPLATING:
+    - BasicRingBuffer is templated on the sample type, so a float signal path stays float end to end (including the interpolated reads) and a double one stays double
+    - RingBuffer is the float version, which is what everything else in the module uses. use BasicRingBuffer<double> for hosts that call processBlock() with AudioBuffer<double>
+    - only float RingBuffers can have SlidingWindowStats attached
+
  */
 
 #ifndef RING_BUFFER_H
 #define RING_BUFFER_H
 
+#include "atec_AudioArena.h"
+
 namespace atec
 {
     #define RINGBUFDEFAULTOWNERBLOCKSIZE 1024
     #define RINGBUFDEFAULTSIZE 32768
     #define RINGBUFDEFAULTCHAN 2
 
-    class RingBuffer
+    class SlidingWindowStats;
+
+    template <typename SampleType>
+    class BasicRingBuffer
     {
     public:
-        RingBuffer();
-        ~RingBuffer();
+        BasicRingBuffer();
+        ~BasicRingBuffer();
 
         // TODO: too many overloaded functions here. need to pick a design and commit to it
         void debug(bool d);
         void init();
-        void write(juce::AudioBuffer<float>& inBuf, bool advance = true);
+        void write(juce::AudioBuffer<SampleType>& inBuf, bool advance = true);
         // overload write() method so we can write to a specific channel
-        void write(int destChannel, juce::AudioBuffer<float>& sourceBuf, int sourceChannel, int numSamps, bool advance = true);
-        void writeSample(int channel, int writeIdx, float sample);
+        void write(int destChannel, juce::AudioBuffer<SampleType>& sourceBuf, int sourceChannel, int numSamps, bool advance = true);
+        void writeSample(int channel, int writeIdx, SampleType sample);
         
-        void read(juce::AudioBuffer<float>& destBuf);
-        void read(juce::AudioBuffer<float>& destBuf, int delaySamps);
+        void read(juce::AudioBuffer<SampleType>& destBuf);
+        void read(juce::AudioBuffer<SampleType>& destBuf, int delaySamps);
         // overload read() method so we can read from a specific channel
-        void read(int sourceChannel, int delaySamps, juce::AudioBuffer<float>& destBuf, int destChannel, int numSamps);
-        void readUnsafe(int sourceChannel, int delaySamps, juce::AudioBuffer<float>& destBuf, int destChannel, int numSamps);
+        void read(int sourceChannel, int delaySamps, juce::AudioBuffer<SampleType>& destBuf, int destChannel, int numSamps);
+        void readUnsafe(int sourceChannel, int delaySamps, juce::AudioBuffer<SampleType>& destBuf, int destChannel, int numSamps);
 
-        void readInterp(juce::AudioBuffer<float>& destBuf, double delaySamps);
-        void readInterp(int sourceChannel, double delaySamps, juce::AudioBuffer<float>& destBuf, int destChannel, int numSamps);
-        double readInterpSample(int channel, int samp, double delaySamps);
-        double readInterpSample(int channel, double sampInc, double* lastReadIdx);
+        void readInterp(juce::AudioBuffer<SampleType>& destBuf, double delaySamps);
+        void readInterp(int sourceChannel, double delaySamps, juce::AudioBuffer<SampleType>& destBuf, int destChannel, int numSamps);
+        SampleType readInterpSample(int channel, int samp, double delaySamps);
+        SampleType readInterpSample(int channel, double sampInc, double* lastReadIdx);
 
         int getWriteIdx();
         void advanceWriteIdx(int blockSize);
@@ -42,20 +52,30 @@ namespace atec
         void setOwnerBlockSize(int N);
         int getSize();
         void setSize(int numChan, int numSamps, int ownerBlockSize);
-        const float* getReadPointer(int channel);
-        float* getWritePointer(int channel);
-        const juce::AudioBuffer<float>& getBufRef();
+        const SampleType* getReadPointer(int channel);
+        SampleType* getWritePointer(int channel);
+        const juce::AudioBuffer<SampleType>& getBufRef();
+        void addStats(SlidingWindowStats* stats);
+        void removeStats(SlidingWindowStats* stats);
+        void setArena(AudioArena* arena);
 
     private:
 
-        juce::AudioBuffer<float> mBuffer;
+        juce::AudioBuffer<SampleType> mBuffer;
         int mOwnerBlockSize;
         int mBufSize;
         int mNumChan;
         int mWriteIdx;
+        // updated with every sample that advanceWriteIdx() moves past
+        juce::Array<SlidingWindowStats*> mStats;
+        // where setSize() carves mBuffer from, if anywhere
+        AudioArena* mArena;
+        AudioArena::Reservation mArenaReservation;
         bool mDebugFlag;
 
     };
+
+    using RingBuffer = BasicRingBuffer<float>;
 } // namespace atec
 
 #endif
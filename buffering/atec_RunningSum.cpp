@@ -0,0 +1,57 @@
+namespace atec
+{
+RunningSum::RunningSum()
+{
+    mDebugFlag = false;
+
+    mSum = 0.0;
+    mFreshSum = 0.0;
+    mFreshCount = 0;
+}
+
+RunningSum::~RunningSum()
+{
+    // nothing allocated, so nothing to delete
+}
+
+void RunningSum::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// start over from an exactly known sum of the current window
+void RunningSum::reset(double sum)
+{
+    mSum = sum;
+    mFreshSum = 0.0;
+    mFreshCount = 0;
+}
+
+// numSamps samples summing to in came into the window, and the numSamps summing to out left it
+void RunningSum::add(double in, double out, int numSamps, int windowSize)
+{
+    jassert(numSamps <= windowSize - mFreshCount); // the stretch runs past the resync point
+
+    mSum += in - out;
+    mFreshSum += in;
+    mFreshCount += numSamps;
+
+    if(mFreshCount >= windowSize)
+    {
+        mSum = mFreshSum;
+        mFreshSum = 0.0;
+        mFreshCount = 0;
+    }
+}
+
+// the longest stretch add() can take next
+int RunningSum::getRoomBeforeResync(int windowSize) const
+{
+    return windowSize - mFreshCount;
+}
+
+double RunningSum::getSum() const
+{
+    return mSum;
+}
+} // namespace atec
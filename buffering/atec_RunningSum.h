@@ -0,0 +1,41 @@
+/*
+
+    A running sum over a sliding window that doesn't drift.
+
+    Adding what comes into the window and subtracting what goes out is O(1), but the rounding error piles up forever. So a second, fresh sum only ever adds. Once it's seen a whole window length it holds exactly the current window, and it replaces the running sum and starts over. The drift never gets older than one window, without ever paying for an O(window) recompute.
+
+    SlidingWindowStats uses one per channel for its sum of squares, and LookaheadLimiter one per channel group for its moving average of the gain.
+
+    NOTE:
+    - add() takes a whole stretch of samples at once, as the sum of what came in and the sum of what went out. a stretch can't run past the next resync, so keep it to getRoomBeforeResync() samples
+    - reset() after the window size changes, with the sum of the new window
+
+ */
+
+#ifndef RUNNING_SUM_H
+#define RUNNING_SUM_H
+
+namespace atec
+{
+    class RunningSum
+    {
+    public:
+        RunningSum();
+        ~RunningSum();
+
+        void debug(bool d);
+        void reset(double sum);
+        void add(double in, double out, int numSamps, int windowSize);
+        int getRoomBeforeResync(int windowSize) const;
+        double getSum() const;
+
+    private:
+        double mSum;
+        // only ever added to, since the last resync
+        double mFreshSum;
+        int mFreshCount;
+        bool mDebugFlag;
+    };
+} // namespace atec
+
+#endif
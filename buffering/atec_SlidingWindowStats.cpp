@@ -0,0 +1,264 @@
+namespace atec
+{
+SlidingWindowStats::SlidingWindowStats()
+{
+    mDebugFlag = false;
+
+    mRingBuf = nullptr;
+    mSamplesWritten = 0;
+    mStatisticFlags = allStatistics;
+    mNumChannels = 0;
+    mRingSize = 0;
+    mCapacity = 0;
+    mWindowSize = SLIDINGSTATSDEFAULTWINDOW;
+
+    if(mDebugFlag)
+        DBG("SlidingWindowStats constructor called");
+}
+
+SlidingWindowStats::~SlidingWindowStats()
+{
+    detach();
+
+    if(mDebugFlag)
+        DBG("SlidingWindowStats destructor called");
+}
+
+void SlidingWindowStats::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// attaches to ringBuf, sized for its current size and channels. call from prepareToPlay(), after the RingBuffer's setSize()
+void SlidingWindowStats::prepare(RingBuffer& ringBuf, int windowSize)
+{
+    detach();
+
+    mRingBuf = &ringBuf;
+    mNumChannels = mRingBuf->getBufRef().getNumChannels();
+    mRingSize = mRingBuf->getSize();
+    mCapacity = juce::jmax(1, mRingSize - mRingBuf->getOwnerBlockSize());
+    mWindowSize = juce::jlimit(1, mCapacity, windowSize);
+
+    mSums.resize(mNumChannels);
+    mDequeValues.allocate((size_t)mNumChannels * 2 * mCapacity, true);
+    mDequeIndices.allocate((size_t)mNumChannels * 2 * mCapacity, true);
+    mDeques.resize(mNumChannels * 2);
+
+    for(int i = 0; i < mNumChannels * 2; i++)
+        mDeques.getReference(i).setStorage(mDequeValues.get() + (size_t)i * mCapacity, mDequeIndices.get() + (size_t)i * mCapacity, mCapacity);
+
+    mSamplesWritten = 0;
+    rebuild();
+
+    mRingBuf->addStats(this);
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "SlidingWindowStats prepare. mWindowSize: " + std::to_string(mWindowSize) + ", mCapacity: " + std::to_string(mCapacity);
+        DBG(post);
+    }
+}
+
+// stop getting updates from the RingBuffer
+void SlidingWindowStats::detach()
+{
+    if(mRingBuf != nullptr)
+        mRingBuf->removeStats(this);
+
+    mRingBuf = nullptr;
+}
+
+// RingBuffer::setSize() calls this, then forgets about us. everything cached in prepare() is for the old size, so stop updating until prepare() is called again
+void SlidingWindowStats::ringResized()
+{
+    mRingBuf = nullptr;
+}
+
+// RingBuffer::init() calls this when it clears the history
+void SlidingWindowStats::init()
+{
+    mSamplesWritten = 0;
+    rebuild();
+}
+
+// called by RingBuffer::advanceWriteIdx() with the number of samples it just moved past
+void SlidingWindowStats::samplesWritten(int numSamps)
+{
+    int start = mRingBuf->getWriteIdx() - numSamps;
+
+    jassert(numSamps + mWindowSize <= mRingSize); // the samples leaving the window have been overwritten already
+
+    start += (start < 0) ? mRingSize : 0;
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        const float* ringPtr = mRingBuf->getReadPointer(channel);
+
+        if((mStatisticFlags & rms) != 0)
+        {
+            RunningSum& sum = mSums.getReference(channel);
+            int done = 0;
+
+            // in stretches that end where the running sum resyncs, so each stretch is two plain sums
+            while(done < numSamps)
+            {
+                int stretch = juce::jmin(numSamps - done, sum.getRoomBeforeResync(mWindowSize));
+
+                sum.add(sumOfSquares(ringPtr, start + done, stretch), sumOfSquares(ringPtr, start + done - mWindowSize, stretch), stretch, mWindowSize);
+                done += stretch;
+            }
+        }
+
+        if((mStatisticFlags & minMax) != 0)
+        {
+            MonotonicDeque& maxDeque = mDeques.getReference(channel);
+            MonotonicDeque& minDeque = mDeques.getReference(mNumChannels + channel);
+            int idx = start;
+
+            for(int samp = 0; samp < numSamps; samp++)
+            {
+                maxDeque.push(ringPtr[idx], mSamplesWritten + samp, mWindowSize);
+                minDeque.push(-ringPtr[idx], mSamplesWritten + samp, mWindowSize);
+
+                idx++;
+                idx = (idx == mRingSize) ? 0 : idx;
+            }
+        }
+    }
+
+    mSamplesWritten += numSamps;
+}
+
+// any combination of the Statistic flags. turning one on rebuilds it from the history, so do that from the audio thread
+void SlidingWindowStats::setStatistics(int statisticFlags)
+{
+    int turnedOn = statisticFlags & ~mStatisticFlags;
+
+    mStatisticFlags = statisticFlags;
+
+    if(turnedOn != 0 && mRingBuf != nullptr)
+        rebuild();
+}
+
+int SlidingWindowStats::getStatistics()
+{
+    return mStatisticFlags;
+}
+
+// in samples, up to getCapacity(). O(window), so call it from the audio thread, between blocks
+void SlidingWindowStats::setWindowSize(int windowSize)
+{
+    mWindowSize = juce::jlimit(1, juce::jmax(1, mCapacity), windowSize);
+
+    if(mRingBuf != nullptr)
+        rebuild();
+}
+
+int SlidingWindowStats::getWindowSize()
+{
+    return mWindowSize;
+}
+
+// the longest window the attached RingBuffer can hold
+int SlidingWindowStats::getCapacity()
+{
+    return mCapacity;
+}
+
+float SlidingWindowStats::getRms(int channel)
+{
+    // the running sum can go a hair under 0 in silence
+    return (float)std::sqrt(juce::jmax(0.0, mSums.getReference(channel).getSum()) / mWindowSize);
+}
+
+// the largest absolute value in the window
+float SlidingWindowStats::getPeak(int channel)
+{
+    return juce::jmax(getMax(channel), -getMin(channel));
+}
+
+float SlidingWindowStats::getMin(int channel)
+{
+    return -getDequeMax(mDeques.getReference(mNumChannels + channel));
+}
+
+float SlidingWindowStats::getMax(int channel)
+{
+    return getDequeMax(mDeques.getReference(channel));
+}
+
+// everything from scratch, from the last mWindowSize samples in the ring buffer
+void SlidingWindowStats::rebuild()
+{
+    int windowStart = mRingBuf->getWriteIdx() - mWindowSize;
+    int numRecent = (int)juce::jmin((juce::int64)mWindowSize, mSamplesWritten);
+
+    windowStart += (windowStart < 0) ? mRingSize : 0;
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        const float* ringPtr = mRingBuf->getReadPointer(channel);
+        MonotonicDeque& maxDeque = mDeques.getReference(channel);
+        MonotonicDeque& minDeque = mDeques.getReference(mNumChannels + channel);
+        int idx = windowStart + (mWindowSize - numRecent);
+
+        mSums.getReference(channel).reset(sumOfSquares(ringPtr, windowStart, mWindowSize));
+        maxDeque.clear();
+        minDeque.clear();
+
+        // only the samples that were really written. the silence before them is accounted for in getDequeMax()
+        for(int samp = 0; samp < numRecent; samp++)
+        {
+            idx -= (idx >= mRingSize) ? mRingSize : 0;
+
+            maxDeque.push(ringPtr[idx], mSamplesWritten - numRecent + samp, mWindowSize);
+            minDeque.push(-ringPtr[idx], mSamplesWritten - numRecent + samp, mWindowSize);
+
+            idx++;
+        }
+    }
+}
+
+float SlidingWindowStats::getDequeMax(const MonotonicDeque& deque)
+{
+    if(deque.isEmpty())
+        return 0.0f;
+
+    // the ring buffer's initial silence is still in the window
+    if(mSamplesWritten < mWindowSize)
+        return juce::jmax(deque.getMax(), 0.0f);
+
+    return deque.getMax();
+}
+
+// sum of squares over numSamps ring buffer samples from start, which can be negative or wrap past the end
+double SlidingWindowStats::sumOfSquares(const float* ringPtr, int start, int numSamps)
+{
+    int firstPart;
+
+    start += (start < 0) ? mRingSize : 0;
+    start -= (start >= mRingSize) ? mRingSize : 0;
+    firstPart = juce::jmin(numSamps, mRingSize - start);
+
+    return sumOfSquares(ringPtr + start, firstPart) + sumOfSquares(ringPtr, numSamps - firstPart);
+}
+
+// one straight run of samples. a single double accumulator is a serial chain the compiler isn't allowed to reorder, so keep 8 partial sums like Utilities::dotProduct() does
+double SlidingWindowStats::sumOfSquares(const float* samples, int numSamps)
+{
+    double sums[8] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    int numWhole = numSamps & ~7;
+    double tail = 0.0;
+
+    for(int i = 0; i < numWhole; i += 8)
+        for(int j = 0; j < 8; j++)
+            sums[j] += (double)samples[i + j] * samples[i + j];
+
+    for(int i = numWhole; i < numSamps; i++)
+        tail += (double)samples[i] * samples[i];
+
+    return (((sums[0] + sums[4]) + (sums[1] + sums[5])) + ((sums[2] + sums[6]) + (sums[3] + sums[7]))) + tail;
+}
+} // namespace atec
@@ -0,0 +1,80 @@
+/*
+
+    RMS, peak, min and max over a sliding window of a RingBuffer's history, kept up to date as samples are written instead of recomputed over the whole window every block.
+
+    Once prepare()d, the RingBuffer tells this object about every block its advanceWriteIdx() moves past. Each new sample comes in and the sample a window length before it, which is still in the ring buffer, goes out:
+    - RMS is a RunningSum of squares, which replaces itself every window length with a sum that only ever adds, so rounding error doesn't pile up. The squares are summed a whole stretch of samples at a time, with partial sums so the loops vectorize
+    - min and max are MonotonicDeques, O(1) per sample on average. the min deque is a max deque on negated samples
+    So the cost per sample is the same for any window length up to capacity.
+
+    NOTE:
+    - the window can be up to the RingBuffer's size minus its owner block size (getCapacity()), since the samples leaving the window have to still be in the ring buffer
+    - results describe the window ending at the RingBuffer's write index, as of the last advanceWriteIdx()
+    - until a full window has been written, the window includes the silence the ring buffer started out with
+    - prepare() again after RingBuffer::setSize(). setSize() detaches this object, so until then the results stay where they were and nothing reads the resized buffer. the RingBuffer has to outlive this object, so declare it first
+    - setWindowSize() rebuilds everything from the ring buffer history, which costs O(window) once
+
+ */
+
+#include "atec_RingBuffer.h"
+#include "atec_MonotonicDeque.h"
+#include "atec_RunningSum.h"
+
+namespace atec
+{
+    #define SLIDINGSTATSDEFAULTWINDOW 4800
+
+    class SlidingWindowStats
+    {
+    public:
+        enum Statistic
+        {
+            rms = 1,
+            minMax = 2,
+            allStatistics = 3
+        };
+
+        SlidingWindowStats();
+        ~SlidingWindowStats();
+
+        void debug(bool d);
+        void prepare(RingBuffer& ringBuf, int windowSize);
+        void detach();
+        void ringResized();
+        void init();
+        void samplesWritten(int numSamps);
+        void setStatistics(int statisticFlags);
+        int getStatistics();
+        void setWindowSize(int windowSize);
+        int getWindowSize();
+        int getCapacity();
+        float getRms(int channel);
+        float getPeak(int channel);
+        float getMin(int channel);
+        float getMax(int channel);
+
+    private:
+        void rebuild();
+        float getDequeMax(const MonotonicDeque& deque);
+        double sumOfSquares(const float* ringPtr, int start, int numSamps);
+        static double sumOfSquares(const float* samples, int numSamps);
+
+        RingBuffer* mRingBuf;
+
+        // sum of squares, one per channel
+        juce::Array<RunningSum> mSums;
+
+        // storage for all the deques, capacity entries each. max deques are 0 to numChannels-1, min deques after them
+        juce::HeapBlock<float> mDequeValues;
+        juce::HeapBlock<juce::int64> mDequeIndices;
+        juce::Array<MonotonicDeque> mDeques;
+
+        juce::int64 mSamplesWritten;
+        int mStatisticFlags;
+        int mNumChannels;
+        int mRingSize;
+        int mCapacity;
+        int mWindowSize;
+        bool mDebugFlag;
+    };
+} // namespace atec
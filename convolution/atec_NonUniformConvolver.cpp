@@ -0,0 +1,355 @@
+namespace atec
+{
+NonUniformConvolver::Worker::Worker(NonUniformConvolver& owner, TailSegment& segment) : juce::Thread("atec NonUniformConvolver"), mOwner(owner), mSegment(segment)
+{
+}
+
+void NonUniformConvolver::Worker::run()
+{
+    int idleSpins = 0;
+
+    // catch up on every submitted block, then check back for the next one. nothing signals us, so after a few yields this just polls mNumSubmittedBlocks
+    while(!threadShouldExit())
+    {
+        if(mOwner.processTailBlock(mSegment))
+            idleSpins = 0;
+        else if(idleSpins < NONUNIFORMIDLESPINS)
+        {
+            idleSpins++;
+            juce::Thread::yield();
+        }
+        else
+            wait(NONUNIFORMIDLEWAITMS);
+    }
+}
+
+NonUniformConvolver::NonUniformConvolver() : mNumSubmittedBlocks(0), mNumMissedDeadlines(0)
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+    mHeadConv.debug(mDebugFlag);
+
+    mSampleCount = 0;
+    mNumChannels = 0;
+    mHeadPartitionSize = NONUNIFORMDEFAULTHEADPARTITIONSIZE;
+    mTailPartitionSize = NONUNIFORMDEFAULTTAILPARTITIONSIZE;
+    mMaxBlockSize = 0;
+    mNumTailThreads = NONUNIFORMDEFAULTTAILTHREADS;
+
+    if(mDebugFlag)
+        DBG("NonUniformConvolver constructor called");
+}
+
+NonUniformConvolver::~NonUniformConvolver()
+{
+    release();
+
+    if(mDebugFlag)
+        DBG("NonUniformConvolver destructor called");
+}
+
+void NonUniformConvolver::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the head convolver and the tail's input/output staging come from arena at the next prepare(). each tail segment's buffers belong to its worker thread and stay on the heap
+void NonUniformConvolver::setArena(AudioArena* arena)
+{
+    mArena = arena;
+    mHeadConv.setArena(arena);
+}
+
+// call from prepareToPlay(). any IR that was loaded before has to be loaded again afterwards
+void NonUniformConvolver::prepare(int numChannels, int headPartitionSize, int tailPartitionSize, int maxBlockSize, int numTailThreads)
+{
+    jassert(juce::isPowerOfTwo(headPartitionSize) && juce::isPowerOfTwo(tailPartitionSize));
+    jassert(headPartitionSize < tailPartitionSize);
+    // the workers get roughly (tailPartitionSize + headPartitionSize - 2 * maxBlockSize) samples to finish each block
+    jassert(tailPartitionSize >= maxBlockSize * 2);
+
+    release();
+
+    mNumChannels = numChannels;
+    mHeadPartitionSize = headPartitionSize;
+    mTailPartitionSize = tailPartitionSize;
+    mMaxBlockSize = maxBlockSize;
+    mNumTailThreads = juce::jmax(1, numTailThreads);
+
+    mHeadConv.prepare(mNumChannels, mHeadPartitionSize, mMaxBlockSize);
+
+    AudioArena::setBufferSize(mArena, mTailInputBuf, mTailInputReservation, mNumChannels, mTailPartitionSize * NONUNIFORMTAILSLOTS);
+    // a tail block is picked up at most one host block before it's due, and is tailPartitionSize long
+    AudioArena::setBufferSize(mArena, mTailOutputBuf, mTailOutputReservation, mNumChannels, mTailPartitionSize + (mMaxBlockSize * 2));
+
+    // no IR yet
+    mTailSegments.clear();
+
+    init();
+}
+
+// splits the IR into head and tail segments and starts the tail workers. allocates, so never call from the audio thread
+void NonUniformConvolver::loadImpulseResponse(const juce::AudioBuffer<float>& ir)
+{
+    int headLength = mTailPartitionSize * 2;
+    int tailLength = ir.getNumSamples() - headLength;
+    int numTailPartitions;
+    int numSegments;
+
+    release();
+    mTailSegments.clear();
+
+    mHeadConv.loadImpulseResponse(ir, 0, juce::jmin(headLength, ir.getNumSamples()));
+
+    if(tailLength > 0)
+    {
+        numTailPartitions = (tailLength + mTailPartitionSize - 1) / mTailPartitionSize;
+        numSegments = juce::jmin(mNumTailThreads, numTailPartitions);
+
+        for(int i = 0; i < numSegments; i++)
+        {
+            auto* segment = new TailSegment();
+
+            // spread the partitions as evenly as possible. later segments have more slack, but the same amount of work
+            int firstPartition = (i * numTailPartitions) / numSegments;
+            int lastPartition = ((i + 1) * numTailPartitions) / numSegments;
+
+            segment->irOffset = firstPartition * mTailPartitionSize;
+            // later segments are due later, so their results have to wait around for longer
+            segment->numSlots = NONUNIFORMTAILSLOTS + firstPartition;
+            segment->nextJob = 0;
+            segment->nextCollect = 0;
+
+            segment->conv.prepare(mNumChannels, mTailPartitionSize, mTailPartitionSize);
+            segment->conv.loadImpulseResponse(ir, headLength + segment->irOffset, juce::jmin((lastPartition - firstPartition) * mTailPartitionSize, tailLength - segment->irOffset));
+
+            segment->scratch.setSize(mNumChannels, mTailPartitionSize);
+            segment->results.setSize(mNumChannels, mTailPartitionSize * segment->numSlots);
+            segment->slotBlocks.reset(new std::atomic<juce::int64>[segment->numSlots]);
+            segment->worker.reset(new Worker(*this, *segment));
+
+            mTailSegments.add(segment);
+        }
+    }
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "NonUniformConvolver IR loaded. head partitions: " + std::to_string(mHeadConv.getNumPartitions()) + ", tail segments: " + std::to_string(mTailSegments.size());
+        DBG(post);
+    }
+}
+
+// stops the tail workers. prepare() or loadImpulseResponse() start them again
+void NonUniformConvolver::release()
+{
+    stopWorkers();
+}
+
+// clear all history without touching the IR. restarts the tail workers, so never call from the audio thread
+void NonUniformConvolver::init()
+{
+    stopWorkers();
+
+    mHeadConv.init();
+    mTailInputBuf.clear();
+    mTailOutputBuf.clear();
+
+    for(auto* segment : mTailSegments)
+    {
+        segment->conv.init();
+        segment->nextJob = 0;
+        segment->nextCollect = 0;
+        segment->results.clear();
+
+        for(int slot = 0; slot < segment->numSlots; slot++)
+            segment->slotBlocks[slot].store(-1);
+    }
+
+    mNumSubmittedBlocks.store(0);
+    mNumMissedDeadlines.store(0);
+    mSampleCount = 0;
+
+    startWorkers();
+}
+
+// convolve in place. buffer can be any size up to the maxBlockSize given to prepare()
+void NonUniformConvolver::process(juce::AudioBuffer<float>& buffer)
+{
+    int numSamps = buffer.getNumSamples();
+    int inSize = mTailInputBuf.getNumSamples();
+    int outSize = mTailOutputBuf.getNumSamples();
+    int inIdx = (int)(mSampleCount % inSize);
+    int outIdx = (int)(mSampleCount % outSize);
+    juce::int64 blockEnd = mSampleCount + numSamps;
+    juce::int64 numCompleteBlocks = blockEnd / mTailPartitionSize;
+
+    jassert(numSamps <= mMaxBlockSize);
+
+    if(mTailSegments.size() > 0)
+    {
+        // the tail needs the dry input, so copy it out before the head overwrites it
+        for(int channel = 0; channel < mNumChannels; channel++)
+        {
+            int firstSamps = juce::jmin(numSamps, inSize - inIdx);
+
+            mTailInputBuf.copyFrom(channel, inIdx, buffer, channel, 0, firstSamps);
+            if(firstSamps < numSamps)
+                mTailInputBuf.copyFrom(channel, 0, buffer, channel, firstSamps, numSamps - firstSamps);
+        }
+
+        // a tail block is ready as soon as its last sample is in. the workers pick it up from the count on their own, since notify() would lock a mutex in here
+        if(numCompleteBlocks > mNumSubmittedBlocks.load())
+            mNumSubmittedBlocks.store(numCompleteBlocks);
+    }
+
+    mHeadConv.process(buffer);
+
+    if(mTailSegments.size() == 0)
+    {
+        mSampleCount = blockEnd;
+        return;
+    }
+
+    // pick up every tail block that's due somewhere in this block
+    for(auto* segment : mTailSegments)
+    {
+        juce::int64 tailDelay = mHeadPartitionSize + (mTailPartitionSize * 2) + segment->irOffset;
+
+        while((segment->nextCollect * mTailPartitionSize) + tailDelay < blockEnd)
+            collectTailBlock(*segment);
+    }
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        int firstSamps = juce::jmin(numSamps, outSize - outIdx);
+
+        buffer.addFrom(channel, 0, mTailOutputBuf, channel, outIdx, firstSamps);
+        mTailOutputBuf.clear(channel, outIdx, firstSamps);
+
+        if(firstSamps < numSamps)
+        {
+            buffer.addFrom(channel, firstSamps, mTailOutputBuf, channel, 0, numSamps - firstSamps);
+            mTailOutputBuf.clear(channel, 0, numSamps - firstSamps);
+        }
+    }
+
+    mSampleCount = blockEnd;
+}
+
+// audio thread: add the segment's next result into the output ring where it's due, or drop it if the worker hasn't finished
+void NonUniformConvolver::collectTailBlock(TailSegment& segment)
+{
+    juce::int64 block = segment.nextCollect;
+    int slot = (int)(block % segment.numSlots);
+    int outSize = mTailOutputBuf.getNumSamples();
+    int outIdx = (int)(((block * mTailPartitionSize) + mHeadPartitionSize + (mTailPartitionSize * 2) + segment.irOffset) % outSize);
+
+    segment.nextCollect++;
+
+    if(segment.slotBlocks[slot].load(std::memory_order_acquire) != block)
+    {
+        mNumMissedDeadlines++;
+        return;
+    }
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        const float* resultPtr = segment.results.getReadPointer(channel, slot * mTailPartitionSize);
+        int firstSamps = juce::jmin(mTailPartitionSize, outSize - outIdx);
+
+        mTailOutputBuf.addFrom(channel, outIdx, resultPtr, firstSamps);
+        if(firstSamps < mTailPartitionSize)
+            mTailOutputBuf.addFrom(channel, 0, resultPtr + firstSamps, mTailPartitionSize - firstSamps);
+    }
+}
+
+// worker thread: convolve the segment's next submitted block, if there is one
+bool NonUniformConvolver::processTailBlock(TailSegment& segment)
+{
+    juce::int64 numSubmitted = mNumSubmittedBlocks.load();
+    juce::int64 block;
+    int inSlot;
+    int slot;
+
+    if(segment.nextJob >= numSubmitted)
+        return false;
+
+    // the audio thread is about to overwrite this block's input, so start over at the newest block. clearing the history
+    // gives a short gap in the tail instead of echoes in the wrong place
+    if(numSubmitted - segment.nextJob >= NONUNIFORMTAILSLOTS - 1)
+    {
+        segment.nextJob = numSubmitted - 1;
+        segment.conv.init();
+    }
+
+    block = segment.nextJob;
+    inSlot = (int)(block % NONUNIFORMTAILSLOTS);
+    slot = (int)(block % segment.numSlots);
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+        segment.scratch.copyFrom(channel, 0, mTailInputBuf, channel, inSlot * mTailPartitionSize, mTailPartitionSize);
+
+    // with host blocks shorter than a tail partition, the audio thread only writes into block (numSubmitted + 1) and up.
+    // if that reached this block while we were copying, the input is torn, so convolve silence to keep the history in step
+    if(mNumSubmittedBlocks.load() - block >= NONUNIFORMTAILSLOTS - 1)
+        segment.scratch.clear();
+
+    segment.conv.processAligned(segment.scratch);
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+        segment.results.copyFrom(channel, slot * mTailPartitionSize, segment.scratch, channel, 0, mTailPartitionSize);
+
+    segment.slotBlocks[slot].store(block, std::memory_order_release);
+    segment.nextJob++;
+
+    return true;
+}
+
+void NonUniformConvolver::stopWorkers()
+{
+    for(auto* segment : mTailSegments)
+        segment->worker->signalThreadShouldExit();
+
+    for(auto* segment : mTailSegments)
+        segment->worker->stopThread(1000);
+}
+
+void NonUniformConvolver::startWorkers()
+{
+    for(auto* segment : mTailSegments)
+        segment->worker->startThread();
+}
+
+int NonUniformConvolver::getLatencySamples()
+{
+    return mHeadPartitionSize;
+}
+
+int NonUniformConvolver::getHeadPartitionSize()
+{
+    return mHeadPartitionSize;
+}
+
+int NonUniformConvolver::getTailPartitionSize()
+{
+    return mTailPartitionSize;
+}
+
+int NonUniformConvolver::getNumTailSegments()
+{
+    return mTailSegments.size();
+}
+
+int NonUniformConvolver::getNumMissedDeadlines()
+{
+    return mNumMissedDeadlines.load();
+}
+
+void NonUniformConvolver::resetNumMissedDeadlines()
+{
+    mNumMissedDeadlines.store(0);
+}
+} // namespace atec
@@ -0,0 +1,112 @@
+/*
+
+    Non-uniformly partitioned convolution (Gardner style), for multi-second IRs at low latency.
+
+    The IR is split into a head and a tail:
+    - head: IR[0, 2 * tailPartitionSize), run by a UniformConvolver with the small headPartitionSize on the audio thread. that sets the latency
+    - tail: everything after that, run by UniformConvolvers with the large tailPartitionSize on background threads. with more than one tail thread, the tail is split into consecutive segments, one per thread
+
+    Tail blocks are handed over lock-free. The audio thread writes input into a shared ring and bumps an atomic block count, without waking anyone. The workers poll that count. Each worker convolves every new block with processAligned() and tags the result slot with the block number once it's done. Since the head covers the first 2 * tailPartitionSize samples of the IR, a tail block isn't due at the output until roughly a tail partition after it was submitted. That's the deadline the workers have to meet, so the heavy FFTs never run in the audio callback.
+
+    If a tail result isn't ready by the time it's due, the audio thread drops it (the tail goes quiet for that block) and bumps getNumMissedDeadlines(). A worker that falls far enough behind clears its history and jumps back in at the newest block, instead of convolving stale or half-overwritten input.
+
+    NOTE:
+    - both partition sizes must be powers of 2, and tailPartitionSize should be at least 2 * maxBlockSize, or the workers won't have any time left
+    - prepare(), loadImpulseResponse() and init() start and stop the worker threads, so never call them from the audio thread
+    - latency is headPartitionSize (see getLatencySamples())
+
+ */
+
+#include "atec_UniformConvolver.h"
+
+namespace atec
+{
+    #define NONUNIFORMDEFAULTHEADPARTITIONSIZE 128
+    #define NONUNIFORMDEFAULTTAILPARTITIONSIZE 2048
+    #define NONUNIFORMDEFAULTTAILTHREADS 1
+    // how many tail blocks of input/results are buffered between the audio thread and the workers
+    #define NONUNIFORMTAILSLOTS 4
+    // idle workers poll for new blocks at this rate, which comes out of their deadline
+    #define NONUNIFORMIDLEWAITMS 1
+    // yields before an idle worker falls back to polling
+    #define NONUNIFORMIDLESPINS 64
+
+    class NonUniformConvolver
+    {
+    public:
+        NonUniformConvolver();
+        ~NonUniformConvolver();
+
+        void debug(bool d);
+        void prepare(int numChannels, int headPartitionSize, int tailPartitionSize, int maxBlockSize, int numTailThreads);
+        void setArena(AudioArena* arena);
+        void loadImpulseResponse(const juce::AudioBuffer<float>& ir);
+        void release();
+        void init();
+        void process(juce::AudioBuffer<float>& buffer);
+        int getLatencySamples();
+        int getHeadPartitionSize();
+        int getTailPartitionSize();
+        int getNumTailSegments();
+        int getNumMissedDeadlines();
+        void resetNumMissedDeadlines();
+
+    private:
+        struct TailSegment;
+
+        class Worker : public juce::Thread
+        {
+        public:
+            Worker(NonUniformConvolver& owner, TailSegment& segment);
+            void run() override;
+
+        private:
+            NonUniformConvolver& mOwner;
+            TailSegment& mSegment;
+        };
+
+        struct TailSegment
+        {
+            UniformConvolver conv;
+            // where this segment starts, relative to the start of the tail
+            int irOffset;
+            // worker side: the next block to convolve
+            juce::int64 nextJob;
+            // audio side: the next block to pick up
+            juce::int64 nextCollect;
+            juce::AudioBuffer<float> scratch;
+            // numSlots blocks of tailPartitionSize samples
+            int numSlots;
+            juce::AudioBuffer<float> results;
+            // the block number each result slot holds, or -1
+            std::unique_ptr<std::atomic<juce::int64>[]> slotBlocks;
+            std::unique_ptr<Worker> worker;
+        };
+
+        bool processTailBlock(TailSegment& segment);
+        void stopWorkers();
+        void startWorkers();
+        void collectTailBlock(TailSegment& segment);
+
+        UniformConvolver mHeadConv;
+        juce::OwnedArray<TailSegment> mTailSegments;
+        // the last NONUNIFORMTAILSLOTS tail blocks of input, shared by every worker
+        juce::AudioBuffer<float> mTailInputBuf;
+        // tail results, indexed by output sample count, waiting to be mixed in
+        juce::AudioBuffer<float> mTailOutputBuf;
+
+        std::atomic<juce::int64> mNumSubmittedBlocks;
+        std::atomic<int> mNumMissedDeadlines;
+        juce::int64 mSampleCount;
+        int mNumChannels;
+        int mHeadPartitionSize;
+        int mTailPartitionSize;
+        int mMaxBlockSize;
+        int mNumTailThreads;
+        // for the head and the tail staging buffers
+        AudioArena* mArena;
+        AudioArena::Reservation mTailInputReservation;
+        AudioArena::Reservation mTailOutputReservation;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,313 @@
+namespace atec
+{
+UniformConvolver::UniformConvolver()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+    mInputBuf.debug(mDebugFlag);
+
+    mNumChannels = 0;
+    mNumIrChannels = 0;
+    mPartitionSize = CONVOLVERDEFAULTPARTITIONSIZE;
+    mNumBins = mPartitionSize + 1;
+    mNumPartitions = 0;
+    mFdlIdx = 0;
+    mMaxBlockSize = 0;
+    mSampleCount = 0;
+    mNextPartitionEnd = mPartitionSize;
+
+    if(mDebugFlag)
+        DBG("UniformConvolver constructor called");
+}
+
+UniformConvolver::~UniformConvolver()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("UniformConvolver destructor called");
+}
+
+void UniformConvolver::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// input history, FFT scratch and output accumulator from arena, starting with the next prepare(). nullptr for the heap
+void UniformConvolver::setArena(AudioArena* arena)
+{
+    mArena = arena;
+    mInputBuf.setArena(arena);
+}
+
+// call from prepareToPlay(). any IR that was loaded before has to be loaded again afterwards
+void UniformConvolver::prepare(int numChannels, int partitionSize, int maxBlockSize)
+{
+    jassert(juce::isPowerOfTwo(partitionSize));
+
+    mNumChannels = numChannels;
+    mPartitionSize = partitionSize;
+    mMaxBlockSize = maxBlockSize;
+
+    // real-only transforms of 2 * mPartitionSize samples give mPartitionSize + 1 unique bins
+    mNumBins = mPartitionSize + 1;
+    mFFT.reset(new juce::dsp::FFT((int)std::log2(mPartitionSize * 2)));
+
+    // each partition needs the newest 2 * mPartitionSize input samples, and the newest partition can end up to a block before the write index
+    mInputBuf.setSize(mNumChannels, (mPartitionSize * 2) + (mMaxBlockSize * 2), mMaxBlockSize);
+
+    // juce::dsp::FFT wants 2 * fftSize floats to work in
+    AudioArena::setBufferSize(mArena, mFftBuf, mFftReservation, 1, mPartitionSize * 4);
+
+    // each partition writes mPartitionSize samples ahead of the block being read, so leave room for both
+    AudioArena::setBufferSize(mArena, mOutputBuf, mOutputReservation, mNumChannels, (mPartitionSize * 2) + mMaxBlockSize);
+
+    mAcc.allocate((size_t)(mNumBins * 2), true);
+
+    // no IR yet
+    mNumIrChannels = 0;
+    mNumPartitions = 0;
+    mIrSpectra.free();
+    mFdl.free();
+
+    init();
+}
+
+// transform each partition of the IR. irNumSamples of -1 means everything from irStartSample to the end
+void UniformConvolver::loadImpulseResponse(const juce::AudioBuffer<float>& ir, int irStartSample, int irNumSamples)
+{
+    jassert(mFFT != nullptr); // call prepare() first
+
+    if(irNumSamples < 0)
+        irNumSamples = ir.getNumSamples() - irStartSample;
+
+    irNumSamples = juce::jmax(0, juce::jmin(irNumSamples, ir.getNumSamples() - irStartSample));
+
+    mNumIrChannels = juce::jmax(1, ir.getNumChannels());
+    mNumPartitions = juce::jmax(1, (irNumSamples + mPartitionSize - 1) / mPartitionSize);
+
+    mIrSpectra.allocate((size_t)(mNumIrChannels * mNumPartitions * mNumBins * 2), true);
+    mFdl.allocate((size_t)(mNumChannels * mNumPartitions * mNumBins * 2), true);
+
+    for(int channel = 0; channel < ir.getNumChannels(); channel++)
+    {
+        for(int partition = 0; partition < mNumPartitions; partition++)
+        {
+            float* fftPtr = mFftBuf.getWritePointer(0);
+            float* spec = getIrSpectrum(channel, partition);
+            int startIdx = partition * mPartitionSize;
+            int numSamps = juce::jmin(mPartitionSize, irNumSamples - startIdx);
+
+            // each IR partition is zero-padded to the full 2 * mPartitionSize transform size
+            mFftBuf.clear();
+            if(numSamps > 0)
+                juce::FloatVectorOperations::copy(fftPtr, ir.getReadPointer(channel, irStartSample + startIdx), numSamps);
+
+            mFFT->performRealOnlyForwardTransform(fftPtr, true);
+
+            for(int bin = 0; bin < mNumBins; bin++)
+            {
+                spec[bin] = fftPtr[bin * 2];
+                spec[mNumBins + bin] = fftPtr[(bin * 2) + 1];
+            }
+        }
+    }
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "UniformConvolver IR loaded. partitions: " + std::to_string(mNumPartitions) + ", mPartitionSize: " + std::to_string(mPartitionSize);
+        DBG(post);
+    }
+}
+
+// clear all history without touching the IR
+void UniformConvolver::init()
+{
+    mInputBuf.init();
+    mOutputBuf.clear();
+
+    if(mFdl != nullptr)
+        juce::FloatVectorOperations::clear(mFdl.get(), mNumChannels * mNumPartitions * mNumBins * 2);
+
+    mFdlIdx = 0;
+    mSampleCount = 0;
+    mNextPartitionEnd = mPartitionSize;
+}
+
+// convolve in place. buffer can be any size up to the maxBlockSize given to prepare()
+void UniformConvolver::process(juce::AudioBuffer<float>& buffer)
+{
+    int numSamps = buffer.getNumSamples();
+    juce::int64 blockEnd;
+
+    jassert(numSamps <= mMaxBlockSize);
+
+    if(mNumPartitions == 0)
+    {
+        buffer.clear();
+        return;
+    }
+
+    mInputBuf.write(buffer);
+
+    blockEnd = mSampleCount + numSamps;
+
+    // partitions end on multiples of mPartitionSize, which can fall anywhere inside a host block
+    while(mNextPartitionEnd <= blockEnd)
+    {
+        processPartition((int)(blockEnd - mNextPartitionEnd));
+        mNextPartitionEnd += mPartitionSize;
+    }
+
+    // every output sample for this block has been written by now, mPartitionSize samples after the input it belongs to
+    readOutputBuf(buffer, mSampleCount);
+
+    mSampleCount = blockEnd;
+}
+
+// convolve exactly one partition in place, with no latency. buffer must be mPartitionSize samples, and this can't be mixed with process()
+// each call completes a partition, so its result can be read straight back out instead of waiting a partition for a host block to catch up
+void UniformConvolver::processAligned(juce::AudioBuffer<float>& buffer)
+{
+    jassert(buffer.getNumSamples() == mPartitionSize);
+    jassert(mSampleCount + mPartitionSize == mNextPartitionEnd);
+
+    if(mNumPartitions == 0)
+    {
+        buffer.clear();
+        return;
+    }
+
+    mInputBuf.write(buffer);
+
+    processPartition(0);
+    readOutputBuf(buffer, mNextPartitionEnd);
+
+    mNextPartitionEnd += mPartitionSize;
+    mSampleCount += mPartitionSize;
+}
+
+// one overlap-save step for the partition that ends delaySamps samples before the newest input sample
+void UniformConvolver::processPartition(int delaySamps)
+{
+    int outSize = mOutputBuf.getNumSamples();
+    int writeIdx = (int)(mNextPartitionEnd % outSize);
+    float* fftPtr = mFftBuf.getWritePointer(0);
+    float* accRe = mAcc.get();
+    float* accIm = mAcc.get() + mNumBins;
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        int irChannel = juce::jmin(channel, mNumIrChannels - 1);
+        float* fdlSpec = getFdlSpectrum(channel, mFdlIdx);
+
+        // the newest 2 * mPartitionSize input samples
+        mInputBuf.readUnsafe(channel, (mPartitionSize * 2) + delaySamps, mFftBuf, 0, mPartitionSize * 2);
+        mFFT->performRealOnlyForwardTransform(fftPtr, true);
+
+        // split into real and imaginary parts in the newest FDL slot
+        for(int bin = 0; bin < mNumBins; bin++)
+        {
+            fdlSpec[bin] = fftPtr[bin * 2];
+            fdlSpec[mNumBins + bin] = fftPtr[(bin * 2) + 1];
+        }
+
+        juce::FloatVectorOperations::clear(accRe, mNumBins * 2);
+
+        // IR partition j lines up with the input spectrum from j partitions ago
+        for(int partition = 0; partition < mNumPartitions; partition++)
+        {
+            int slot = mFdlIdx - partition;
+            const float* xSpec;
+            const float* hSpec;
+
+            if(slot < 0)
+                slot += mNumPartitions;
+
+            xSpec = getFdlSpectrum(channel, slot);
+            hSpec = getIrSpectrum(irChannel, partition);
+
+            complexMultiplyAccumulate(accRe, accIm, xSpec, xSpec + mNumBins, hSpec, hSpec + mNumBins, mNumBins);
+        }
+
+        for(int bin = 0; bin < mNumBins; bin++)
+        {
+            fftPtr[bin * 2] = accRe[bin];
+            fftPtr[(bin * 2) + 1] = accIm[bin];
+        }
+
+        mFFT->performRealOnlyInverseTransform(fftPtr);
+
+        // overlap-save: only the second half is free of circular wraparound
+        if(writeIdx + mPartitionSize <= outSize)
+            mOutputBuf.copyFrom(channel, writeIdx, fftPtr + mPartitionSize, mPartitionSize);
+        else
+        {
+            int firstSamps = outSize - writeIdx;
+
+            mOutputBuf.copyFrom(channel, writeIdx, fftPtr + mPartitionSize, firstSamps);
+            mOutputBuf.copyFrom(channel, 0, fftPtr + mPartitionSize + firstSamps, mPartitionSize - firstSamps);
+        }
+    }
+
+    // the newest slot becomes the oldest next time around
+    mFdlIdx = (mFdlIdx + 1) % mNumPartitions;
+}
+
+// copy buffer.getNumSamples() samples out of the output ring, starting at sample count startSample
+void UniformConvolver::readOutputBuf(juce::AudioBuffer<float>& buffer, juce::int64 startSample)
+{
+    int numSamps = buffer.getNumSamples();
+    int outSize = mOutputBuf.getNumSamples();
+    int readIdx = (int)(startSample % outSize);
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        if(readIdx + numSamps <= outSize)
+            buffer.copyFrom(channel, 0, mOutputBuf, channel, readIdx, numSamps);
+        else
+        {
+            int firstSamps = outSize - readIdx;
+
+            buffer.copyFrom(channel, 0, mOutputBuf, channel, readIdx, firstSamps);
+            buffer.copyFrom(channel, firstSamps, mOutputBuf, channel, 0, numSamps - firstSamps);
+        }
+    }
+}
+
+void UniformConvolver::complexMultiplyAccumulate(float* accRe, float* accIm, const float* xRe, const float* xIm, const float* hRe, const float* hIm, int numBins)
+{
+    // (a + bi)(c + di) = (ac - bd) + (ad + bc)i
+    juce::FloatVectorOperations::addWithMultiply(accRe, xRe, hRe, numBins);
+    juce::FloatVectorOperations::subtractWithMultiply(accRe, xIm, hIm, numBins);
+    juce::FloatVectorOperations::addWithMultiply(accIm, xRe, hIm, numBins);
+    juce::FloatVectorOperations::addWithMultiply(accIm, xIm, hRe, numBins);
+}
+
+float* UniformConvolver::getIrSpectrum(int channel, int partition)
+{
+    return mIrSpectra.get() + ((size_t)((channel * mNumPartitions) + partition) * (size_t)(mNumBins * 2));
+}
+
+float* UniformConvolver::getFdlSpectrum(int channel, int slot)
+{
+    return mFdl.get() + ((size_t)((channel * mNumPartitions) + slot) * (size_t)(mNumBins * 2));
+}
+
+int UniformConvolver::getLatencySamples()
+{
+    return mPartitionSize;
+}
+
+int UniformConvolver::getPartitionSize()
+{
+    return mPartitionSize;
+}
+
+int UniformConvolver::getNumPartitions()
+{
+    return mNumPartitions;
+}
+} // namespace atec
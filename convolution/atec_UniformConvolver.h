@@ -0,0 +1,77 @@
+/*
+
+    Uniformly partitioned overlap-save FFT convolution, for long impulse responses (reverbs, cabinet sims).
+
+    The IR is cut into partitions of partitionSize samples, and each one is transformed once in loadImpulseResponse(). Input history lives in a RingBuffer. Every partitionSize input samples, the newest 2 * partitionSize samples are transformed once and pushed into a frequency-domain delay line (FDL). The output partition is then one complex multiply-accumulate per IR partition, followed by a single inverse FFT. So the FFT work per block doesn't depend on the IR length. Only the MAC grows with it, and that runs through juce::FloatVectorOperations on split real/imaginary arrays.
+
+    Latency is exactly partitionSize samples (see getLatencySamples()), no matter what block size the host uses. If the caller always hands over exactly one partition at a time, processAligned() gets rid of that latency too.
+
+    NOTE:
+    - partitionSize must be a power of 2
+    - loadImpulseResponse() allocates, so call it from prepareToPlay() or while the convolver isn't processing
+    - a mono IR is used for every channel. otherwise channel n uses IR channel n (or the last IR channel if there are fewer)
+
+ */
+
+#ifndef UNIFORM_CONVOLVER_H
+#define UNIFORM_CONVOLVER_H
+
+#include "../buffering/atec_RingBuffer.h"
+
+namespace atec
+{
+    #define CONVOLVERDEFAULTPARTITIONSIZE 512
+
+    class UniformConvolver
+    {
+    public:
+        UniformConvolver();
+        ~UniformConvolver();
+
+        void debug(bool d);
+        void prepare(int numChannels, int partitionSize, int maxBlockSize);
+        void setArena(AudioArena* arena);
+        void loadImpulseResponse(const juce::AudioBuffer<float>& ir, int irStartSample = 0, int irNumSamples = -1);
+        void init();
+        void process(juce::AudioBuffer<float>& buffer);
+        void processAligned(juce::AudioBuffer<float>& buffer);
+        int getLatencySamples();
+        int getPartitionSize();
+        int getNumPartitions();
+
+        // the frequency-domain complex multiply-accumulate, on split real/imaginary arrays: acc += x * h
+        static void complexMultiplyAccumulate(float* accRe, float* accIm, const float* xRe, const float* xIm, const float* hRe, const float* hIm, int numBins);
+
+    private:
+        void processPartition(int delaySamps);
+        void readOutputBuf(juce::AudioBuffer<float>& buffer, juce::int64 startSample);
+        float* getIrSpectrum(int channel, int partition);
+        float* getFdlSpectrum(int channel, int slot);
+
+        std::unique_ptr<juce::dsp::FFT> mFFT;
+        RingBuffer mInputBuf;
+        juce::AudioBuffer<float> mFftBuf;
+        juce::AudioBuffer<float> mOutputBuf;
+        // every spectrum is stored as numBins real parts followed by numBins imaginary parts
+        juce::HeapBlock<float> mIrSpectra;
+        juce::HeapBlock<float> mFdl;
+        juce::HeapBlock<float> mAcc;
+
+        juce::int64 mSampleCount;
+        juce::int64 mNextPartitionEnd;
+        int mNumChannels;
+        int mNumIrChannels;
+        int mPartitionSize;
+        int mNumBins;
+        int mNumPartitions;
+        int mFdlIdx;
+        int mMaxBlockSize;
+        // set by setArena(), with what each buffer got from it
+        AudioArena* mArena;
+        AudioArena::Reservation mFftReservation;
+        AudioArena::Reservation mOutputReservation;
+        bool mDebugFlag;
+    };
+} // namespace atec
+
+#endif
@@ -0,0 +1,313 @@
+namespace atec
+{
+template <typename SampleType>
+BasicDopplerPitchShifter<SampleType>::BasicDopplerPitchShifter()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+    mRingBuf.debug(mDebugFlag);
+
+    mSampleRate = 48000.0;
+    mTranspo = 0.0;
+    mWindowMs = DOPPLERDEFAULTWINDOWMS;
+    mMaxWindowMs = DOPPLERDEFAULTWINDOWMS;
+    mSmoothingMs = DOPPLERDEFAULTSMOOTHMS;
+    mPhasor = 0.0;
+    mPhaseIncCurrent = 0.0f;
+    mPhaseIncTarget = 0.0f;
+    mPhaseIncStep = 0.0f;
+    mWindowSampsCurrent = 0.0f;
+    mWindowSampsTarget = 0.0f;
+    mWindowSampsStep = 0.0f;
+    mRampSampsLeft = 0;
+    mNumTaps = DOPPLERDEFAULTNUMTAPS;
+    mNumChannels = 0;
+    mMaxBlockSize = 0;
+
+    if(mDebugFlag)
+        DBG("DopplerPitchShifter constructor called");
+}
+
+template <typename SampleType>
+BasicDopplerPitchShifter<SampleType>::~BasicDopplerPitchShifter()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("DopplerPitchShifter destructor called");
+}
+
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// delay line and wet buffer from arena. takes effect at the next prepare(), nullptr for the heap
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::setArena(AudioArena* arena)
+{
+    mArena = arena;
+    mRingBuf.setArena(arena);
+}
+
+// call from prepareToPlay(). maxWindowMs is the largest window setWindowMs() will accept
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::prepare(double sampleRate, int numChannels, int maxBlockSize, double maxWindowMs)
+{
+    int maxWindowSamps;
+
+    mSampleRate = sampleRate;
+    mNumChannels = numChannels;
+    mMaxBlockSize = maxBlockSize;
+    mMaxWindowMs = maxWindowMs;
+    mWindowMs = juce::jmin(mWindowMs, mMaxWindowMs);
+
+    // the longest delay, plus the block being written and the cubic's neighbors on either side. setSize() rounds down to whole blocks, so ask for one more
+    maxWindowSamps = (int)std::ceil(mMaxWindowMs * 0.001 * mSampleRate);
+    mRingBuf.setSize(mNumChannels, maxWindowSamps + (int)DOPPLERMINDELAYSAMPS + (2 * mMaxBlockSize) + 4, mMaxBlockSize);
+
+    mPhaseInc.allocate((size_t)mMaxBlockSize, true);
+    mWindowSamps.allocate((size_t)mMaxBlockSize, true);
+    mPhase.allocate((size_t)mMaxBlockSize, true);
+    mTapGain.allocate((size_t)mMaxBlockSize, true);
+    mReadIdx.allocate((size_t)mMaxBlockSize, true);
+    mMu.allocate((size_t)mMaxBlockSize, true);
+    mY0.allocate((size_t)mMaxBlockSize, true);
+    mY1.allocate((size_t)mMaxBlockSize, true);
+    mY2.allocate((size_t)mMaxBlockSize, true);
+    mY3.allocate((size_t)mMaxBlockSize, true);
+    AudioArena::setBufferSize(mArena, mWetBuf, mWetReservation, mNumChannels, mMaxBlockSize);
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "DopplerPitchShifter prepare. ring buffer size: " + std::to_string(mRingBuf.getSize());
+        DBG(post);
+    }
+}
+
+// clear the delay line and jump straight to the current settings
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::init()
+{
+    mRingBuf.init();
+
+    mPhasor = 0.0;
+    startRamp();
+    mPhaseIncCurrent = mPhaseIncTarget;
+    mWindowSampsCurrent = mWindowSampsTarget;
+    mRampSampsLeft = 0;
+}
+
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::process(juce::AudioBuffer<SampleType>& buffer)
+{
+    int numSamps = buffer.getNumSamples();
+    int ringSize = mRingBuf.getSize();
+    int writeIdx = mRingBuf.getWriteIdx();
+    float tapNorm = 2.0f / (float)mNumTaps;
+    double phase = mPhasor;
+
+    float* phaseInc = mPhaseInc.get();
+    float* windowSamps = mWindowSamps.get();
+    float* phasePtr = mPhase.get();
+    float* tapGain = mTapGain.get();
+    int* readIdx = mReadIdx.get();
+    SampleType* mu = mMu.get();
+    SampleType* y0 = mY0.get();
+    SampleType* y1 = mY1.get();
+    SampleType* y2 = mY2.get();
+    SampleType* y3 = mY3.get();
+
+    jassert(numSamps <= mMaxBlockSize);
+
+    // write first, so the shortest delay can read this block's own input
+    mRingBuf.write(buffer);
+
+    // phasor increment and window size for every sample, gliding toward their targets
+    if(mRampSampsLeft > 0)
+    {
+        int rampSamps = juce::jmin(mRampSampsLeft, numSamps);
+
+        for(int samp = 0; samp < rampSamps; samp++)
+        {
+            phaseInc[samp] = mPhaseIncCurrent + mPhaseIncStep * (float)(samp + 1);
+            windowSamps[samp] = mWindowSampsCurrent + mWindowSampsStep * (float)(samp + 1);
+        }
+
+        mRampSampsLeft -= rampSamps;
+
+        if(mRampSampsLeft == 0)
+        {
+            mPhaseIncCurrent = mPhaseIncTarget;
+            mWindowSampsCurrent = mWindowSampsTarget;
+        }
+        else
+        {
+            mPhaseIncCurrent = phaseInc[rampSamps - 1];
+            mWindowSampsCurrent = windowSamps[rampSamps - 1];
+        }
+
+        juce::FloatVectorOperations::fill(phaseInc + rampSamps, mPhaseIncCurrent, numSamps - rampSamps);
+        juce::FloatVectorOperations::fill(windowSamps + rampSamps, mWindowSampsCurrent, numSamps - rampSamps);
+    }
+    else
+    {
+        juce::FloatVectorOperations::fill(phaseInc, mPhaseIncCurrent, numSamps);
+        juce::FloatVectorOperations::fill(windowSamps, mWindowSampsCurrent, numSamps);
+    }
+
+    // the phasor itself is a running sum, so it's the one serial loop. it runs once per block, not once per tap per channel.
+    // the increment is always well under a cycle per sample, so wrapping never needs more than one step either way
+    for(int samp = 0; samp < numSamps; samp++)
+    {
+        phase += phaseInc[samp];
+        phase += (phase < 0.0) ? 1.0 : 0.0;
+        phase -= (phase >= 1.0) ? 1.0 : 0.0;
+        phasePtr[samp] = (float)phase;
+    }
+
+    mPhasor = phase;
+
+    mWetBuf.clear();
+
+    for(int tap = 0; tap < mNumTaps; tap++)
+    {
+        float tapOffset = (float)tap / (float)mNumTaps;
+
+        // this tap's phase, crossfade gain, and read position. the delay is split into whole samples and a fraction, so positions stay exact however large the ring buffer is.
+        // p is in [0, 2), so wrap it by truncating rather than with a float compare, which would keep the compiler from vectorizing the loop
+        for(int samp = 0; samp < numSamps; samp++)
+        {
+            float p = phasePtr[samp] + tapOffset;
+            float window, delay;
+            int wholeDelay, idx;
+
+            p -= (float)(int)p;
+            window = sinHalfCycle(p);
+            delay = (float)DOPPLERMINDELAYSAMPS + p * windowSamps[samp];
+            wholeDelay = (int)delay + 1;
+
+            idx = writeIdx + samp - wholeDelay;
+            idx = (idx < 0) ? idx + ringSize : idx;
+            idx = (idx >= ringSize) ? idx - ringSize : idx;
+
+            tapGain[samp] = window * window * tapNorm;
+            readIdx[samp] = idx;
+            mu[samp] = (SampleType)((float)wholeDelay - delay);
+        }
+
+        for(int channel = 0; channel < mNumChannels; channel++)
+        {
+            const SampleType* ringPtr = mRingBuf.getReadPointer(channel);
+            SampleType* wetPtr = mWetBuf.getWritePointer(channel);
+
+            // the only scalar part: four neighbors per read, wrapped at the ends of the ring buffer
+            for(int samp = 0; samp < numSamps; samp++)
+            {
+                int r1 = readIdx[samp];
+                int r0 = (r1 > 0) ? r1 - 1 : ringSize - 1;
+                int r2 = (r1 + 1 < ringSize) ? r1 + 1 : r1 + 1 - ringSize;
+                int r3 = (r1 + 2 < ringSize) ? r1 + 2 : r1 + 2 - ringSize;
+
+                y0[samp] = ringPtr[r0];
+                y1[samp] = ringPtr[r1];
+                y2[samp] = ringPtr[r2];
+                y3[samp] = ringPtr[r3];
+            }
+
+            // same cubic as Utilities::cubicInterpolate()
+            for(int samp = 0; samp < numSamps; samp++)
+            {
+                SampleType m = mu[samp];
+                SampleType m2 = m * m;
+                SampleType a0 = y3[samp] - y2[samp] - y0[samp] + y1[samp];
+                SampleType a1 = y0[samp] - y1[samp] - a0;
+                SampleType a2 = y2[samp] - y0[samp];
+
+                wetPtr[samp] += (a0 * m * m2 + a1 * m2 + a2 * m + y1[samp]) * tapGain[samp];
+            }
+        }
+    }
+
+    for(int channel = 0; channel < buffer.getNumChannels() && channel < mNumChannels; channel++)
+        buffer.copyFrom(channel, 0, mWetBuf, channel, 0, numSamps);
+}
+
+// in semitones. glides over the smoothing time
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::setTranspo(double transpo)
+{
+    mTranspo = transpo;
+    startRamp();
+}
+
+template <typename SampleType>
+double BasicDopplerPitchShifter<SampleType>::getTranspo()
+{
+    return mTranspo;
+}
+
+// longer windows give smoother shifting with more smearing and latency. glides over the smoothing time
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::setWindowMs(double ms)
+{
+    mWindowMs = juce::jlimit(1.0, mMaxWindowMs, ms);
+    startRamp();
+}
+
+template <typename SampleType>
+double BasicDopplerPitchShifter<SampleType>::getWindowMs()
+{
+    return mWindowMs;
+}
+
+// 2 to DOPPLERMAXTAPS. takes effect at the next block without smoothing, so don't change it while audio is running
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::setNumTaps(int numTaps)
+{
+    mNumTaps = juce::jlimit(2, DOPPLERMAXTAPS, numTaps);
+}
+
+template <typename SampleType>
+int BasicDopplerPitchShifter<SampleType>::getNumTaps()
+{
+    return mNumTaps;
+}
+
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::setSmoothingMs(double ms)
+{
+    mSmoothingMs = juce::jmax(0.0, ms);
+}
+
+// head toward the phasor increment and window size of the current settings over mSmoothingMs
+template <typename SampleType>
+void BasicDopplerPitchShifter<SampleType>::startRamp()
+{
+    int rampSamps = juce::jmax(1, (int)(mSmoothingMs * 0.001 * mSampleRate));
+
+    // transpo2freq() is in Hz, so divide down to cycles per sample
+    mPhaseIncTarget = (float)(Utilities::transpo2freq(mTranspo, mWindowMs) / mSampleRate);
+    mWindowSampsTarget = (float)(mWindowMs * 0.001 * mSampleRate);
+
+    mPhaseIncStep = (mPhaseIncTarget - mPhaseIncCurrent) / (float)rampSamps;
+    mWindowSampsStep = (mWindowSampsTarget - mWindowSampsCurrent) / (float)rampSamps;
+    mRampSampsLeft = rampSamps;
+}
+
+// sin(pi * phase) for phase in [0, 1], as cos() of the distance from the middle. a polynomial up to the 10th power is within 5e-7, and unlike std::sin() it vectorizes
+template <typename SampleType>
+float BasicDopplerPitchShifter<SampleType>::sinHalfCycle(float phase)
+{
+    float u = (phase - 0.5f) * juce::MathConstants<float>::pi;
+    float u2 = u * u;
+
+    return 1.0f + u2 * (-1.0f / 2.0f + u2 * (1.0f / 24.0f + u2 * (-1.0f / 720.0f + u2 * (1.0f / 40320.0f + u2 * (-1.0f / 3628800.0f)))));
+}
+// the two sample types processBlock() comes in
+template class BasicDopplerPitchShifter<float>;
+template class BasicDopplerPitchShifter<double>;
+} // namespace atec
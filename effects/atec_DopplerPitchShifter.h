@@ -0,0 +1,97 @@
+/*
+
+    Delay line pitch shifting (the "Doppler" method), processed a block at a time.
+
+    The hand-rolled version of this runs an LFO saw at Utilities::transpo2freq() and calls RingBuffer::readInterpSample() with phase * windowSize as the delay, once per tap per sample, then crossfades the taps. Every one of those calls redoes the write index math, a fmod() and a cubic read. This class does the same thing in block form:
+    - the phasor is accumulated once per block, then offset for each tap in a straight loop
+    - the crossfade window is a polynomial instead of a table or std::sin(), so it vectorizes too
+    - read positions are wrapped with a compare instead of fmod(). only gathering the four sample points is scalar, and the cubic is the same one as Utilities::cubicInterpolate()
+
+    Taps are spaced evenly around the phasor and windowed with sin^2, so any number of taps from 2 up sums to a constant gain. More taps means smoother output for inharmonic input, at the cost of more comb filtering.
+
+    NOTE:
+    - process() replaces the buffer contents with the shifted signal
+    - setTranspo() and setWindowMs() glide to their new values over the smoothing time instead of jumping, so there's no zipper noise or click in the delay
+    - the delay swings between DOPPLERMINDELAYSAMPS and the window size, so the average latency is about half the window
+
+    TEMPLATING:
+    - DopplerPitchShifter is the float version. BasicDopplerPitchShifter<double> is for processBlock(AudioBuffer<double>&)
+    - the delay line, the cubic reads and the tap sum are in SampleType. the phasor, tap gains and delay times are control signals, and stay float for both
+
+ */
+
+#include "../buffering/atec_RingBuffer.h"
+
+namespace atec
+{
+    #define DOPPLERDEFAULTWINDOWMS 50.0
+    #define DOPPLERDEFAULTSMOOTHMS 20.0
+    #define DOPPLERDEFAULTNUMTAPS 2
+    #define DOPPLERMAXTAPS 8
+    // the cubic read needs two samples after the read position, so never read closer than this to the newest input
+    #define DOPPLERMINDELAYSAMPS 3.0
+
+    template <typename SampleType>
+    class BasicDopplerPitchShifter
+    {
+    public:
+        BasicDopplerPitchShifter();
+        ~BasicDopplerPitchShifter();
+
+        void debug(bool d);
+        void prepare(double sampleRate, int numChannels, int maxBlockSize, double maxWindowMs);
+        void setArena(AudioArena* arena);
+        void init();
+        void process(juce::AudioBuffer<SampleType>& buffer);
+        void setTranspo(double transpo);
+        double getTranspo();
+        void setWindowMs(double ms);
+        double getWindowMs();
+        void setNumTaps(int numTaps);
+        int getNumTaps();
+        void setSmoothingMs(double ms);
+
+    private:
+        void startRamp();
+        static float sinHalfCycle(float phase);
+
+        BasicRingBuffer<SampleType> mRingBuf;
+
+        // per block scratch, one value per sample
+        juce::HeapBlock<float> mPhaseInc;
+        juce::HeapBlock<float> mWindowSamps;
+        juce::HeapBlock<float> mPhase;
+        juce::HeapBlock<float> mTapGain;
+        juce::HeapBlock<int> mReadIdx;
+        juce::HeapBlock<SampleType> mMu;
+        juce::HeapBlock<SampleType> mY0;
+        juce::HeapBlock<SampleType> mY1;
+        juce::HeapBlock<SampleType> mY2;
+        juce::HeapBlock<SampleType> mY3;
+        juce::AudioBuffer<SampleType> mWetBuf;
+
+        double mSampleRate;
+        double mTranspo;
+        double mWindowMs;
+        double mMaxWindowMs;
+        double mSmoothingMs;
+        double mPhasor;
+        // the current and target phasor increment (cycles per sample) and window size (samples), and the per sample steps between them
+        float mPhaseIncCurrent;
+        float mPhaseIncTarget;
+        float mPhaseIncStep;
+        float mWindowSampsCurrent;
+        float mWindowSampsTarget;
+        float mWindowSampsStep;
+        int mRampSampsLeft;
+        int mNumTaps;
+        int mNumChannels;
+        int mMaxBlockSize;
+        // set by setArena()
+        AudioArena* mArena;
+        AudioArena::Reservation mWetReservation;
+        bool mDebugFlag;
+    };
+
+    using DopplerPitchShifter = BasicDopplerPitchShifter<float>;
+} // namespace atec
@@ -0,0 +1,297 @@
+namespace atec
+{
+template <typename SampleType>
+BasicLookaheadLimiter<SampleType>::BasicLookaheadLimiter()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+    mRingBuf.debug(mDebugFlag);
+
+    mSamplesSeen = 0;
+    mHistIdx = 0;
+    mSampleRate = 48000.0;
+    mLookaheadMs = LIMITERDEFAULTLOOKAHEADMS;
+    mMaxLookaheadMs = LIMITERDEFAULTLOOKAHEADMS;
+    mThresholdDb = LIMITERDEFAULTTHRESHOLDDB;
+    mRatio = LIMITERMAXRATIO;
+    mReleaseMs = LIMITERDEFAULTRELEASEMS;
+    mThreshold = juce::Decibels::decibelsToGain((float)mThresholdDb);
+    mSlope = 1.0f;
+    mReleaseCoeff = 1.0f;
+    mGainReductionDb = 0.0f;
+    mLookahead = 0;
+    mWindowSize = 1;
+    mCapacity = 1;
+    mNumChannels = 0;
+    mMaxBlockSize = 0;
+    mLinked = true;
+
+    if(mDebugFlag)
+        DBG("LookaheadLimiter constructor called");
+}
+
+template <typename SampleType>
+BasicLookaheadLimiter<SampleType>::~BasicLookaheadLimiter()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("LookaheadLimiter destructor called");
+}
+
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the delay line and the gain buffer come from arena from the next prepare() on. the smaller per-channel state stays on the heap
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::setArena(AudioArena* arena)
+{
+    mArena = arena;
+    mRingBuf.setArena(arena);
+}
+
+// call from prepareToPlay(). maxLookaheadMs is the largest lookahead setLookaheadMs() will accept
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::prepare(double sampleRate, int numChannels, int maxBlockSize, double maxLookaheadMs)
+{
+    mSampleRate = sampleRate;
+    mNumChannels = numChannels;
+    mMaxBlockSize = maxBlockSize;
+    mMaxLookaheadMs = juce::jmax(0.0, maxLookaheadMs);
+    mCapacity = (int)std::ceil(mMaxLookaheadMs * 0.001 * mSampleRate) + 1;
+
+    // the longest delay plus the block being written. setSize() rounds down to whole blocks, so ask for one more
+    mRingBuf.setSize(mNumChannels, mCapacity + (2 * mMaxBlockSize), mMaxBlockSize);
+
+    mPeak.allocate((size_t)mMaxBlockSize, true);
+    mAbs.allocate((size_t)mMaxBlockSize, true);
+    AudioArena::setBufferSize(mArena, mGainBuf, mGainReservation, mNumChannels, mMaxBlockSize);
+
+    mDequeValues.allocate((size_t)mNumChannels * mCapacity, true);
+    mDequeIndices.allocate((size_t)mNumChannels * mCapacity, true);
+    mDeques.resize(mNumChannels);
+    mAverageHist.allocate((size_t)mNumChannels * mCapacity, true);
+    mAverageSums.resize(mNumChannels);
+    mEnvelopes.allocate((size_t)mNumChannels, true);
+
+    for(int group = 0; group < mNumChannels; group++)
+        mDeques.getReference(group).setStorage(mDequeValues.get() + (size_t)group * mCapacity, mDequeIndices.get() + (size_t)group * mCapacity, mCapacity);
+
+    setReleaseMs(mReleaseMs);
+    setLookaheadMs(mLookaheadMs);
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "LookaheadLimiter prepare. mCapacity: " + std::to_string(mCapacity) + ", ring buffer size: " + std::to_string(mRingBuf.getSize());
+        DBG(post);
+    }
+}
+
+// clear the delay line and the gain envelopes
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::init()
+{
+    mRingBuf.init();
+    resetEnvelopes();
+}
+
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::process(juce::AudioBuffer<SampleType>& buffer)
+{
+    int numSamps = buffer.getNumSamples();
+    int numGroups = mLinked ? 1 : mNumChannels;
+    float minGain = 1.0f;
+
+    jassert(numSamps <= mMaxBlockSize);
+    jassert(buffer.getNumChannels() == mNumChannels);
+
+    for(int group = 0; group < numGroups; group++)
+    {
+        SampleType* peak = mPeak.get();
+        SampleType* gain = mGainBuf.getWritePointer(group);
+
+        juce::FloatVectorOperations::abs(peak, buffer.getReadPointer(group), numSamps);
+
+        if(mLinked)
+        {
+            for(int channel = 1; channel < mNumChannels; channel++)
+            {
+                juce::FloatVectorOperations::abs(mAbs.get(), buffer.getReadPointer(channel), numSamps);
+                juce::FloatVectorOperations::max(peak, peak, mAbs.get(), numSamps);
+            }
+        }
+
+        computeGain(group, peak, gain, numSamps);
+        minGain = juce::jmin(minGain, (float)juce::FloatVectorOperations::findMinimum(gain, numSamps));
+    }
+
+    mSamplesSeen += numSamps;
+    mHistIdx = (mHistIdx + numSamps) % mWindowSize;
+
+    // delay the input by the lookahead, then apply the gain
+    mRingBuf.write(buffer);
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        mRingBuf.readUnsafe(channel, numSamps + mLookahead, buffer, channel, numSamps);
+        juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel), mGainBuf.getReadPointer(mLinked ? 0 : channel), numSamps);
+    }
+
+    mGainReductionDb.store(juce::Decibels::gainToDecibels(minGain), std::memory_order_relaxed);
+}
+
+// the gain for each sample of the block, to be applied mLookahead samples later. O(1) per sample.
+// the envelope is worked out in float whatever the sample type, since a gain doesn't need more than float's precision. only the delayed signal and the multiply are SampleType
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::computeGain(int group, const SampleType* peak, SampleType* gain, int numSamps)
+{
+    MonotonicDeque& deque = mDeques.getReference(group);
+    RunningSum& averageSum = mAverageSums.getReference(group);
+    float* averageHist = mAverageHist.get() + (size_t)group * mCapacity;
+    float envelope = mEnvelopes[group];
+    double norm = 1.0 / mWindowSize;
+    int histIdx = mHistIdx;
+
+    for(int samp = 0; samp < numSamps; samp++)
+    {
+        float windowPeak, target;
+
+        deque.push((float)peak[samp], mSamplesSeen + samp, mWindowSize);
+        windowPeak = deque.getMax();
+
+        // the gain that brings the window's peak down to the threshold, or only partway at lower ratios
+        if(windowPeak <= mThreshold)
+            target = 1.0f;
+        else if(mSlope >= 1.0f)
+            target = mThreshold / windowPeak;
+        else
+            target = std::pow(mThreshold / windowPeak, mSlope);
+
+        // instant attack, since the lookahead already gives it time. release glides back up
+        envelope = (target < envelope) ? target : envelope + (target - envelope) * mReleaseCoeff;
+
+        averageSum.add(envelope, averageHist[histIdx], 1, mWindowSize);
+        averageHist[histIdx] = envelope;
+        histIdx = (histIdx + 1 == mWindowSize) ? 0 : histIdx + 1;
+
+        gain[samp] = (SampleType)(averageSum.getSum() * norm);
+    }
+
+    mEnvelopes[group] = envelope;
+}
+
+// no gain reduction, and nothing in the lookahead window
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::resetEnvelopes()
+{
+    for(int group = 0; group < mNumChannels; group++)
+    {
+        mDeques.getReference(group).clear();
+        mAverageSums.getReference(group).reset((double)mWindowSize);
+        mEnvelopes[group] = 1.0f;
+
+        juce::FloatVectorOperations::fill(mAverageHist.get() + (size_t)group * mCapacity, 1.0f, mWindowSize);
+    }
+
+    mHistIdx = 0;
+    mGainReductionDb = 0.0f;
+}
+
+// up to the maxLookaheadMs given to prepare(). changes the latency and restarts the gain envelopes, so call it from the audio thread and tell the host
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::setLookaheadMs(double ms)
+{
+    mLookaheadMs = juce::jlimit(0.0, mMaxLookaheadMs, ms);
+    mLookahead = juce::jmin(mCapacity - 1, (int)std::round(mLookaheadMs * 0.001 * mSampleRate));
+    mWindowSize = mLookahead + 1;
+
+    if(mNumChannels > 0)
+        resetEnvelopes();
+}
+
+template <typename SampleType>
+double BasicLookaheadLimiter<SampleType>::getLookaheadMs()
+{
+    return mLookaheadMs;
+}
+
+template <typename SampleType>
+int BasicLookaheadLimiter<SampleType>::getLatencySamps()
+{
+    return mLookahead;
+}
+
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::setThresholdDb(double db)
+{
+    mThresholdDb = juce::jmin(0.0, db);
+    mThreshold = juce::Decibels::decibelsToGain((float)mThresholdDb);
+}
+
+template <typename SampleType>
+double BasicLookaheadLimiter<SampleType>::getThresholdDb()
+{
+    return mThresholdDb;
+}
+
+// 1 (no gain reduction) and up. LIMITERMAXRATIO and up is a brickwall
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::setRatio(double ratio)
+{
+    mRatio = juce::jmax(1.0, ratio);
+    mSlope = (mRatio >= LIMITERMAXRATIO) ? 1.0f : (float)(1.0 - 1.0 / mRatio);
+}
+
+template <typename SampleType>
+double BasicLookaheadLimiter<SampleType>::getRatio()
+{
+    return mRatio;
+}
+
+// the time constant of the gain coming back up after a peak
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::setReleaseMs(double ms)
+{
+    mReleaseMs = juce::jmax(0.0, ms);
+    mReleaseCoeff = (mReleaseMs > 0.0) ? (float)(1.0 - std::exp(-1.0 / (mReleaseMs * 0.001 * mSampleRate))) : 1.0f;
+}
+
+template <typename SampleType>
+double BasicLookaheadLimiter<SampleType>::getReleaseMs()
+{
+    return mReleaseMs;
+}
+
+// switching restarts the gain envelopes, since groups change
+template <typename SampleType>
+void BasicLookaheadLimiter<SampleType>::setLinked(bool linked)
+{
+    if(linked == mLinked)
+        return;
+
+    mLinked = linked;
+
+    if(mNumChannels > 0)
+        resetEnvelopes();
+}
+
+template <typename SampleType>
+bool BasicLookaheadLimiter<SampleType>::getLinked()
+{
+    return mLinked;
+}
+
+// the most gain reduction in the last block, as a negative number. safe to call from the GUI thread
+template <typename SampleType>
+float BasicLookaheadLimiter<SampleType>::getGainReductionDb()
+{
+    return mGainReductionDb.load(std::memory_order_relaxed);
+}
+// the two sample types processBlock() comes in
+template class BasicLookaheadLimiter<float>;
+template class BasicLookaheadLimiter<double>;
+} // namespace atec
@@ -0,0 +1,110 @@
+/*
+
+    Lookahead peak limiter/compressor. The input goes through a RingBuffer delay of the lookahead time, so the gain can start coming down before a peak gets to the output.
+
+    Per sample, for each linked group of channels:
+    - the peak is the largest absolute value across the group's channels, found with FloatVectorOperations a whole block at a time
+    - the largest peak over the lookahead window comes from a MonotonicDeque, O(1) per sample on average however long the lookahead is
+    - that peak sets the gain the window needs. the gain follows it down instantly and back up over the release time
+    - then a moving average over the same window smooths the gain, kept as a running sum. every value it averages is already at or below the gain needed by the sample leaving the window, so the output never goes over the threshold and the gain never steps
+    - gain is applied with one vector multiply per channel
+    So the per block cost depends on the block size and the number of channels, not on the lookahead.
+
+    The moving average is a RunningSum, the same as SlidingWindowStats' RMS, so rounding error doesn't pile up over a long session.
+
+    NOTE:
+    - latency is exactly getLatencySamps(), the lookahead in whole samples. report it to the host with setLatencySamples()
+    - setLookaheadMs() changes the latency, and restarts the gain envelope. setThresholdDb(), setRatio() and setReleaseMs() are safe any time
+    - ratio LIMITERMAXRATIO and up is a brickwall limiter. lower ratios compress peaks over the threshold instead
+    - linked, every channel gets the same gain, so the stereo image doesn't move. unlinked, each channel is limited on its own
+
+    TEMPLATING:
+    - LookaheadLimiter is the float version. use BasicLookaheadLimiter<double> from processBlock(AudioBuffer<double>&)
+    - the delay line and the gain multiply are in SampleType. the gain envelope itself is always float
+
+ */
+
+#include "../buffering/atec_RingBuffer.h"
+#include "../buffering/atec_MonotonicDeque.h"
+#include "../buffering/atec_RunningSum.h"
+
+namespace atec
+{
+    #define LIMITERDEFAULTLOOKAHEADMS 5.0
+    #define LIMITERDEFAULTRELEASEMS 100.0
+    #define LIMITERDEFAULTTHRESHOLDDB -1.0
+    #define LIMITERMAXRATIO 100.0
+
+    template <typename SampleType>
+    class BasicLookaheadLimiter
+    {
+    public:
+        BasicLookaheadLimiter();
+        ~BasicLookaheadLimiter();
+
+        void debug(bool d);
+        void prepare(double sampleRate, int numChannels, int maxBlockSize, double maxLookaheadMs);
+        void setArena(AudioArena* arena);
+        void init();
+        void process(juce::AudioBuffer<SampleType>& buffer);
+        void setLookaheadMs(double ms);
+        double getLookaheadMs();
+        int getLatencySamps();
+        void setThresholdDb(double db);
+        double getThresholdDb();
+        void setRatio(double ratio);
+        double getRatio();
+        void setReleaseMs(double ms);
+        double getReleaseMs();
+        void setLinked(bool linked);
+        bool getLinked();
+        float getGainReductionDb();
+
+    private:
+        void resetEnvelopes();
+        void computeGain(int group, const SampleType* peak, SampleType* gain, int numSamps);
+
+        BasicRingBuffer<SampleType> mRingBuf;
+
+        // per block scratch
+        juce::HeapBlock<SampleType> mPeak;
+        juce::HeapBlock<SampleType> mAbs;
+        juce::AudioBuffer<SampleType> mGainBuf;
+
+        // one of each per group, which is every channel unlinked or just the first one linked. the deques and moving average history have mCapacity entries each
+        juce::HeapBlock<float> mDequeValues;
+        juce::HeapBlock<juce::int64> mDequeIndices;
+        juce::Array<MonotonicDeque> mDeques;
+        juce::HeapBlock<float> mAverageHist;
+        juce::Array<RunningSum> mAverageSums;
+        juce::HeapBlock<float> mEnvelopes;
+
+        // shared by every group, since they all see the same samples
+        juce::int64 mSamplesSeen;
+        int mHistIdx;
+
+        double mSampleRate;
+        double mLookaheadMs;
+        double mMaxLookaheadMs;
+        double mThresholdDb;
+        double mRatio;
+        double mReleaseMs;
+        float mThreshold;
+        float mSlope;
+        float mReleaseCoeff;
+        std::atomic<float> mGainReductionDb;
+        // the lookahead in samples, and the window it takes to cover it, which is one more
+        int mLookahead;
+        int mWindowSize;
+        int mCapacity;
+        int mNumChannels;
+        int mMaxBlockSize;
+        bool mLinked;
+        // set by setArena(), carved from in prepare()
+        AudioArena* mArena;
+        AudioArena::Reservation mGainReservation;
+        bool mDebugFlag;
+    };
+
+    using LookaheadLimiter = BasicLookaheadLimiter<float>;
+} // namespace atec
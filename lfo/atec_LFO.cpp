@@ -151,6 +151,67 @@ double LFO::getNextSample()
     return thisSample;
 }
 
+template <typename SampleType>
+void LFO::renderBlock(SampleType* out, int numSamps)
+{
+    const SampleType twoPi = juce::MathConstants<SampleType>::twoPi;
+    const SampleType one = (SampleType)1;
+    const SampleType half = (SampleType)0.5;
+    double phase = mPhaseAngle;
+
+    // the phase for every sample first, wrapped the same way getNextSample() does it
+    for(int i = 0; i < numSamps; i++)
+    {
+        out[i] = (SampleType)phase;
+
+        phase += mPhaseDelta;
+        phase = std::fmod(phase, juce::MathConstants<double>::twoPi);
+
+        if(phase < 0.0)
+            phase += juce::MathConstants<double>::twoPi;
+    }
+
+    mPhaseAngle = phase;
+
+    // then the waveform, each one a plain loop over the block
+    switch(mType)
+    {
+        case sin:
+            for(int i = 0; i < numSamps; i++)
+                out[i] = (std::sin(out[i]) + one) * half;
+            break;
+        case cos:
+            for(int i = 0; i < numSamps; i++)
+                out[i] = (std::cos(out[i]) + one) * half;
+            break;
+        case square:
+            for(int i = 0; i < numSamps; i++)
+                out[i] = (out[i] / twoPi > half) ? one : (SampleType)0;
+            break;
+        case saw:
+            juce::FloatVectorOperations::multiply(out, one / twoPi, numSamps);
+            break;
+        case triangle:
+            for(int i = 0; i < numSamps; i++)
+            {
+                SampleType thisSample = out[i] / twoPi;
+
+                out[i] = ((thisSample > half) ? one - thisSample : thisSample) * (SampleType)2;
+            }
+            break;
+        default:
+            juce::FloatVectorOperations::clear(out, numSamps);
+            break;
+    }
+
+    // re-scale according to mRange
+    juce::FloatVectorOperations::multiply(out, (SampleType)mRange.getLength(), numSamps);
+    juce::FloatVectorOperations::add(out, (SampleType)mRange.getStart(), numSamps);
+}
+
+template void LFO::renderBlock<float>(float* out, int numSamps);
+template void LFO::renderBlock<double>(double* out, int numSamps);
+
 void LFO::calcPhaseDelta()
 {
     double cyclesPerSample = mFreq/mSampleRate;
@@ -30,6 +30,10 @@ namespace atec
         double getSampleRate();
         void setSampleRate(double sampleRate);
         double getNextSample();
+        // numSamps values of getNextSample() at once, as float or double. the waveform switch happens once per block instead of once per sample.
+        // the phase still accumulates in double so it doesn't drift, but the waveform is computed in SampleType, so a float block has no per-sample double math to keep it from vectorizing
+        template <typename SampleType>
+        void renderBlock(SampleType* out, int numSamps);
 
     private:
         bool mDebugFlag;
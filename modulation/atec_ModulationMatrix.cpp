@@ -0,0 +1,310 @@
+namespace atec
+{
+ModulationMatrix::ModulationMatrix()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+
+    mNumActiveRoutes = 0;
+    mSampleRate = 48000.0;
+    mSmoothingMs = MODMATRIXDEFAULTSMOOTHMS;
+    mNumSources = 0;
+    mNumDestinations = 0;
+    mMaxBlockSize = 0;
+
+    if(mDebugFlag)
+        DBG("ModulationMatrix constructor called");
+}
+
+ModulationMatrix::~ModulationMatrix()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("ModulationMatrix destructor called");
+}
+
+void ModulationMatrix::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the source and destination buffers come from arena at the next prepare(). nullptr for the heap
+void ModulationMatrix::setArena(AudioArena* arena)
+{
+    mArena = arena;
+}
+
+// call from prepareToPlay(). clears all routes
+void ModulationMatrix::prepare(int numSources, int numDestinations, int maxBlockSize, double sampleRate)
+{
+    mNumSources = numSources;
+    mNumDestinations = numDestinations;
+    mMaxBlockSize = maxBlockSize;
+    mSampleRate = sampleRate;
+
+    AudioArena::setBufferSize(mArena, mSourceBuf, mSourceReservation, mNumSources, mMaxBlockSize);
+    AudioArena::setBufferSize(mArena, mDestinationBuf, mDestinationReservation, mNumDestinations, mMaxBlockSize);
+    mRamp.allocate((size_t)mMaxBlockSize, true);
+
+    allocateTable(mEditTable);
+
+    for(int i = 0; i < 3; i++)
+        allocateTable(mTables.getSlot(i));
+
+    mCurrentDepths.allocate((size_t)mNumSources * mNumDestinations, true);
+    mCurrentOffsets.allocate((size_t)mNumDestinations, true);
+    mActiveRoutes.allocate((size_t)mNumSources * mNumDestinations, true);
+    mLastSourceValues.allocate((size_t)mNumSources, true);
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "ModulationMatrix prepare. mNumSources: " + std::to_string(mNumSources) + ", mNumDestinations: " + std::to_string(mNumDestinations);
+        DBG(post);
+    }
+}
+
+// no routes, zero offsets, and no range limits. not while process() could be running
+void ModulationMatrix::init()
+{
+    juce::FloatVectorOperations::clear(mEditTable.depths.get(), mNumSources * mNumDestinations);
+    juce::FloatVectorOperations::clear(mEditTable.offsets.get(), mNumDestinations);
+    juce::FloatVectorOperations::fill(mEditTable.minimums.get(), -std::numeric_limits<float>::max(), mNumDestinations);
+    juce::FloatVectorOperations::fill(mEditTable.maximums.get(), std::numeric_limits<float>::max(), mNumDestinations);
+
+    juce::FloatVectorOperations::clear(mCurrentDepths.get(), mNumSources * mNumDestinations);
+    juce::FloatVectorOperations::clear(mCurrentOffsets.get(), mNumDestinations);
+    juce::FloatVectorOperations::clear(mLastSourceValues.get(), mNumSources);
+    mNumActiveRoutes = 0;
+
+    mSourceBuf.clear();
+    mDestinationBuf.clear();
+
+    // every slot gets the empty table, so the audio thread starts from it whichever one it reads
+    for(int i = 0; i < 3; i++)
+    {
+        RoutingTable& table = mTables.getSlot(i);
+
+        std::memcpy(table.depths.get(), mEditTable.depths.get(), sizeof(float) * (size_t)(mNumSources * mNumDestinations));
+        std::memcpy(table.offsets.get(), mEditTable.offsets.get(), sizeof(float) * (size_t)mNumDestinations);
+        std::memcpy(table.minimums.get(), mEditTable.minimums.get(), sizeof(float) * (size_t)mNumDestinations);
+        std::memcpy(table.maximums.get(), mEditTable.maximums.get(), sizeof(float) * (size_t)mNumDestinations);
+    }
+}
+
+// adds the route, or changes its depth. the depth glides there over the smoothing time
+void ModulationMatrix::setRoute(int source, int destination, float depth)
+{
+    jassert(source >= 0 && source < mNumSources && destination >= 0 && destination < mNumDestinations);
+
+    mEditTable.depths[source * mNumDestinations + destination] = depth;
+    publishTable();
+}
+
+// the route fades out over the smoothing time
+void ModulationMatrix::removeRoute(int source, int destination)
+{
+    setRoute(source, destination, 0.0f);
+}
+
+void ModulationMatrix::clearRoutes()
+{
+    juce::FloatVectorOperations::clear(mEditTable.depths.get(), mNumSources * mNumDestinations);
+    publishTable();
+}
+
+// the destination's value with no modulation
+void ModulationMatrix::setOffset(int destination, float offset)
+{
+    mEditTable.offsets[destination] = offset;
+    publishTable();
+}
+
+// the destination's buffer is clipped to this
+void ModulationMatrix::setDestinationRange(int destination, float minimum, float maximum)
+{
+    jassert(minimum <= maximum);
+
+    mEditTable.minimums[destination] = minimum;
+    mEditTable.maximums[destination] = maximum;
+    publishTable();
+}
+
+// the target depth, from the message thread's copy
+float ModulationMatrix::getRouteDepth(int source, int destination)
+{
+    return mEditTable.depths[source * mNumDestinations + destination];
+}
+
+// for sources that render themselves. fill numSamps values before process()
+float* ModulationMatrix::getSourceWritePointer(int source)
+{
+    return mSourceBuf.getWritePointer(source);
+}
+
+void ModulationMatrix::renderLfo(int source, LFO& lfo, int numSamps)
+{
+    lfo.renderBlock(mSourceBuf.getWritePointer(source), numSamps);
+}
+
+// for sources that only have one value per block, e.g. SlidingWindowStats::getRms(). ramps there from the last block's value
+void ModulationMatrix::setSourceValue(int source, float value, int numSamps)
+{
+    fillRamp(mSourceBuf.getWritePointer(source), mLastSourceValues[source], value, numSamps);
+    mLastSourceValues[source] = value;
+}
+
+void ModulationMatrix::process(int numSamps)
+{
+    float* ramp = mRamp.get();
+    // how far every depth and offset gets toward its target this block
+    float coeff = (mSmoothingMs > 0.0) ? (float)(1.0 - std::exp(-numSamps / (mSmoothingMs * 0.001 * mSampleRate))) : 1.0f;
+    int route = 0;
+
+    jassert(numSamps <= mMaxBlockSize);
+
+    if(numSamps <= 0)
+        return;
+
+    if(mTables.update())
+        updateActiveRoutes();
+
+    const RoutingTable& table = mTables.getReadBuffer();
+
+    for(int destination = 0; destination < mNumDestinations; destination++)
+    {
+        float start = mCurrentOffsets[destination];
+        float target = table.offsets[destination];
+        float end = start + (target - start) * coeff;
+
+        end = (std::abs(target - end) < MODMATRIXSNAP) ? target : end;
+        mCurrentOffsets[destination] = end;
+
+        fillRamp(mDestinationBuf.getWritePointer(destination), start, end, numSamps);
+    }
+
+    while(route < mNumActiveRoutes)
+    {
+        int index = mActiveRoutes[route];
+        int source = index / mNumDestinations;
+        int destination = index - source * mNumDestinations;
+        float start = mCurrentDepths[index];
+        float target = table.depths[index];
+        float end = start + (target - start) * coeff;
+        float* destPtr = mDestinationBuf.getWritePointer(destination);
+        const float* sourcePtr = mSourceBuf.getReadPointer(source);
+
+        end = (std::abs(target - end) < MODMATRIXSNAP) ? target : end;
+        mCurrentDepths[index] = end;
+
+        if(start == end)
+        {
+            juce::FloatVectorOperations::addWithMultiply(destPtr, sourcePtr, end, numSamps);
+        }
+        else
+        {
+            fillRamp(ramp, start, end, numSamps);
+            juce::FloatVectorOperations::addWithMultiply(destPtr, sourcePtr, ramp, numSamps);
+        }
+
+        // faded all the way out, so drop it. the last one moves into its place
+        if(end == 0.0f && target == 0.0f)
+            mActiveRoutes[route] = mActiveRoutes[--mNumActiveRoutes];
+        else
+            route++;
+    }
+
+    for(int destination = 0; destination < mNumDestinations; destination++)
+    {
+        float* destPtr = mDestinationBuf.getWritePointer(destination);
+
+        juce::FloatVectorOperations::clip(destPtr, destPtr, table.minimums[destination], table.maximums[destination], numSamps);
+    }
+}
+
+// numSamps values from the last process()
+const float* ModulationMatrix::getDestinationBuffer(int destination)
+{
+    return mDestinationBuf.getReadPointer(destination);
+}
+
+// routes process() is multiply-adding, including ones still fading out
+int ModulationMatrix::getNumActiveRoutes()
+{
+    return mNumActiveRoutes;
+}
+
+// how long depth and offset changes take to settle (the time constant). 0 jumps straight there
+void ModulationMatrix::setSmoothingMs(double ms)
+{
+    mSmoothingMs = juce::jmax(0.0, ms);
+}
+
+int ModulationMatrix::getNumSources()
+{
+    return mNumSources;
+}
+
+int ModulationMatrix::getNumDestinations()
+{
+    return mNumDestinations;
+}
+
+void ModulationMatrix::allocateTable(RoutingTable& table)
+{
+    table.depths.allocate((size_t)juce::jmax(1, mNumSources * mNumDestinations), true);
+    table.offsets.allocate((size_t)juce::jmax(1, mNumDestinations), true);
+    table.minimums.allocate((size_t)juce::jmax(1, mNumDestinations), true);
+    table.maximums.allocate((size_t)juce::jmax(1, mNumDestinations), true);
+}
+
+// message thread: copy the edited table into the TripleBuffer and hand it over
+void ModulationMatrix::publishTable()
+{
+    RoutingTable& table = mTables.getWriteBuffer();
+
+    std::memcpy(table.depths.get(), mEditTable.depths.get(), sizeof(float) * (size_t)(mNumSources * mNumDestinations));
+    std::memcpy(table.offsets.get(), mEditTable.offsets.get(), sizeof(float) * (size_t)mNumDestinations);
+    std::memcpy(table.minimums.get(), mEditTable.minimums.get(), sizeof(float) * (size_t)mNumDestinations);
+    std::memcpy(table.maximums.get(), mEditTable.maximums.get(), sizeof(float) * (size_t)mNumDestinations);
+
+    mTables.publish();
+}
+
+// audio thread, only when a new table arrives: every route that's set, or still fading
+void ModulationMatrix::updateActiveRoutes()
+{
+    const RoutingTable& table = mTables.getReadBuffer();
+    int numRoutes = mNumSources * mNumDestinations;
+
+    mNumActiveRoutes = 0;
+
+    for(int index = 0; index < numRoutes; index++)
+        if(table.depths[index] != 0.0f || mCurrentDepths[index] != 0.0f)
+            mActiveRoutes[mNumActiveRoutes++] = index;
+}
+
+// start + step * (i + 1), so the ramp ends exactly on end and picks up from start
+void ModulationMatrix::fillRamp(float* ramp, float start, float end, int numSamps)
+{
+    float step;
+
+    if(numSamps <= 0)
+        return;
+
+    step = (end - start) / (float)numSamps;
+
+    if(step == 0.0f)
+    {
+        juce::FloatVectorOperations::fill(ramp, end, numSamps);
+        return;
+    }
+
+    for(int i = 0; i < numSamps; i++)
+        ramp[i] = start + step * (float)(i + 1);
+
+    ramp[numSamps - 1] = end;
+}
+} // namespace atec
@@ -0,0 +1,104 @@
+/*
+
+    Routes modulation sources (LFOs, envelopes, SlidingWindowStats values, anything) to parameter destinations a block at a time, instead of calling LFO::getNextSample() per parameter per sample.
+
+    Each block:
+    - sources render into the matrix's source buffers: renderLfo() for an LFO, setSourceValue() for something that updates once a block (ramped across the block so it doesn't step), or write straight into getSourceWritePointer()
+    - process() computes every destination as its offset plus the sum of depth * source over the routes into it, then clips it to the destination's range. only routes that exist are visited, so it's a sparse matrix-vector product, one vector multiply-add per route
+    - destinations read a finished per-sample buffer from getDestinationBuffer()
+
+    Depths and offsets never jump. When they change, each block moves them part of the way toward the new value (a one pole smoother evaluated once per block, over setSmoothingMs()), and within the block it's a linear ramp. So the smoothing is also plain vector math: a ramp and a multiply-add. A removed route fades out before it stops being processed.
+
+    Routing changes come from the message thread. They're edits to a private copy of the routing table, which then goes to the audio thread through a TripleBuffer, so neither side locks, waits or allocates. The audio thread only rescans the table when a new one has arrived.
+
+    NOTE:
+    - all the set/clear routing functions must be called from the same thread (normally the message thread)
+    - render every source before process(). sources that aren't written keep whatever was there last block
+    - prepare() allocates everything, so call it from prepareToPlay()
+
+ */
+
+#include "../utilities/atec_TripleBuffer.h"
+#include "../buffering/atec_AudioArena.h"
+
+namespace atec
+{
+    #define MODMATRIXDEFAULTSMOOTHMS 20.0
+    // a depth or offset this close to its target snaps to it
+    #define MODMATRIXSNAP 1.0e-6f
+
+    class LFO;
+
+    class ModulationMatrix
+    {
+    public:
+        ModulationMatrix();
+        ~ModulationMatrix();
+
+        void debug(bool d);
+        void prepare(int numSources, int numDestinations, int maxBlockSize, double sampleRate);
+        void setArena(AudioArena* arena);
+        void init();
+
+        // message thread
+        void setRoute(int source, int destination, float depth);
+        void removeRoute(int source, int destination);
+        void clearRoutes();
+        void setOffset(int destination, float offset);
+        void setDestinationRange(int destination, float minimum, float maximum);
+        float getRouteDepth(int source, int destination);
+
+        // audio thread
+        float* getSourceWritePointer(int source);
+        void renderLfo(int source, LFO& lfo, int numSamps);
+        void setSourceValue(int source, float value, int numSamps);
+        void process(int numSamps);
+        const float* getDestinationBuffer(int destination);
+        int getNumActiveRoutes();
+
+        void setSmoothingMs(double ms);
+        int getNumSources();
+        int getNumDestinations();
+
+    private:
+        // the dense depth matrix (source major), and per destination offsets and ranges. a few KB even for big matrices, and only copied on edits
+        struct RoutingTable
+        {
+            juce::HeapBlock<float> depths;
+            juce::HeapBlock<float> offsets;
+            juce::HeapBlock<float> minimums;
+            juce::HeapBlock<float> maximums;
+        };
+
+        void allocateTable(RoutingTable& table);
+        void publishTable();
+        void updateActiveRoutes();
+        void fillRamp(float* ramp, float start, float end, int numSamps);
+
+        juce::AudioBuffer<float> mSourceBuf;
+        juce::AudioBuffer<float> mDestinationBuf;
+        juce::HeapBlock<float> mRamp;
+
+        // message thread's copy, and the hand-off
+        RoutingTable mEditTable;
+        TripleBuffer<RoutingTable> mTables;
+
+        // audio thread: where every depth and offset is right now, the routes worth processing (index source * numDestinations + destination), and each source's last setSourceValue()
+        juce::HeapBlock<float> mCurrentDepths;
+        juce::HeapBlock<float> mCurrentOffsets;
+        juce::HeapBlock<int> mActiveRoutes;
+        juce::HeapBlock<float> mLastSourceValues;
+        int mNumActiveRoutes;
+
+        double mSampleRate;
+        double mSmoothingMs;
+        int mNumSources;
+        int mNumDestinations;
+        int mMaxBlockSize;
+        // set by setArena(), for the source and destination buffers
+        AudioArena* mArena;
+        AudioArena::Reservation mSourceReservation;
+        AudioArena::Reservation mDestinationReservation;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,333 @@
+namespace atec
+{
+PolyphaseResampler::PolyphaseResampler()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+
+    mMode = rational;
+    mInRate = 48000.0;
+    mOutRate = 48000.0;
+    mSpeed = 1.0;
+    mMaxSpeed = 1.0;
+    mFrac = 0.0;
+    mStep = 1.0;
+    mStepWhole = 1;
+    mStepPhases = 0;
+    mPhase = 0;
+    mInputIdx = 0;
+    mNumPhases = 1;
+    mNumTaps = RESAMPLERBASETAPS;
+    mNumChannels = 0;
+    mMaxInputBlockSize = 0;
+    mMaxOutputSamples = 0;
+
+    if(mDebugFlag)
+        DBG("PolyphaseResampler constructor called");
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("PolyphaseResampler destructor called");
+}
+
+void PolyphaseResampler::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the input history comes from arena at the next prepare(). the filter table is shared by every channel, and stays on the heap
+void PolyphaseResampler::setArena(AudioArena* arena)
+{
+    mArena = arena;
+}
+
+// builds the filter table. maxSpeed is the fastest setSpeed() will go in varispeed mode, which the cutoff has to allow for. call from prepareToPlay()
+void PolyphaseResampler::prepare(double inRate, double outRate, int numChannels, int maxInputBlockSize, Mode mode, double maxSpeed)
+{
+    double downRatio, cutoff;
+    int numTaps;
+
+    jassert(inRate > 0.0 && outRate > 0.0);
+
+    mInRate = inRate;
+    mOutRate = outRate;
+    mNumChannels = numChannels;
+    mMaxInputBlockSize = maxInputBlockSize;
+    mMode = mode;
+    mMaxSpeed = (mMode == varispeed) ? juce::jmax(1.0, maxSpeed) : 1.0;
+    mSpeed = 1.0;
+
+    if(mMode == rational)
+    {
+        juce::int64 in = (juce::int64)std::round(mInRate);
+        juce::int64 out = (juce::int64)std::round(mOutRate);
+        juce::int64 a = in, b = out;
+
+        while(b != 0)
+        {
+            juce::int64 r = a % b;
+            a = b;
+            b = r;
+        }
+
+        // L = out/gcd phases, stepping M = in/gcd of them per output
+        if((double)in == mInRate && (double)out == mOutRate && out / a <= RESAMPLERMAXPHASES)
+        {
+            mNumPhases = (int)(out / a);
+            mStepWhole = (int)((in / a) / mNumPhases);
+            mStepPhases = (int)((in / a) % mNumPhases);
+        }
+        else
+        {
+            mMode = varispeed;
+
+            if(mDebugFlag)
+                DBG("PolyphaseResampler: no exact ratio with few enough phases, using varispeed");
+        }
+    }
+
+    if(mMode == varispeed)
+        mNumPhases = RESAMPLERVARIPHASES;
+
+    mStep = (mInRate / mOutRate) * mSpeed;
+
+    // cutoff in cycles per input sample, under whichever Nyquist is lower. the filter grows in proportion when it has to come down
+    downRatio = juce::jmax(1.0, (mInRate * mMaxSpeed) / mOutRate);
+    cutoff = 0.5 * RESAMPLERPASSBAND / downRatio;
+    numTaps = (int)std::ceil(RESAMPLERBASETAPS * downRatio);
+    mNumTaps = (numTaps + 7) & ~7;
+
+    buildTable(cutoff);
+
+    // one output per step, plus one for the position leftover from the last block
+    mMaxOutputSamples = (int)std::ceil(mMaxInputBlockSize * mOutRate / (mInRate * ((mMode == varispeed) ? RESAMPLERMINSPEED : 1.0))) + 1;
+
+    AudioArena::setBufferSize(mArena, mHistory, mHistoryReservation, mNumChannels, mNumTaps - 1 + mMaxInputBlockSize);
+    mOutIdx.allocate((size_t)mMaxOutputSamples, true);
+    mOutPhase.allocate((size_t)mMaxOutputSamples, true);
+    mOutFrac.allocate((size_t)mMaxOutputSamples, true);
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "PolyphaseResampler prepare. mNumPhases: " + std::to_string(mNumPhases) + ", mNumTaps: " + std::to_string(mNumTaps) + ", mMaxOutputSamples: " + std::to_string(mMaxOutputSamples);
+        DBG(post);
+    }
+}
+
+// clear the input history and start over at phase 0
+void PolyphaseResampler::init()
+{
+    mHistory.clear();
+
+    // the first input sample lands right after the history
+    mInputIdx = mNumTaps - 1;
+    mPhase = 0;
+    mFrac = 0.0;
+}
+
+// returns the number of samples written to output, at most getMaxOutputSamples()
+int PolyphaseResampler::process(const juce::AudioBuffer<float>& input, int numInputSamps, juce::AudioBuffer<float>& output)
+{
+    int* outIdx = mOutIdx.get();
+    int* outPhase = mOutPhase.get();
+    float* outFrac = mOutFrac.get();
+    int available = mNumTaps - 1 + numInputSamps;
+    int numOut = 0;
+
+    jassert(numInputSamps <= mMaxInputBlockSize);
+
+    for(int channel = 0; channel < mNumChannels; channel++)
+        mHistory.copyFrom(channel, mNumTaps - 1, input, channel, 0, numInputSamps);
+
+    // every output position in this block, first
+    if(mMode == rational)
+    {
+        while(mInputIdx < available)
+        {
+            outIdx[numOut] = mInputIdx - (mNumTaps - 1);
+            outPhase[numOut] = mPhase;
+            numOut++;
+
+            mPhase += mStepPhases;
+            mInputIdx += mStepWhole;
+
+            if(mPhase >= mNumPhases)
+            {
+                mPhase -= mNumPhases;
+                mInputIdx++;
+            }
+        }
+    }
+    else
+    {
+        while(mInputIdx < available)
+        {
+            double phasePos = mFrac * mNumPhases;
+            int phase = juce::jmin(mNumPhases - 1, (int)phasePos);
+            double whole;
+
+            outIdx[numOut] = mInputIdx - (mNumTaps - 1);
+            outPhase[numOut] = phase;
+            outFrac[numOut] = (float)(phasePos - phase);
+            numOut++;
+
+            mFrac += mStep;
+            whole = std::floor(mFrac);
+            mFrac -= whole;
+            mInputIdx += (int)whole;
+        }
+    }
+
+    jassert(numOut <= output.getNumSamples());
+
+    // then the filter for each channel
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        const float* history = mHistory.getReadPointer(channel);
+        float* outPtr = output.getWritePointer(channel);
+
+        if(mMode == rational)
+        {
+            for(int samp = 0; samp < numOut; samp++)
+                outPtr[samp] = Utilities::dotProduct(history + outIdx[samp], mTable.get() + (size_t)outPhase[samp] * mNumTaps, mNumTaps);
+        }
+        else
+        {
+            for(int samp = 0; samp < numOut; samp++)
+            {
+                size_t offset = (size_t)outPhase[samp] * mNumTaps;
+
+                outPtr[samp] = dotProductInterp(history + outIdx[samp], mTable.get() + offset, mDeltas.get() + offset, outFrac[samp], mNumTaps);
+            }
+        }
+    }
+
+    // keep the newest numTaps-1 samples for the next block
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        float* history = mHistory.getWritePointer(channel);
+
+        std::memmove(history, history + numInputSamps, sizeof(float) * (size_t)(mNumTaps - 1));
+    }
+
+    mInputIdx -= numInputSamps;
+
+    return numOut;
+}
+
+// input samples per output sample, relative to the prepare()d rates. varispeed mode only. RESAMPLERMINSPEED to the maxSpeed given to prepare()
+void PolyphaseResampler::setSpeed(double speed)
+{
+    jassert(mMode == varispeed);
+
+    if(mMode != varispeed)
+        return;
+
+    mSpeed = juce::jlimit(RESAMPLERMINSPEED, mMaxSpeed, speed);
+    mStep = (mInRate / mOutRate) * mSpeed;
+}
+
+double PolyphaseResampler::getSpeed()
+{
+    return mSpeed;
+}
+
+// varispeed if rational wasn't possible for the prepare()d rates
+PolyphaseResampler::Mode PolyphaseResampler::getMode()
+{
+    return mMode;
+}
+
+int PolyphaseResampler::getNumTaps()
+{
+    return mNumTaps;
+}
+
+int PolyphaseResampler::getNumPhases()
+{
+    return mNumPhases;
+}
+
+// the most output samples one process() call can write
+int PolyphaseResampler::getMaxOutputSamples()
+{
+    return mMaxOutputSamples;
+}
+
+// the filter's group delay. output sample n is input time n * step - this
+double PolyphaseResampler::getLatencyInputSamps()
+{
+    return 0.5 * (mNumTaps - 1.0 / mNumPhases);
+}
+
+// at the current speed
+double PolyphaseResampler::getLatencyOutputSamps()
+{
+    return getLatencyInputSamps() / mStep;
+}
+
+// windowed sinc, sampled at every phase offset. the kernel is centered on the filter's midpoint, so it's symmetric and linear phase
+void PolyphaseResampler::buildTable(double cutoff)
+{
+    // varispeed blends toward the next phase, so it needs one past the last, which is phase 0 a sample later
+    int numRows = mNumPhases + ((mMode == varispeed) ? 1 : 0);
+    double center = getLatencyInputSamps();
+    double halfLength = 0.5 * mNumTaps;
+    double besselBeta = juce::dsp::SpecialFunctions::besselI0(RESAMPLERKAISERBETA);
+
+    mTable.allocate((size_t)numRows * mNumTaps, true);
+    mDeltas.allocate((size_t)mNumPhases * mNumTaps, true);
+
+    for(int phase = 0; phase < numRows; phase++)
+    {
+        float* taps = mTable.get() + (size_t)phase * mNumTaps;
+        double sum = 0.0;
+
+        for(int tap = 0; tap < mNumTaps; tap++)
+        {
+            // tap multiplies the input tap samples before the newest one, at this far past it
+            double u = tap + (double)phase / mNumPhases;
+            double x = u - center;
+            double r = x / halfLength;
+            double sinc = (x == 0.0) ? 1.0 : std::sin(juce::MathConstants<double>::twoPi * cutoff * x) / (juce::MathConstants<double>::twoPi * cutoff * x);
+            double window = (std::abs(r) < 1.0) ? juce::dsp::SpecialFunctions::besselI0(RESAMPLERKAISERBETA * std::sqrt(1.0 - r * r)) / besselBeta : 0.0;
+            double value = 2.0 * cutoff * sinc * window;
+
+            // reversed, so the dot product runs forward through the input
+            taps[mNumTaps - 1 - tap] = (float)value;
+            sum += value;
+        }
+
+        // unity at DC for every phase
+        juce::FloatVectorOperations::multiply(taps, (float)(1.0 / sum), mNumTaps);
+    }
+
+    if(mMode == varispeed)
+    {
+        for(int phase = 0; phase < mNumPhases; phase++)
+        {
+            const float* taps = mTable.get() + (size_t)phase * mNumTaps;
+
+            juce::FloatVectorOperations::subtract(mDeltas.get() + (size_t)phase * mNumTaps, taps + mNumTaps, taps, mNumTaps);
+        }
+    }
+}
+
+// Utilities::dotProduct(), with the taps blended frac of the way to the next phase. numTaps is a multiple of 8
+float PolyphaseResampler::dotProductInterp(const float* x, const float* taps, const float* deltas, float frac, int numTaps)
+{
+    float sums[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for(int i = 0; i < numTaps; i += 8)
+        for(int j = 0; j < 8; j++)
+            sums[j] += x[i + j] * (taps[i + j] + frac * deltas[i + j]);
+
+    return ((sums[0] + sums[4]) + (sums[1] + sums[5])) + ((sums[2] + sums[6]) + (sums[3] + sums[7]));
+}
+} // namespace atec
@@ -0,0 +1,99 @@
+/*
+
+    Streaming sample rate conversion with a polyphase windowed sinc filter, for bridging host rates (44.1, 48, 96k) and oversampled stages.
+
+    Two modes:
+    - rational: outRate/inRate is reduced to L/M, and the filter is split into L phases, one per output position between input samples. Every output is one dot product of one phase's taps with the input, and positions step by exact integer math, so there's no drift however long it runs. 44.1k <-> 48k is 160/147, and the table for that is about 20KB, so it stays in cache
+    - varispeed: for any ratio, including ones that change while running (setSpeed()). the filter is tabled at RESAMPLERVARIPHASES phases, and each output blends the two phases either side of its position. one extra multiply-add per tap
+    Taps are stored reversed and padded to a multiple of 8, so each output is a straight dot product over contiguous memory. It's summed in 8 separate partial sums, which the compiler turns into SIMD without needing fast-math. Output positions are worked out once per block, then every channel runs through them.
+
+    The cutoff is a little under the lower of the two Nyquist frequencies (RESAMPLERPASSBAND), and the filter gets longer as the ratio comes down, so the transition band stays the same width in output terms. Each phase is normalized to unity gain at DC, so there's no ripple from phase to phase.
+
+    COST:
+    - per output sample per channel: taps multiply-adds in rational mode, twice that in varispeed. taps is RESAMPLERBASETAPS when upsampling, and scales with the ratio when downsampling
+    - per block: one copy of the input per channel, and a taps long move to keep the history
+
+    NOTE:
+    - process() takes any number of input samples up to the prepare()d block size, and returns how many output samples it wrote, which varies block to block. size the output with getMaxOutputSamples()
+    - latency is exactly getLatencyInputSamps() input samples, which is half the filter length. it's a fraction, so getLatencyOutputSamps() is the same delay in output samples
+    - rational mode needs whole number rates whose reduced ratio has at most RESAMPLERMAXPHASES phases. otherwise prepare() falls back to varispeed
+    - nothing allocates after prepare()
+
+ */
+
+#include "../buffering/atec_AudioArena.h"
+
+namespace atec
+{
+    #define RESAMPLERBASETAPS 32
+    #define RESAMPLERMAXPHASES 1024
+    #define RESAMPLERVARIPHASES 256
+    #define RESAMPLERPASSBAND 0.9
+    #define RESAMPLERKAISERBETA 8.0
+    #define RESAMPLERMINSPEED 0.25
+
+    class PolyphaseResampler
+    {
+    public:
+        enum Mode
+        {
+            rational,
+            varispeed
+        };
+
+        PolyphaseResampler();
+        ~PolyphaseResampler();
+
+        void debug(bool d);
+        void prepare(double inRate, double outRate, int numChannels, int maxInputBlockSize, Mode mode, double maxSpeed = 1.0);
+        void setArena(AudioArena* arena);
+        void init();
+        int process(const juce::AudioBuffer<float>& input, int numInputSamps, juce::AudioBuffer<float>& output);
+        void setSpeed(double speed);
+        double getSpeed();
+        Mode getMode();
+        int getNumTaps();
+        int getNumPhases();
+        int getMaxOutputSamples();
+        double getLatencyInputSamps();
+        double getLatencyOutputSamps();
+
+    private:
+        void buildTable(double cutoff);
+        static float dotProductInterp(const float* x, const float* taps, const float* deltas, float frac, int numTaps);
+
+        // phases * taps, each phase's taps reversed. varispeed also has the difference to the next phase
+        juce::HeapBlock<float> mTable;
+        juce::HeapBlock<float> mDeltas;
+        // the last numTaps-1 input samples, then the new block
+        juce::AudioBuffer<float> mHistory;
+        // where each output of the block reads from: the newest input sample it uses, and the phase
+        juce::HeapBlock<int> mOutIdx;
+        juce::HeapBlock<int> mOutPhase;
+        juce::HeapBlock<float> mOutFrac;
+
+        Mode mMode;
+        double mInRate;
+        double mOutRate;
+        double mSpeed;
+        double mMaxSpeed;
+        // varispeed position past mInputIdx, and step, in input samples
+        double mFrac;
+        double mStep;
+        // rational step, as whole input samples plus mStepPhases/mNumPhases
+        int mStepWhole;
+        int mStepPhases;
+        int mPhase;
+        // the newest input sample the next output uses, as an index into mHistory
+        int mInputIdx;
+        int mNumPhases;
+        int mNumTaps;
+        int mNumChannels;
+        int mMaxInputBlockSize;
+        int mMaxOutputSamples;
+        // set by setArena(), for mHistory
+        AudioArena* mArena;
+        AudioArena::Reservation mHistoryReservation;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,256 @@
+namespace atec
+{
+BandMapper::BandMapper()
+{
+    mDebugFlag = false;
+
+    mFftSize = 0;
+    mNumBins = 0;
+
+    if(mDebugFlag)
+        DBG("BandMapper constructor called");
+}
+
+BandMapper::~BandMapper()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("BandMapper destructor called");
+}
+
+void BandMapper::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// finds or builds the kernels for this configuration. call from prepareToPlay()
+void BandMapper::prepare(int fftSize, double sampleRate, Scale scale, int numBands, double minFreq, double maxFreq)
+{
+    jassert(fftSize >= 16);
+    jassert(numBands > 0);
+    jassert(minFreq > 0.0 && maxFreq > minFreq);
+
+    mFftSize = fftSize;
+    mNumBins = (mFftSize / 2) + 1;
+    maxFreq = juce::jmin(maxFreq, sampleRate * 0.5);
+
+    mKernels = getKernels(fftSize, sampleRate, scale, numBands, minFreq, maxFreq);
+    mMag.allocate((size_t)mNumBins, true);
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "BandMapper prepare. numBands: " + std::to_string(numBands) + ", numWeights: " + std::to_string(mKernels->numWeights) + ", shared kernel sets: " + std::to_string(getNumSharedKernels());
+        DBG(post);
+    }
+}
+
+// spectrum is N/2+1 magnitudes (or powers). bands gets getNumBands() values
+void BandMapper::process(const float* spectrum, float* bands)
+{
+    const Kernels& kernels = *mKernels;
+
+    for(int band = 0; band < kernels.numBands; band++)
+        bands[band] = Utilities::dotProduct(spectrum + kernels.starts[band], kernels.weights.get() + kernels.offsets[band], kernels.lengths[band]);
+}
+
+// straight from an FFT's output, mapping the magnitudes
+void BandMapper::process(const juce::dsp::Complex<float>* spectrum, float* bands)
+{
+    Utilities::getFftMagSpec(spectrum, mMag.get(), mFftSize);
+    process(mMag.get(), bands);
+}
+
+int BandMapper::getNumBands()
+{
+    return (mKernels != nullptr) ? mKernels->numBands : 0;
+}
+
+int BandMapper::getFftSize()
+{
+    return mFftSize;
+}
+
+BandMapper::Scale BandMapper::getScale()
+{
+    return (mKernels != nullptr) ? mKernels->scale : constantQ;
+}
+
+// in Hz, e.g. for labeling a display
+float BandMapper::getCenterFreq(int band)
+{
+    return mKernels->centerFreqs[band];
+}
+
+// multiply-adds per process(), padding included
+int BandMapper::getNumWeights()
+{
+    return (mKernels != nullptr) ? mKernels->numWeights : 0;
+}
+
+// how many distinct configurations are cached
+int BandMapper::getNumSharedKernels()
+{
+    const juce::ScopedLock lock(getKernelCacheLock());
+
+    return getKernelCache().size();
+}
+
+// the cached kernels for this configuration, built if nobody has them yet. drops any the cache is the last owner of while it's looking
+BandMapper::Kernels::Ptr BandMapper::getKernels(int fftSize, double sampleRate, Scale scale, int numBands, double minFreq, double maxFreq)
+{
+    const juce::ScopedLock lock(getKernelCacheLock());
+    juce::ReferenceCountedArray<Kernels>& cache = getKernelCache();
+    Kernels::Ptr found;
+
+    for(int i = cache.size() - 1; i >= 0; i--)
+    {
+        Kernels* kernels = cache.getObjectPointerUnchecked(i);
+
+        if(kernels->fftSize == fftSize && kernels->sampleRate == sampleRate && kernels->scale == scale && kernels->numBands == numBands && kernels->minFreq == minFreq && kernels->maxFreq == maxFreq)
+            found = kernels;
+        else if(kernels->getReferenceCount() == 1)
+            cache.remove(i);
+    }
+
+    if(found == nullptr)
+        found = cache.add(buildKernels(fftSize, sampleRate, scale, numBands, minFreq, maxFreq));
+
+    return found;
+}
+
+BandMapper::Kernels* BandMapper::buildKernels(int fftSize, double sampleRate, Scale scale, int numBands, double minFreq, double maxFreq)
+{
+    Kernels* kernels = new Kernels();
+    int numBins = (fftSize / 2) + 1;
+    double binHz = sampleRate / fftSize;
+    double lowest = hzToScale(minFreq, scale);
+    double spacing = (hzToScale(maxFreq, scale) - lowest) / (numBands + 1);
+    juce::Array<float> weights;
+
+    kernels->fftSize = fftSize;
+    kernels->sampleRate = sampleRate;
+    kernels->scale = scale;
+    kernels->numBands = numBands;
+    kernels->minFreq = minFreq;
+    kernels->maxFreq = maxFreq;
+    kernels->offsets.allocate((size_t)numBands, true);
+    kernels->starts.allocate((size_t)numBands, true);
+    kernels->lengths.allocate((size_t)numBands, true);
+    kernels->centerFreqs.allocate((size_t)numBands, true);
+
+    for(int band = 0; band < numBands; band++)
+    {
+        double center = lowest + (band + 1) * spacing;
+        double centerHz = scaleToHz(center, scale);
+        double lowerHz = scaleToHz(center - spacing, scale);
+        double upperHz = scaleToHz(center + spacing, scale);
+        int firstBin = juce::jlimit(0, numBins - 1, (int)std::ceil(lowerHz / binHz));
+        int lastBin = juce::jlimit(0, numBins - 1, (int)std::floor(upperHz / binHz));
+        int length, start, offset = weights.size();
+        double sum = 0.0;
+
+        kernels->centerFreqs[band] = (float)centerHz;
+
+        if(lastBin - firstBin >= 1)
+        {
+            // the triangle, on the band's own scale
+            for(int bin = firstBin; bin <= lastBin; bin++)
+            {
+                double weight = 1.0 - std::abs(hzToScale(bin * binHz, scale) - center) / spacing;
+
+                weights.add((float)juce::jmax(0.0, weight));
+            }
+        }
+        else
+        {
+            // narrower than a bin, so interpolate the two bins around the center
+            double position = juce::jlimit(0.0, (double)(numBins - 1), centerHz / binHz);
+
+            firstBin = juce::jmin((int)position, numBins - 2);
+            weights.add((float)(1.0 - (position - firstBin)));
+            weights.add((float)(position - firstBin));
+        }
+
+        length = weights.size() - offset;
+
+        for(int i = offset; i < weights.size(); i++)
+            sum += weights[i];
+
+        for(int i = offset; i < weights.size(); i++)
+            weights.set(i, (sum > 0.0) ? (float)(weights[i] / sum) : 0.0f);
+
+        // pad with zero weights to a multiple of 8, moving the start down if the padding would run off the top of the spectrum
+        start = firstBin;
+
+        if(((length + 7) & ~7) <= numBins)
+        {
+            int padded = (length + 7) & ~7;
+            int shift = juce::jmax(0, firstBin + padded - numBins);
+
+            for(int i = 0; i < shift; i++)
+                weights.insert(offset, 0.0f);
+
+            for(int i = length + shift; i < padded; i++)
+                weights.add(0.0f);
+
+            start -= shift;
+            length = padded;
+        }
+
+        kernels->offsets[band] = offset;
+        kernels->starts[band] = start;
+        kernels->lengths[band] = length;
+    }
+
+    kernels->numWeights = weights.size();
+    kernels->weights.allocate((size_t)juce::jmax(1, kernels->numWeights), true);
+
+    for(int i = 0; i < kernels->numWeights; i++)
+        kernels->weights[i] = weights[i];
+
+    return kernels;
+}
+
+// shared by every BandMapper. function statics, so they're constructed on first use from any thread
+juce::ReferenceCountedArray<BandMapper::Kernels>& BandMapper::getKernelCache()
+{
+    static juce::ReferenceCountedArray<Kernels> cache;
+
+    return cache;
+}
+
+juce::CriticalSection& BandMapper::getKernelCacheLock()
+{
+    static juce::CriticalSection lock;
+
+    return lock;
+}
+
+double BandMapper::hzToScale(double hz, Scale scale)
+{
+    switch(scale)
+    {
+        case mel:
+            return 2595.0 * std::log10(1.0 + hz / 700.0);
+        case bark:
+            return (26.81 * hz / (1960.0 + hz)) - 0.53;
+        default:
+            // octaves. 0 Hz only ever comes up as a bin below the lowest band, so keep it finite
+            return std::log2(juce::jmax(hz, 1.0e-3));
+    }
+}
+
+double BandMapper::scaleToHz(double value, Scale scale)
+{
+    switch(scale)
+    {
+        case mel:
+            return 700.0 * (std::pow(10.0, value / 2595.0) - 1.0);
+        case bark:
+            return 1960.0 * (value + 0.53) / (26.28 - value);
+        default:
+            return std::exp2(value);
+    }
+}
+} // namespace atec
@@ -0,0 +1,88 @@
+/*
+
+    Maps half spectra (N/2+1 bins, e.g. from Utilities::getFftMagSpec() or getFftPowerSpec()) to log spaced bands, for analyzers that think in pitch or perceptual bands instead of linear bins.
+
+    Three spacings:
+    - constantQ: band centers evenly spaced in octaves, so every band's bandwidth is the same fraction of its center frequency. this maps magnitudes, so it's the "pseudo" constant-Q transform: the frequency resolution at the bottom is still the FFT's
+    - mel: evenly spaced on the HTK mel scale
+    - bark: evenly spaced on Traunmueller's Bark scale
+    Each band is a triangle on its scale, from the center of the band below to the center of the band above. A band too narrow to reach two bins just interpolates between the two bins around its center instead. Weights are normalized to sum to 1, so a band is the weighted average of its bins.
+
+    The triangles are sparse, so each band only stores the weights of the bins it covers, padded to a multiple of 8 so every band is one contiguous Utilities::dotProduct(). Building them takes a log or two per bin, so it's done once per configuration and shared: every BandMapper prepare()d with the same FFT size, sample rate, scale, band count and range points at the same kernels.
+
+    COST:
+    - mapping a frame is a multiply-add per weight, and neighboring triangles overlap, so it's about twice the number of bins between minFreq and maxFreq. for a 2048 point FFT, that's a few percent of the FFT itself
+
+    NOTE:
+    - prepare() builds or looks up the kernels under a lock and can allocate, so call it from prepareToPlay(). process() doesn't allocate or lock
+    - minFreq and maxFreq are the outer edges of the lowest and highest bands, not their centers
+    - kernels no BandMapper uses anymore are freed the next time any BandMapper is prepare()d
+
+ */
+
+namespace atec
+{
+    #define BANDMAPPERDEFAULTNUMBANDS 64
+    #define BANDMAPPERDEFAULTMINFREQ 27.5
+    #define BANDMAPPERDEFAULTMAXFREQ 16000.0
+
+    class BandMapper
+    {
+    public:
+        enum Scale
+        {
+            constantQ,
+            mel,
+            bark
+        };
+
+        BandMapper();
+        ~BandMapper();
+
+        void debug(bool d);
+        void prepare(int fftSize, double sampleRate, Scale scale, int numBands, double minFreq, double maxFreq);
+        void process(const float* spectrum, float* bands);
+        void process(const juce::dsp::Complex<float>* spectrum, float* bands);
+        int getNumBands();
+        int getFftSize();
+        Scale getScale();
+        float getCenterFreq(int band);
+        int getNumWeights();
+        static int getNumSharedKernels();
+
+    private:
+        // everything one configuration needs. immutable once built, so any number of BandMappers can read it at once
+        struct Kernels : public juce::ReferenceCountedObject
+        {
+            using Ptr = juce::ReferenceCountedObjectPtr<Kernels>;
+
+            int fftSize = 0;
+            double sampleRate = 0.0;
+            Scale scale = constantQ;
+            int numBands = 0;
+            double minFreq = 0.0;
+            double maxFreq = 0.0;
+
+            // every band's weights back to back. each band starts at offsets[band] and covers bins starts[band] to starts[band] + lengths[band] - 1
+            juce::HeapBlock<float> weights;
+            juce::HeapBlock<int> offsets;
+            juce::HeapBlock<int> starts;
+            juce::HeapBlock<int> lengths;
+            juce::HeapBlock<float> centerFreqs;
+            int numWeights = 0;
+        };
+
+        static Kernels::Ptr getKernels(int fftSize, double sampleRate, Scale scale, int numBands, double minFreq, double maxFreq);
+        static Kernels* buildKernels(int fftSize, double sampleRate, Scale scale, int numBands, double minFreq, double maxFreq);
+        static juce::ReferenceCountedArray<Kernels>& getKernelCache();
+        static juce::CriticalSection& getKernelCacheLock();
+        static double hzToScale(double hz, Scale scale);
+        static double scaleToHz(double value, Scale scale);
+
+        Kernels::Ptr mKernels;
+        juce::HeapBlock<float> mMag;
+        int mFftSize;
+        int mNumBins;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,325 @@
+namespace atec
+{
+PhaseVocoder::PhaseVocoder()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+
+    mTimeStretch = 1.0;
+    mPitchRatio = 1.0;
+    mOutputScale = 1.0f;
+    mFftSize = 0;
+    mNumBins = 0;
+    mOverlap = PVDEFAULTOVERLAP;
+    mAnalysisHop = 0;
+    mSynthesisHop = 0;
+    mFormantPreservation = false;
+    mFirstFrame = true;
+
+    if(mDebugFlag)
+        DBG("PhaseVocoder constructor called");
+}
+
+PhaseVocoder::~PhaseVocoder()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("PhaseVocoder destructor called");
+}
+
+void PhaseVocoder::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the FFT buffer, window and every per-bin array come from arena at the next prepare(). only the juce::dsp::FFT object itself stays on the heap
+void PhaseVocoder::setArena(AudioArena* arena)
+{
+    mArena = arena;
+}
+
+// fftSize must be a power of 2 for juce::dsp::FFT. allocates everything, so call from prepareToPlay()
+void PhaseVocoder::prepare(int fftSize, int overlap)
+{
+    double sumOfSquares = 0.0;
+
+    jassert(juce::isPowerOfTwo(fftSize));
+    jassert(overlap >= 4); // hann^2 windows only sum to a constant from an overlap of 4 up
+
+    mFftSize = fftSize;
+    mNumBins = (mFftSize / 2) + 1;
+    mOverlap = overlap;
+    mSynthesisHop = mFftSize / mOverlap;
+
+    mFFT.reset(new juce::dsp::FFT((int)std::log2(mFftSize)));
+    mFftBuf.allocate(mArena, (size_t)mFftSize * 2);
+
+    // one extra point, so the first mFftSize points are a periodic window
+    mWindow.allocate(mArena, (size_t)mFftSize + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(mWindow.get(), (size_t)mFftSize + 1, juce::dsp::WindowingFunction<float>::hann, false);
+
+    // with the same window in and out, overlapped frames sum to sumOfSquares/hop. outputOlaBlock() divides by the overlap, so scale that back to 1
+    for(int i = 0; i < mFftSize; i++)
+        sumOfSquares += mWindow[i] * mWindow[i];
+
+    mOutputScale = (float)(mFftSize / sumOfSquares);
+
+    mMag.allocate(mArena, (size_t)mNumBins);
+    mPhase.allocate(mArena, (size_t)mNumBins);
+    mPrevPhase.allocate(mArena, (size_t)mNumBins);
+    mBinFreq.allocate(mArena, (size_t)mNumBins);
+    mInstFreq.allocate(mArena, (size_t)mNumBins);
+    mOutMag.allocate(mArena, (size_t)mNumBins);
+    mOutPhase.allocate(mArena, (size_t)mNumBins);
+    mSynthPhase.allocate(mArena, (size_t)mNumBins);
+    mEnvIn.allocate(mArena, (size_t)mNumBins);
+    mEnvOut.allocate(mArena, (size_t)mNumBins);
+    mSmoothScratch.allocate(mArena, (size_t)mNumBins + 1);
+    mPeaks.allocate(mArena, (size_t)mNumBins);
+
+    // each bin's center frequency in radians per sample
+    for(int k = 0; k < mNumBins; k++)
+        mBinFreq[k] = (float)(juce::MathConstants<double>::twoPi * k / mFftSize);
+
+    setTimeStretch(mTimeStretch);
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "PhaseVocoder prepare. mFftSize: " + std::to_string(mFftSize) + ", mSynthesisHop: " + std::to_string(mSynthesisHop);
+        DBG(post);
+    }
+}
+
+// forget the phase history. the next frame starts over with its own phases
+void PhaseVocoder::init()
+{
+    if(mNumBins == 0)
+        return;
+
+    juce::FloatVectorOperations::clear(mPrevPhase.get(), mNumBins);
+    juce::FloatVectorOperations::clear(mSynthPhase.get(), mNumBins);
+    mFirstFrame = true;
+}
+
+// frame is fftSize raw input samples, and gets replaced by the windowed output frame
+void PhaseVocoder::processFrame(float* frame)
+{
+    juce::dsp::Complex<float>* spectrum = reinterpret_cast<juce::dsp::Complex<float>*>(mFftBuf.get());
+    const float* binFreq = mBinFreq.get();
+    float* mag = mMag.get();
+    float* phase = mPhase.get();
+    float* prevPhase = mPrevPhase.get();
+    float* instFreq = mInstFreq.get();
+    float* outMag = mOutMag.get();
+    float* outPhase = mOutPhase.get();
+    float* synthPhase = mSynthPhase.get();
+    float ratio = (float)mPitchRatio;
+    float analysisHop = (float)mAnalysisHop;
+    float synthesisHop = (float)mSynthesisHop;
+    int numPeaks;
+    int regionStart = 0;
+
+    jassert(mFFT != nullptr); // call prepare() first
+
+    juce::FloatVectorOperations::multiply(mFftBuf.get(), frame, mWindow.get(), mFftSize);
+    juce::FloatVectorOperations::clear(mFftBuf.get() + mFftSize, mFftSize);
+    mFFT->performRealOnlyForwardTransform(mFftBuf.get(), true);
+
+    Utilities::getFftMagSpec(spectrum, mag, mFftSize);
+    Utilities::getFftPhaseSpec(spectrum, phase, mFftSize);
+
+    if(mFirstFrame)
+    {
+        // nothing to measure against yet. start the output phases from the input's
+        juce::FloatVectorOperations::copy(instFreq, binFreq, mNumBins);
+        juce::FloatVectorOperations::copy(synthPhase, phase, mNumBins);
+
+        for(int k = 0; k < mNumBins; k++)
+            synthPhase[k] -= instFreq[k] * synthesisHop;
+
+        mFirstFrame = false;
+    }
+    else
+    {
+        // the phase advance beyond what the bin's center frequency accounts for, wrapped, gives the instantaneous frequency
+        for(int k = 0; k < mNumBins; k++)
+        {
+            float deviation = Utilities::wrapPhase(phase[k] - prevPhase[k] - binFreq[k] * analysisHop);
+
+            instFreq[k] = binFreq[k] + deviation / analysisHop;
+        }
+    }
+
+    juce::FloatVectorOperations::copy(prevPhase, phase, mNumBins);
+
+    // bins no peak region lands on are silent. keep their phases running at the bin center, in case a peak moves there next frame
+    juce::FloatVectorOperations::clear(outMag, mNumBins);
+    for(int k = 0; k < mNumBins; k++)
+        outPhase[k] = synthPhase[k] + binFreq[k] * synthesisHop;
+
+    numPeaks = findPeaks();
+
+    for(int i = 0; i < numPeaks; i++)
+    {
+        int peak = mPeaks[i];
+        int regionEnd = mNumBins - 1;
+        int target, shift, firstBin, lastBin;
+        float rotation;
+
+        // the region ends at the quietest bin before the next peak
+        if(i + 1 < numPeaks)
+        {
+            regionEnd = peak;
+
+            for(int k = peak + 1; k < mPeaks[i + 1]; k++)
+                if(mag[k] < mag[regionEnd])
+                    regionEnd = k;
+        }
+
+        target = (int)(peak * ratio + 0.5f);
+        shift = target - peak;
+
+        // propagate the peak's phase at its shifted frequency, then rotate its whole region by the same amount (identity phase locking)
+        if(target > 0 && target < mNumBins - 1)
+        {
+            rotation = (synthPhase[target] + instFreq[peak] * ratio * synthesisHop) - phase[peak];
+            firstBin = juce::jmax(regionStart, -shift);
+            lastBin = juce::jmin(regionEnd, mNumBins - 1 - shift);
+
+            for(int k = firstBin; k <= lastBin; k++)
+            {
+                outMag[k + shift] += mag[k];
+                outPhase[k + shift] = phase[k] + rotation;
+            }
+        }
+
+        regionStart = regionEnd + 1;
+    }
+
+    // put the original envelope back on the shifted peaks
+    if(mFormantPreservation && mPitchRatio != 1.0)
+    {
+        float* envIn = mEnvIn.get();
+        float* envOut = mEnvOut.get();
+
+        smoothSpectrum(mag, envIn);
+        smoothSpectrum(outMag, envOut);
+
+        for(int k = 0; k < mNumBins; k++)
+            outMag[k] *= juce::jmin(envIn[k] / (envOut[k] + 1e-9f), PVMAXFORMANTGAIN);
+    }
+
+    // wrapping every frame keeps the running phases small enough for float precision
+    Utilities::wrapPhase(outPhase, synthPhase, mNumBins);
+    Utilities::polarToCartesian(outMag, synthPhase, spectrum, mFftSize);
+
+    mFFT->performRealOnlyInverseTransform(mFftBuf.get());
+
+    juce::FloatVectorOperations::multiply(frame, mFftBuf.get(), mWindow.get(), mFftSize);
+    juce::FloatVectorOperations::multiply(frame, mOutputScale, mFftSize);
+}
+
+// local maxima over +/-2 bins, above PVPEAKTHRESHDB relative to the loudest bin. returns how many went into mPeaks, lowest first
+int PhaseVocoder::findPeaks()
+{
+    const float* mag = mMag.get();
+    float maxMag = 0.0f;
+    float thresh;
+    int numPeaks = 0;
+
+    for(int k = 0; k < mNumBins; k++)
+        maxMag = juce::jmax(maxMag, mag[k]);
+
+    thresh = maxMag * juce::Decibels::decibelsToGain(PVPEAKTHRESHDB);
+
+    for(int k = 2; k < mNumBins - 2; k++)
+        if(mag[k] > thresh && mag[k] > mag[k - 1] && mag[k] >= mag[k + 1] && mag[k] > mag[k - 2] && mag[k] >= mag[k + 2])
+            mPeaks[numPeaks++] = k;
+
+    return numPeaks;
+}
+
+// two passes of a moving average, from running sums. the sums are doubles, since a narrow window's sum can be tiny next to the running total
+void PhaseVocoder::smoothSpectrum(const float* in, float* out)
+{
+    double* sums = mSmoothScratch.get();
+    int halfWidth = juce::jmax(1, mFftSize / PVFORMANTSMOOTHDIVISOR / 2);
+    const float* src = in;
+
+    for(int pass = 0; pass < 2; pass++)
+    {
+        sums[0] = 0.0;
+        for(int k = 0; k < mNumBins; k++)
+            sums[k + 1] = sums[k] + src[k];
+
+        for(int k = 0; k < mNumBins; k++)
+        {
+            int low = juce::jmax(0, k - halfWidth);
+            int high = juce::jmin(mNumBins - 1, k + halfWidth);
+
+            out[k] = (float)((sums[high + 1] - sums[low]) / (double)(high - low + 1));
+        }
+
+        src = out;
+    }
+}
+
+// output duration/input duration. 2 plays twice as long. changes the analysis hop only, so it can change between any two frames
+void PhaseVocoder::setTimeStretch(double stretch)
+{
+    jassert(stretch > 0.0);
+
+    mTimeStretch = stretch;
+
+    if(mSynthesisHop > 0)
+        mAnalysisHop = juce::jlimit(1, mFftSize / 2, juce::roundToInt(mSynthesisHop / mTimeStretch));
+}
+
+double PhaseVocoder::getTimeStretch()
+{
+    return mTimeStretch;
+}
+
+// output frequency/input frequency
+void PhaseVocoder::setPitchRatio(double ratio)
+{
+    jassert(ratio > 0.0);
+
+    mPitchRatio = ratio;
+}
+
+// in semitones
+void PhaseVocoder::setTranspo(double transpo)
+{
+    setPitchRatio(std::pow(2.0, transpo / 12.0));
+}
+
+double PhaseVocoder::getPitchRatio()
+{
+    return mPitchRatio;
+}
+
+void PhaseVocoder::setFormantPreservation(bool shouldPreserve)
+{
+    mFormantPreservation = shouldPreserve;
+}
+
+int PhaseVocoder::getFftSize()
+{
+    return mFftSize;
+}
+
+// how far the caller should move its input read position between frames
+int PhaseVocoder::getAnalysisHop()
+{
+    return mAnalysisHop;
+}
+
+// how far apart the output frames should be overlap-added
+int PhaseVocoder::getSynthesisHop()
+{
+    return mSynthesisHop;
+}
+} // namespace atec
@@ -0,0 +1,95 @@
+/*
+
+    A phase vocoder for time stretching and pitch shifting, one frame at a time. It's meant to sit inside the OlaBufferStereo framing (or any overlap-add loop), with one PhaseVocoder per audio channel.
+
+    Each frame goes through getFftMagSpec()/getFftPhaseSpec(), and every bin's instantaneous frequency is estimated from its phase advance over the analysis hop. Then, with identity phase locking (Laroche and Dolson), only the spectral peaks get their phase propagated over the synthesis hop. Every other bin keeps its original phase offset from the peak whose region it belongs to, which keeps the "phasiness" of the plain phase vocoder down. Pitch shifting moves each peak's whole region up or down by a whole number of bins, and runs the peak's phase at the shifted frequency, so no resampling is needed.
+
+    All the per-bin work (unwrapping, instantaneous frequency, region copies, polar to cartesian) is straight loops over float arrays, and the sin/cos/atan2 are branch-free polynomials from Utilities. Only peak picking is a scalar scan.
+
+    TIME STRETCHING:
+    - the synthesis hop is fixed at fftSize/overlap. setTimeStretch() sets the analysis hop to synthesis hop/stretch, and can be changed between any two frames without allocating
+    - the caller moves its read position by getAnalysisHop() between frames, and overlap-adds the output at getSynthesisHop(). OlaBufferStereo reads its input at the same hop it writes, so live input through OlaBufferStereo is always at a stretch of 1 (pitch shifting only)
+
+    FORMANTS:
+    - with setFormantPreservation(true), the shifted spectrum is reshaped to the unshifted spectral envelope, so voices don't get the chipmunk effect. the envelope is the magnitude spectrum smoothed over fftSize/PVFORMANTSMOOTHDIVISOR bins
+
+    NOTE:
+    - processFrame() takes the raw frame. don't call OlaBufferStereo::doWindowing() first: the vocoder applies its own Hann windows on the way in and out
+    - output frames are scaled for outputOlaBlock(). overlap-added at the synthesis hop and divided by the overlap, they sum to unity gain. overlap should be 4 or more
+    - everything is allocated in prepare(), so the memory footprint stays fixed afterward
+    - L and R run independently, so heavy pitch shifting can smear the stereo image a little
+
+ */
+
+#include "../buffering/atec_AudioArena.h"
+
+namespace atec
+{
+    #define PVDEFAULTFFTSIZE 4096
+    #define PVDEFAULTOVERLAP 4
+    // bins more than this far below the loudest bin in the frame can't be peaks
+    #define PVPEAKTHRESHDB -80.0f
+    #define PVFORMANTSMOOTHDIVISOR 128
+    // the most the formant correction will boost a bin, about 24 dB
+    #define PVMAXFORMANTGAIN 16.0f
+
+    class PhaseVocoder
+    {
+    public:
+        PhaseVocoder();
+        ~PhaseVocoder();
+
+        void debug(bool d);
+        void setArena(AudioArena* arena);
+        void prepare(int fftSize, int overlap);
+        void init();
+        void processFrame(float* frame);
+        void setTimeStretch(double stretch);
+        double getTimeStretch();
+        void setPitchRatio(double ratio);
+        void setTranspo(double transpo);
+        double getPitchRatio();
+        void setFormantPreservation(bool shouldPreserve);
+        int getFftSize();
+        int getAnalysisHop();
+        int getSynthesisHop();
+
+    private:
+        int findPeaks();
+        void smoothSpectrum(const float* in, float* out);
+
+        std::unique_ptr<juce::dsp::FFT> mFFT;
+        // 2 * fftSize floats, for juce::dsp::FFT to work in place
+        ArenaBlock<float> mFftBuf;
+        // periodic Hann, so the overlapped windows sum to a constant
+        ArenaBlock<float> mWindow;
+
+        // one value per bin, fftSize/2 + 1 of them
+        ArenaBlock<float> mMag;
+        ArenaBlock<float> mPhase;
+        ArenaBlock<float> mPrevPhase;
+        ArenaBlock<float> mBinFreq;
+        ArenaBlock<float> mInstFreq;
+        ArenaBlock<float> mOutMag;
+        ArenaBlock<float> mOutPhase;
+        ArenaBlock<float> mSynthPhase;
+        ArenaBlock<float> mEnvIn;
+        ArenaBlock<float> mEnvOut;
+        ArenaBlock<double> mSmoothScratch;
+        ArenaBlock<int> mPeaks;
+
+        double mTimeStretch;
+        double mPitchRatio;
+        float mOutputScale;
+        int mFftSize;
+        int mNumBins;
+        int mOverlap;
+        int mAnalysisHop;
+        int mSynthesisHop;
+        bool mFormantPreservation;
+        bool mFirstFrame;
+        // where prepare() carves the FFT buffer and the bin arrays from. nullptr for the heap
+        AudioArena* mArena;
+        bool mDebugFlag;
+    };
+} // namespace atec
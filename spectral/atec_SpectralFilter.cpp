@@ -0,0 +1,107 @@
+namespace atec
+{
+SpectralFilter::SpectralFilter()
+{
+    mDebugFlag = false;
+
+    mFftSize = 0;
+    mNumBins = 0;
+
+    if(mDebugFlag)
+        DBG("SpectralFilter constructor called");
+}
+
+SpectralFilter::~SpectralFilter()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("SpectralFilter destructor called");
+}
+
+void SpectralFilter::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// allocates all three copies of the curve and resets to unity gain. don't call while apply() or setGainCurve() could be running
+void SpectralFilter::prepare(int fftSize)
+{
+    mFftSize = fftSize;
+    mNumBins = (mFftSize / 2) + 1;
+
+    for(int i = 0; i < 3; i++)
+    {
+        mGainCurves.getSlot(i).allocate((size_t)(mNumBins * 2), false);
+        juce::FloatVectorOperations::fill(mGainCurves.getSlot(i).get(), 1.0f, mNumBins * 2);
+    }
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "SpectralFilter prepare. mFftSize: " + std::to_string(mFftSize) + ", mNumBins: " + std::to_string(mNumBins);
+        DBG(post);
+    }
+}
+
+// gains should be N/2+1 values long, one per non-negative frequency bin. any missing bins at the top hold the last gain
+void SpectralFilter::setGainCurve(const float* gains, int numGains)
+{
+    float* curvePtr = mGainCurves.getWriteBuffer().get();
+
+    jassert(numGains > 0);
+
+    for(int i = 0; i < mNumBins; i++)
+    {
+        float gain = gains[juce::jmin(i, numGains - 1)];
+
+        curvePtr[i*2] = gain;
+        curvePtr[i*2 + 1] = gain;
+    }
+
+    mGainCurves.publish();
+}
+
+// same layout as the filter argument to Utilities::fftApplyFilter(), so existing curves can be passed straight in
+void SpectralFilter::setGainCurve(const juce::Array<double>& gains)
+{
+    float* curvePtr = mGainCurves.getWriteBuffer().get();
+    int numGains = gains.size();
+
+    jassert(numGains > 0);
+
+    for(int i = 0; i < mNumBins; i++)
+    {
+        float gain = (float)gains.getUnchecked(juce::jmin(i, numGains - 1));
+
+        curvePtr[i*2] = gain;
+        curvePtr[i*2 + 1] = gain;
+    }
+
+    mGainCurves.publish();
+}
+
+void SpectralFilter::setUnityGain()
+{
+    juce::FloatVectorOperations::fill(mGainCurves.getWriteBuffer().get(), 1.0f, mNumBins * 2);
+
+    mGainCurves.publish();
+}
+
+// audio thread: filter the N/2+1 non-negative frequency bins in place, with the newest curve
+void SpectralFilter::apply(juce::dsp::Complex<float>* spectrum)
+{
+    mGainCurves.update();
+
+    juce::FloatVectorOperations::multiply(reinterpret_cast<float*>(spectrum), mGainCurves.getReadBuffer().get(), mNumBins * 2);
+}
+
+int SpectralFilter::getFftSize()
+{
+    return mFftSize;
+}
+
+int SpectralFilter::getNumBins()
+{
+    return mNumBins;
+}
+} // namespace atec
@@ -0,0 +1,43 @@
+/*
+
+    A reusable gain curve for filtering FFT frames in place. It replaces Utilities::fftApplyFilter() in per-frame processing.
+
+    The curve is converted once, when it's set, into interleaved float gains (g0, g0, g1, g1, ...) that line up with the interleaved complex bins. Applying it is then one juce::FloatVectorOperations::multiply() over the half spectrum, with no per-bin branching, double to float conversion or copying.
+
+    The GUI/message thread can change the curve at any time with setGainCurve(). The new curve goes through a TripleBuffer, so the audio thread picks it up on its next apply() without locking or allocating.
+
+    NOTE:
+    - prepare() allocates everything, so call it from prepareToPlay()
+    - only the N/2+1 non-negative frequency bins are filtered. that's all juce::dsp::FFT::performRealOnlyInverseTransform() reads, so the upper half can be ignored
+    - setGainCurve() must always be called from the same thread
+
+ */
+
+#include "../utilities/atec_TripleBuffer.h"
+
+namespace atec
+{
+    #define SPECTRALFILTERDEFAULTFFTSIZE 4096
+
+    class SpectralFilter
+    {
+    public:
+        SpectralFilter();
+        ~SpectralFilter();
+
+        void debug(bool d);
+        void prepare(int fftSize);
+        void setGainCurve(const float* gains, int numGains);
+        void setGainCurve(const juce::Array<double>& gains);
+        void setUnityGain();
+        void apply(juce::dsp::Complex<float>* spectrum);
+        int getFftSize();
+        int getNumBins();
+
+    private:
+        TripleBuffer<juce::HeapBlock<float>> mGainCurves;
+        int mFftSize;
+        int mNumBins;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,432 @@
+namespace atec
+{
+GranularEngine::GranularEngine()
+{
+    mDebugFlag = false;
+    mArena = nullptr;
+    mRingBuf.debug(mDebugFlag);
+
+    mSampleCount = 0;
+    mSampleRate = 48000.0;
+    mSamplesToNextGrain = 0.0;
+    mDensity = 20.0;
+    mGrainMs = 100.0;
+    mPitch = 0.0;
+    mPitchJitter = 0.0;
+    mDelayMs = 50.0;
+    mDelayJitterMs = 0.0;
+    mMaxDelayMs = 1000.0;
+    mMaxSnapMs = 5.0;
+    mPanSpread = 0.0f;
+    mGain = 1.0f;
+    mWindowShape = juce::dsp::WindowingFunction<float>::hann;
+    mNumChannels = 0;
+    mMaxBlockSize = 0;
+    mMaxGrains = 0;
+    mNumActive = 0;
+    mNumDropped = 0;
+    mNumZcPositions = 0;
+    mZcPositionOffset = 0;
+    mSnapToZeroCrossings = false;
+
+    if(mDebugFlag)
+        DBG("GranularEngine constructor called");
+}
+
+GranularEngine::~GranularEngine()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("GranularEngine destructor called");
+}
+
+void GranularEngine::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// the input history and the window tables come from arena from the next prepare() on. per-voice state stays on the heap
+void GranularEngine::setArena(AudioArena* arena)
+{
+    mArena = arena;
+    mRingBuf.setArena(arena);
+}
+
+// allocates the grain pool, ring buffer and window tables. call from prepareToPlay()
+void GranularEngine::prepare(double sampleRate, int numChannels, int maxBlockSize, int maxGrains, double maxDelayMs)
+{
+    int maxDelaySamps;
+
+    mSampleRate = sampleRate;
+    mNumChannels = numChannels;
+    mMaxBlockSize = maxBlockSize;
+    mMaxGrains = juce::jmax(1, maxGrains);
+    mMaxDelayMs = maxDelayMs;
+
+    // twice the delay range leaves room for grains pitched down to fall behind their start without being overwritten
+    maxDelaySamps = (int)std::ceil(mMaxDelayMs * 0.001 * mSampleRate);
+    mRingBuf.setSize(mNumChannels, (maxDelaySamps * 2) + (mMaxBlockSize * 4), mMaxBlockSize);
+
+    AudioArena::setBufferSize(mArena, mWindowTables, mWindowTablesReservation, juce::dsp::WindowingFunction<float>::numWindowingMethods, GRANULARWINDOWTABLESIZE + 1);
+    for(int shape = 0; shape < juce::dsp::WindowingFunction<float>::numWindowingMethods; shape++)
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(mWindowTables.getWritePointer(shape), GRANULARWINDOWTABLESIZE + 1, (juce::dsp::WindowingFunction<float>::WindowingMethod)shape, false);
+
+    mReadPos.allocate((size_t)mMaxGrains, true);
+    mIncrement.allocate((size_t)mMaxGrains, true);
+    mWindowPos.allocate((size_t)mMaxGrains, true);
+    mWindowInc.allocate((size_t)mMaxGrains, true);
+    mGainL.allocate((size_t)mMaxGrains, true);
+    mGainR.allocate((size_t)mMaxGrains, true);
+    mGrainWindow.allocate((size_t)mMaxGrains, true);
+    mGrainChannel.allocate((size_t)mMaxGrains, true);
+
+    mReadIdx.allocate((size_t)mMaxGrains, true);
+    mReadFrac.allocate((size_t)mMaxGrains, true);
+    mWindowIdx.allocate((size_t)mMaxGrains, true);
+    mWindowFrac.allocate((size_t)mMaxGrains, true);
+    mSampA.allocate((size_t)mMaxGrains, true);
+    mSampB.allocate((size_t)mMaxGrains, true);
+    mWinA.allocate((size_t)mMaxGrains, true);
+    mWinB.allocate((size_t)mMaxGrains, true);
+    mGrainOut.allocate((size_t)mMaxGrains, true);
+
+    mZeroCrossings.prepare(1);
+    mZcScratch.allocate((size_t)GRANULARZCCAPACITY, true);
+    mZcPositions.allocate((size_t)GRANULARZCCAPACITY, true);
+
+    init();
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "GranularEngine prepare. mMaxGrains: " + std::to_string(mMaxGrains) + ", ring buffer size: " + std::to_string(mRingBuf.getSize());
+        DBG(post);
+    }
+}
+
+// silence every grain and forget the input history
+void GranularEngine::init()
+{
+    mRingBuf.init();
+    mZeroCrossings.init();
+
+    mSampleCount = 0;
+    mSamplesToNextGrain = 0.0;
+    mNumActive = 0;
+    mNumDropped = 0;
+    mNumZcPositions = 0;
+    mZcPositionOffset = 0;
+}
+
+void GranularEngine::process(juce::AudioBuffer<float>& buffer)
+{
+    int numSamps = buffer.getNumSamples();
+
+    jassert(numSamps <= mMaxBlockSize);
+
+    // advance right away, so grains can read right up to the newest input sample
+    mRingBuf.write(buffer);
+
+    if(mSnapToZeroCrossings)
+    {
+        int numFound = mZeroCrossings.process(0, buffer.getReadPointer(0), numSamps, mZcScratch.get(), GRANULARZCCAPACITY);
+        int numKept = juce::jmin(mNumZcPositions, GRANULARZCCAPACITY - numFound);
+
+        // keep the newest GRANULARZCCAPACITY crossings, still in order
+        if(numKept < mNumZcPositions)
+            std::memmove(mZcPositions.get(), mZcPositions.get() + (mNumZcPositions - numKept), sizeof(juce::int64) * (size_t)numKept);
+
+        // the detector counts from its last restart, the grains from init()
+        for(int i = 0; i < numFound; i++)
+            mZcPositions[numKept + i] = mZcScratch[i] + mZcPositionOffset;
+
+        mNumZcPositions = numKept + numFound;
+    }
+
+    // onsets can fall anywhere in the block, fractions included
+    if(mDensity > 0.0)
+    {
+        while(mSamplesToNextGrain < (double)numSamps)
+        {
+            spawnGrain(mSamplesToNextGrain);
+            mSamplesToNextGrain += mSampleRate / mDensity;
+        }
+
+        mSamplesToNextGrain -= (double)numSamps;
+    }
+
+    buffer.clear();
+    renderGrains(buffer, numSamps);
+
+    mSampleCount += numSamps;
+}
+
+// start a grain blockOffset samples into the current block
+void GranularEngine::spawnGrain(double blockOffset)
+{
+    int ringSize = mRingBuf.getSize();
+    double grainSamps = juce::jmax(1.0, mGrainMs * 0.001 * mSampleRate);
+    double transpo = mPitch + (mPitchJitter * ((mRandom.nextFloat() * 2.0) - 1.0));
+    double ratio = std::pow(2.0, transpo / 12.0);
+    double delaySamps = (mDelayMs + (mDelayJitterMs * mRandom.nextFloat())) * 0.001 * mSampleRate;
+    // a grain pitched up must start far enough back that it never overtakes the input. pitched down, it must not fall behind the oldest sample
+    double minDelay = juce::jmax(0.0, (ratio - 1.0) * grainSamps) + 2.0;
+    double maxDelay = (double)(ringSize - mMaxBlockSize - 2) - juce::jmax(0.0, (1.0 - ratio) * grainSamps);
+    double onset, startPos, pan;
+    int grain;
+
+    if(mNumActive >= mMaxGrains || minDelay > maxDelay)
+    {
+        mNumDropped++;
+        return;
+    }
+
+    delaySamps = juce::jlimit(minDelay, maxDelay, delaySamps);
+
+    // the absolute sample count this grain starts reading from
+    onset = (double)mSampleCount + blockOffset;
+    startPos = onset - delaySamps;
+
+    if(mSnapToZeroCrossings && mNumZcPositions > 0)
+    {
+        double snapped = (double)snapToZeroCrossing((juce::int64)std::floor(startPos));
+
+        // only move as far as the snap range, and never closer to the input than minDelay
+        if(std::abs(snapped - startPos) <= mMaxSnapMs * 0.001 * mSampleRate && onset - snapped >= minDelay && onset - snapped <= maxDelay)
+            startPos = snapped;
+    }
+
+    grain = mNumActive++;
+
+    // back both positions up to the start of the block, so the grain comes in exactly at blockOffset
+    mIncrement[grain] = ratio;
+    mReadPos[grain] = std::fmod(startPos - (blockOffset * ratio), (double)ringSize);
+    if(mReadPos[grain] < 0.0)
+        mReadPos[grain] += ringSize;
+
+    mWindowInc[grain] = (float)(1.0 / grainSamps);
+    mWindowPos[grain] = (float)(-blockOffset / grainSamps);
+
+    pan = ((mRandom.nextFloat() * 2.0) - 1.0) * mPanSpread;
+    pan = (pan + 1.0) * juce::MathConstants<double>::pi * 0.25;
+    mGainL[grain] = mGain * (float)std::cos(pan);
+    mGainR[grain] = mGain * (float)std::sin(pan);
+
+    mGrainWindow[grain] = mWindowTables.getReadPointer(mWindowShape);
+    mGrainChannel[grain] = (mNumChannels > 1) ? mRandom.nextInt(mNumChannels) : 0;
+}
+
+// the stored crossing closest to position, by binary search. the crossings are always in order
+juce::int64 GranularEngine::snapToZeroCrossing(juce::int64 position)
+{
+    const juce::int64* zc = mZcPositions.get();
+    int low = 0;
+    int high = mNumZcPositions - 1;
+
+    while(low < high)
+    {
+        int mid = (low + high) / 2;
+
+        if(zc[mid] < position)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if(low > 0 && (position - zc[low - 1]) < (zc[low] - position))
+        low--;
+
+    return zc[low];
+}
+
+void GranularEngine::renderGrains(juce::AudioBuffer<float>& buffer, int numSamps)
+{
+    float* outL = buffer.getWritePointer(0);
+    float* outR = (buffer.getNumChannels() > 1) ? buffer.getWritePointer(1) : nullptr;
+    int ringSize = mRingBuf.getSize();
+    int numActive = mNumActive;
+
+    double* readPos = mReadPos.get();
+    double* increment = mIncrement.get();
+    float* windowPos = mWindowPos.get();
+    float* windowInc = mWindowInc.get();
+    float* gainL = mGainL.get();
+    float* gainR = mGainR.get();
+    int* readIdx = mReadIdx.get();
+    float* readFrac = mReadFrac.get();
+    int* windowIdx = mWindowIdx.get();
+    float* windowFrac = mWindowFrac.get();
+    float* sampA = mSampA.get();
+    float* sampB = mSampB.get();
+    float* winA = mWinA.get();
+    float* winB = mWinB.get();
+    float* grainOut = mGrainOut.get();
+
+    for(int samp = 0; samp < numSamps; samp++)
+    {
+        float sumL = 0.0f;
+        float sumR = 0.0f;
+
+        // split read and window positions. window positions outside [0, 1) (not started yet, or finished) clamp to the table ends, and get masked below.
+        // the clamp is on the integer index, since a float select here would keep the compiler from vectorizing the loop
+        for(int g = 0; g < numActive; g++)
+        {
+            float tablePos = windowPos[g] * (float)GRANULARWINDOWTABLESIZE;
+
+            readIdx[g] = (int)readPos[g];
+            readFrac[g] = (float)(readPos[g] - (double)readIdx[g]);
+            windowIdx[g] = juce::jlimit(0, GRANULARWINDOWTABLESIZE - 1, (int)tablePos);
+            windowFrac[g] = tablePos - (float)windowIdx[g];
+        }
+
+        // the only scalar part: each grain reads from its own place in the ring buffer and its own window table
+        for(int g = 0; g < numActive; g++)
+        {
+            const float* ringPtr = mRingBuf.getReadPointer(mGrainChannel[g]);
+            int nextIdx = readIdx[g] + 1;
+
+            sampA[g] = ringPtr[readIdx[g]];
+            sampB[g] = ringPtr[(nextIdx < ringSize) ? nextIdx : 0];
+            winA[g] = mGrainWindow[g][windowIdx[g]];
+            winB[g] = mGrainWindow[g][windowIdx[g] + 1];
+        }
+
+        for(int g = 0; g < numActive; g++)
+        {
+            float s = sampA[g] + readFrac[g] * (sampB[g] - sampA[g]);
+            float w = winA[g] + windowFrac[g] * (winB[g] - winA[g]);
+            float alive = (windowPos[g] >= 0.0f && windowPos[g] < 1.0f) ? 1.0f : 0.0f;
+
+            grainOut[g] = s * w * alive;
+
+            windowPos[g] += windowInc[g];
+            readPos[g] += increment[g];
+            readPos[g] -= (readPos[g] >= (double)ringSize) ? (double)ringSize : 0.0;
+        }
+
+        for(int g = 0; g < numActive; g++)
+        {
+            sumL += grainOut[g] * gainL[g];
+            sumR += grainOut[g] * gainR[g];
+        }
+
+        outL[samp] = sumL;
+        if(outR != nullptr)
+            outR[samp] = sumR;
+    }
+
+    // free the grains whose windows have finished. backwards, since removing moves the last grain into the gap
+    for(int g = mNumActive - 1; g >= 0; g--)
+        if(windowPos[g] >= 1.0f)
+            removeGrain(g);
+}
+
+// swap the last active grain into this slot
+void GranularEngine::removeGrain(int grain)
+{
+    int last = mNumActive - 1;
+
+    if(grain != last)
+    {
+        mReadPos[grain] = mReadPos[last];
+        mIncrement[grain] = mIncrement[last];
+        mWindowPos[grain] = mWindowPos[last];
+        mWindowInc[grain] = mWindowInc[last];
+        mGainL[grain] = mGainL[last];
+        mGainR[grain] = mGainR[last];
+        mGrainWindow[grain] = mGrainWindow[last];
+        mGrainChannel[grain] = mGrainChannel[last];
+    }
+
+    mNumActive--;
+}
+
+void GranularEngine::setDensity(double grainsPerSec)
+{
+    mDensity = grainsPerSec;
+}
+
+void GranularEngine::setGrainMs(double ms)
+{
+    mGrainMs = ms;
+}
+
+void GranularEngine::setPitch(double transpo)
+{
+    mPitch = transpo;
+}
+
+// grains are transposed by up to +/- transpo semitones at random
+void GranularEngine::setPitchJitter(double transpo)
+{
+    mPitchJitter = transpo;
+}
+
+// how far behind the input each grain starts reading
+void GranularEngine::setDelayMs(double ms)
+{
+    mDelayMs = juce::jlimit(0.0, mMaxDelayMs, ms);
+}
+
+// grains start up to ms further back at random
+void GranularEngine::setDelayJitterMs(double ms)
+{
+    mDelayJitterMs = ms;
+}
+
+// 0 keeps every grain in the center, 1 spreads them at random across the whole stereo field
+void GranularEngine::setPanSpread(float spread)
+{
+    mPanSpread = juce::jlimit(0.0f, 1.0f, spread);
+}
+
+void GranularEngine::setGain(float gain)
+{
+    mGain = gain;
+}
+
+void GranularEngine::setWindowShape(juce::dsp::WindowingFunction<float>::WindowingMethod shape)
+{
+    mWindowShape = (int)shape;
+}
+
+void GranularEngine::setZeroCrossingSnap(bool shouldSnap, double maxSnapMs)
+{
+    if(shouldSnap && !mSnapToZeroCrossings)
+    {
+        // start over, since the detector missed everything while snapping was off. its positions restart at 0, so remember where that is on the sample count
+        mZeroCrossings.init();
+        mNumZcPositions = 0;
+        mZcPositionOffset = mSampleCount;
+    }
+
+    mSnapToZeroCrossings = shouldSnap;
+    mMaxSnapMs = maxSnapMs;
+}
+
+// the same seed and settings always give the same grains, for reproducible offline renders
+void GranularEngine::setSeed(juce::uint64 seed)
+{
+    mRandom.setSeed(seed);
+}
+
+int GranularEngine::getNumActiveGrains()
+{
+    return mNumActive;
+}
+
+int GranularEngine::getMaxGrains()
+{
+    return mMaxGrains;
+}
+
+int GranularEngine::getNumDroppedGrains()
+{
+    return mNumDropped;
+}
+
+const atec::RingBuffer& GranularEngine::getRingBufRef()
+{
+    return mRingBuf;
+}
+} // namespace atec
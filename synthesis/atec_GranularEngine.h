@@ -0,0 +1,124 @@
+/*
+
+    Live granular synthesis over a RingBuffer of the input, for thousands of overlapping grains.
+
+    Instead of one readInterpSample() call per grain per sample, every grain lives in a preallocated pool, kept in structure-of-arrays form with the active grains packed at the front. Each output sample then runs a few straight loops across all active grains: split the read and window positions, gather from the ring buffer and the window table, then interpolate, window and advance. So the cost is a fixed amount per grain per sample, and scales linearly with density * grain length.
+
+    Windows come from cached tables, one per juce::dsp::WindowingFunction method, filled once in prepare(). Each grain keeps a pointer to the table it started with, so changing the shape never touches running grains.
+
+    Grains are scheduled sample-accurately, even at fractional sample positions. A grain due partway through a block starts with its window and read positions backed up by that offset, so it's silent until exactly its onset, without any per-grain branching.
+
+    ZERO CROSSING SNAP:
+    - with setZeroCrossingSnap(), each grain start is moved to the nearest zero crossing of input channel 0 within the snap range, which avoids clicks when using rectangular-ish windows
+    - crossings come from a ZeroCrossingDetector running on the input, so they're found as the audio comes in, without any per-grain search of the buffer
+
+    NOTE:
+    - process() replaces the buffer contents (dry input) with the grains (wet). keep a copy of the dry signal if you want to mix
+    - a grain never reads past the newest input sample, so grains pitched up start further back than the delay setting when they need to. grains that can't fit in the ring buffer at all are dropped
+    - if the pool is full, new grains are dropped and counted in getNumDroppedGrains()
+    - float only, since the window tables come from juce::dsp::WindowingFunction<float> and the snap points from ZeroCrossingDetector, which both are. a double host converts to float around process()
+
+ */
+
+#include "../buffering/atec_RingBuffer.h"
+
+namespace atec
+{
+    #define GRANULARDEFAULTMAXGRAINS 4096
+    #define GRANULARWINDOWTABLESIZE 1024
+    #define GRANULARZCCAPACITY 1024
+
+    class GranularEngine
+    {
+    public:
+        GranularEngine();
+        ~GranularEngine();
+
+        void debug(bool d);
+        void prepare(double sampleRate, int numChannels, int maxBlockSize, int maxGrains, double maxDelayMs);
+        void setArena(AudioArena* arena);
+        void init();
+        void process(juce::AudioBuffer<float>& buffer);
+        void setDensity(double grainsPerSec);
+        void setGrainMs(double ms);
+        void setPitch(double transpo);
+        void setPitchJitter(double transpo);
+        void setDelayMs(double ms);
+        void setDelayJitterMs(double ms);
+        void setPanSpread(float spread);
+        void setGain(float gain);
+        void setWindowShape(juce::dsp::WindowingFunction<float>::WindowingMethod shape);
+        void setZeroCrossingSnap(bool shouldSnap, double maxSnapMs);
+        void setSeed(juce::uint64 seed);
+        int getNumActiveGrains();
+        int getMaxGrains();
+        int getNumDroppedGrains();
+        const atec::RingBuffer& getRingBufRef();
+
+    private:
+        void spawnGrain(double blockOffset);
+        juce::int64 snapToZeroCrossing(juce::int64 position);
+        void renderGrains(juce::AudioBuffer<float>& buffer, int numSamps);
+        void removeGrain(int grain);
+
+        RingBuffer mRingBuf;
+        ZeroCrossingDetector mZeroCrossings;
+        FastRandom mRandom;
+
+        // GRANULARWINDOWTABLESIZE + 1 points per shape, so interpolating at the very end never reads past the table
+        juce::AudioBuffer<float> mWindowTables;
+
+        // grain state, one entry per pool slot. slots [0, mNumActive) are the active grains
+        juce::HeapBlock<double> mReadPos;
+        juce::HeapBlock<double> mIncrement;
+        juce::HeapBlock<float> mWindowPos;
+        juce::HeapBlock<float> mWindowInc;
+        juce::HeapBlock<float> mGainL;
+        juce::HeapBlock<float> mGainR;
+        juce::HeapBlock<const float*> mGrainWindow;
+        juce::HeapBlock<int> mGrainChannel;
+
+        // per sample scratch, also one entry per slot
+        juce::HeapBlock<int> mReadIdx;
+        juce::HeapBlock<float> mReadFrac;
+        juce::HeapBlock<int> mWindowIdx;
+        juce::HeapBlock<float> mWindowFrac;
+        juce::HeapBlock<float> mSampA;
+        juce::HeapBlock<float> mSampB;
+        juce::HeapBlock<float> mWinA;
+        juce::HeapBlock<float> mWinB;
+        juce::HeapBlock<float> mGrainOut;
+
+        // the most recent zero crossings on channel 0, oldest first, as absolute sample counts
+        juce::HeapBlock<juce::int64> mZcScratch;
+        juce::HeapBlock<juce::int64> mZcPositions;
+        int mNumZcPositions;
+        // mSampleCount when the detector last restarted. its positions count from there
+        juce::int64 mZcPositionOffset;
+
+        juce::int64 mSampleCount;
+        double mSampleRate;
+        double mSamplesToNextGrain;
+        double mDensity;
+        double mGrainMs;
+        double mPitch;
+        double mPitchJitter;
+        double mDelayMs;
+        double mDelayJitterMs;
+        double mMaxDelayMs;
+        double mMaxSnapMs;
+        float mPanSpread;
+        float mGain;
+        int mWindowShape;
+        int mNumChannels;
+        int mMaxBlockSize;
+        int mMaxGrains;
+        int mNumActive;
+        int mNumDropped;
+        bool mSnapToZeroCrossings;
+        // set by setArena()
+        AudioArena* mArena;
+        AudioArena::Reservation mWindowTablesReservation;
+        bool mDebugFlag;
+    };
+} // namespace atec
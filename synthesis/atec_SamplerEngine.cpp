@@ -0,0 +1,312 @@
+namespace atec
+{
+SamplerEngine::SamplerEngine()
+{
+    mDebugFlag = false;
+
+    mSampleRate = 48000.0;
+    mReleaseMs = SAMPLERDEFAULTRELEASEMS;
+    mStartCounter = 0;
+    mNextVoiceId = 1;
+    mMaxVoices = 0;
+    mNumSlots = 0;
+    mNumActive = 0;
+    mNumPlaying = 0;
+    mNumStolen = 0;
+
+    if(mDebugFlag)
+        DBG("SamplerEngine constructor called");
+}
+
+SamplerEngine::~SamplerEngine()
+{
+    // using smart pointers only, so nothing to delete
+    if(mDebugFlag)
+        DBG("SamplerEngine destructor called");
+}
+
+void SamplerEngine::debug(bool d)
+{
+    mDebugFlag = d;
+}
+
+// allocates all voice state. call from prepareToPlay()
+void SamplerEngine::prepare(int maxVoices, double sampleRate)
+{
+    mMaxVoices = juce::jmax(1, maxVoices);
+    mSampleRate = sampleRate;
+
+    // spare slots for stolen voices to fade out in
+    mNumSlots = mMaxVoices + juce::jmax(1, mMaxVoices / 4);
+
+    mReadPos.allocate((size_t)mNumSlots, true);
+    mIncrement.allocate((size_t)mNumSlots, true);
+    mEnv.allocate((size_t)mNumSlots, true);
+    mEnvDelta.allocate((size_t)mNumSlots, true);
+    mGainL.allocate((size_t)mNumSlots, true);
+    mGainR.allocate((size_t)mNumSlots, true);
+    mSampleData.allocate((size_t)mNumSlots, true);
+    mLastIdx.allocate((size_t)mNumSlots, true);
+    mReleasing.allocate((size_t)mNumSlots, true);
+    mVoiceIds.allocate((size_t)mNumSlots, true);
+    mStartOrder.allocate((size_t)mNumSlots, true);
+
+    mReadIdx.allocate((size_t)mNumSlots, true);
+    mMu.allocate((size_t)mNumSlots, true);
+    mY0.allocate((size_t)mNumSlots, true);
+    mY1.allocate((size_t)mNumSlots, true);
+    mY2.allocate((size_t)mNumSlots, true);
+    mY3.allocate((size_t)mNumSlots, true);
+    mVoiceOut.allocate((size_t)mNumSlots, true);
+
+    mNumActive = 0;
+    mNumPlaying = 0;
+    mNumStolen = 0;
+
+    if(mDebugFlag)
+    {
+        std::string post;
+        post = "SamplerEngine prepare. mMaxVoices: " + std::to_string(mMaxVoices) + ", mNumSlots: " + std::to_string(mNumSlots);
+        DBG(post);
+    }
+}
+
+// returns the index to pass to startVoice(). allocates, so call while the engine isn't rendering
+int SamplerEngine::addSample(const juce::AudioBuffer<float>* sample, double sampleRate)
+{
+    SampleInfo info;
+
+    info.buffer = sample;
+    info.sampleRate = sampleRate;
+
+    mSamples.add(info);
+
+    return mSamples.size() - 1;
+}
+
+void SamplerEngine::clearSamples()
+{
+    mNumActive = 0;
+    mNumPlaying = 0;
+    mSamples.clear();
+}
+
+// start a voice playing sampleIndex, transposed by transpo semitones. pan goes from -1 (left) to 1 (right).
+// returns an id for stopVoice(), or 0 if the sample is empty
+juce::uint32 SamplerEngine::startVoice(int sampleIndex, double transpo, float gain, float pan)
+{
+    const SampleInfo& info = mSamples.getReference(sampleIndex);
+    int numSamps = info.buffer->getNumSamples();
+    float panAngle = (juce::jlimit(-1.0f, 1.0f, pan) + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+    int slot;
+
+    if(numSamps < 2)
+        return 0;
+
+    slot = allocateSlot();
+
+    mReadPos[slot] = 0.0;
+    // transpo2freqSampler() gives the phasor frequency for reading the whole sample, so scale it back up to samples per output sample
+    mIncrement[slot] = Utilities::transpo2freqSampler(transpo, numSamps, info.sampleRate) * (double)numSamps / mSampleRate;
+    mEnv[slot] = 1.0f;
+    mEnvDelta[slot] = 0.0f;
+    mGainL[slot] = gain * std::cos(panAngle);
+    mGainR[slot] = gain * std::sin(panAngle);
+    mSampleData[slot] = info.buffer->getReadPointer(0);
+    mLastIdx[slot] = numSamps - 1;
+    mReleasing[slot] = 0;
+    mVoiceIds[slot] = mNextVoiceId;
+    mStartOrder[slot] = mStartCounter++;
+
+    mNumPlaying++;
+
+    // 0 is reserved for "no voice"
+    if(++mNextVoiceId == 0)
+        mNextVoiceId = 1;
+
+    return mVoiceIds[slot];
+}
+
+// fade the voice out over the release time. does nothing if it already ended or was stolen
+void SamplerEngine::stopVoice(juce::uint32 voiceId)
+{
+    for(int slot = 0; slot < mNumActive; slot++)
+    {
+        if(mVoiceIds[slot] == voiceId && mReleasing[slot] == 0)
+        {
+            releaseSlot(slot, (int)(mReleaseMs * 0.001 * mSampleRate));
+            return;
+        }
+    }
+}
+
+void SamplerEngine::stopAllVoices()
+{
+    for(int slot = 0; slot < mNumActive; slot++)
+        if(mReleasing[slot] == 0)
+            releaseSlot(slot, (int)(mReleaseMs * 0.001 * mSampleRate));
+}
+
+void SamplerEngine::setReleaseMs(double ms)
+{
+    mReleaseMs = ms;
+}
+
+// add every active voice into outBuf, from startSample for numSamples
+void SamplerEngine::render(juce::AudioBuffer<float>& outBuf, int startSample, int numSamples)
+{
+    float* outL = outBuf.getWritePointer(0, startSample);
+    float* outR = (outBuf.getNumChannels() > 1) ? outBuf.getWritePointer(1, startSample) : nullptr;
+    int numActive = mNumActive;
+
+    double* readPos = mReadPos.get();
+    double* increment = mIncrement.get();
+    float* env = mEnv.get();
+    float* envDelta = mEnvDelta.get();
+    float* gainL = mGainL.get();
+    float* gainR = mGainR.get();
+    const int* lastIdx = mLastIdx.get();
+    int* readIdx = mReadIdx.get();
+    float* mu = mMu.get();
+    float* y0 = mY0.get();
+    float* y1 = mY1.get();
+    float* y2 = mY2.get();
+    float* y3 = mY3.get();
+    float* voiceOut = mVoiceOut.get();
+
+    for(int samp = 0; samp < numSamples; samp++)
+    {
+        float sumL = 0.0f;
+        float sumR = 0.0f;
+
+        // split every read position into integer and fractional parts
+        for(int v = 0; v < numActive; v++)
+        {
+            readIdx[v] = (int)readPos[v];
+            mu[v] = (float)(readPos[v] - (double)readIdx[v]);
+        }
+
+        // the only scalar part: each voice reads its own four points. clamp instead of wrapping, since samples are one-shot
+        for(int v = 0; v < numActive; v++)
+        {
+            const float* data = mSampleData[v];
+            int r1 = juce::jmin(readIdx[v], lastIdx[v]);
+
+            y0[v] = data[juce::jmax(r1 - 1, 0)];
+            y1[v] = data[r1];
+            y2[v] = data[juce::jmin(r1 + 1, lastIdx[v])];
+            y3[v] = data[juce::jmin(r1 + 2, lastIdx[v])];
+        }
+
+        // same cubic as Utilities::cubicInterpolate(), across all voices at once
+        for(int v = 0; v < numActive; v++)
+        {
+            float m = mu[v];
+            float m2 = m * m;
+            float a0 = y3[v] - y2[v] - y0[v] + y1[v];
+            float a1 = y0[v] - y1[v] - a0;
+            float a2 = y2[v] - y0[v];
+            float alive = (readPos[v] < (double)lastIdx[v]) ? 1.0f : 0.0f;
+
+            voiceOut[v] = (a0 * m * m2 + a1 * m2 + a2 * m + y1[v]) * env[v] * alive;
+
+            env[v] = juce::jmax(env[v] + envDelta[v], 0.0f);
+            readPos[v] += increment[v];
+        }
+
+        for(int v = 0; v < numActive; v++)
+        {
+            sumL += voiceOut[v] * gainL[v];
+            sumR += voiceOut[v] * gainR[v];
+        }
+
+        outL[samp] += sumL;
+        if(outR != nullptr)
+            outR[samp] += sumR;
+    }
+
+    // free the voices that ran off the end of their sample or finished fading. go backwards, since removing moves the last voice into the gap
+    for(int v = mNumActive - 1; v >= 0; v--)
+        if(readPos[v] >= (double)lastIdx[v] || (mReleasing[v] != 0 && env[v] <= 0.0f))
+            removeSlot(v);
+}
+
+// the next free slot, stealing one if all mMaxVoices are already playing
+int SamplerEngine::allocateSlot()
+{
+    if(mNumPlaying >= mMaxVoices)
+    {
+        int oldest = -1;
+
+        for(int slot = 0; slot < mNumActive; slot++)
+            if(mReleasing[slot] == 0 && (oldest < 0 || mStartOrder[slot] < mStartOrder[oldest]))
+                oldest = slot;
+
+        releaseSlot(oldest, SAMPLERSTEALFADESAMPS);
+        mNumStolen++;
+    }
+
+    if(mNumActive == mNumSlots)
+    {
+        int quietest = 0;
+
+        // every spare slot is busy fading out too, so cut the quietest of those short
+        for(int slot = 1; slot < mNumActive; slot++)
+            if(mReleasing[slot] != 0 && (mReleasing[quietest] == 0 || mEnv[slot] < mEnv[quietest]))
+                quietest = slot;
+
+        removeSlot(quietest);
+    }
+
+    return mNumActive++;
+}
+
+void SamplerEngine::releaseSlot(int slot, int fadeSamps)
+{
+    mReleasing[slot] = 1;
+    mEnvDelta[slot] = -mEnv[slot] / (float)juce::jmax(1, fadeSamps);
+    mNumPlaying--;
+}
+
+// swap the last active voice into this slot
+void SamplerEngine::removeSlot(int slot)
+{
+    int last = mNumActive - 1;
+
+    if(mReleasing[slot] == 0)
+        mNumPlaying--;
+
+    if(slot != last)
+    {
+        mReadPos[slot] = mReadPos[last];
+        mIncrement[slot] = mIncrement[last];
+        mEnv[slot] = mEnv[last];
+        mEnvDelta[slot] = mEnvDelta[last];
+        mGainL[slot] = mGainL[last];
+        mGainR[slot] = mGainR[last];
+        mSampleData[slot] = mSampleData[last];
+        mLastIdx[slot] = mLastIdx[last];
+        mReleasing[slot] = mReleasing[last];
+        mVoiceIds[slot] = mVoiceIds[last];
+        mStartOrder[slot] = mStartOrder[last];
+    }
+
+    mNumActive--;
+}
+
+// voices that are still playing or fading out
+int SamplerEngine::getNumActiveVoices()
+{
+    return mNumActive;
+}
+
+int SamplerEngine::getMaxVoices()
+{
+    return mMaxVoices;
+}
+
+int SamplerEngine::getNumStolenVoices()
+{
+    return mNumStolen;
+}
+} // namespace atec
@@ -0,0 +1,88 @@
+/*
+
+    Polyphonic sample playback for large voice counts (64-256), reading from shared juce::AudioBuffer sample data.
+
+    This is the same math as driving Utilities::bufReadInterp() by hand, once per voice per sample: transpo2freqSampler() for the increment and cubicInterpolate() for the read. But the voice state is kept in structure-of-arrays form, and the active voices are always packed at the front of those arrays. So for every output sample, the position update, interpolation and envelope run as straight loops across all the active voices, which the compiler vectorizes. Only gathering the four sample points is scalar, since each voice reads from its own place.
+
+    Voices are allocated and freed between blocks (startVoice()/stopVoice() from the audio thread, before render()). When all maxVoices are busy, the oldest voice is stolen. It gets a short fade instead of a hard cut, so there are a few spare slots beyond maxVoices for voices that are fading out.
+
+    NOTE:
+    - samples are played from their first channel, and each voice is panned (constant power) into a stereo output. a mono output gets the left side only
+    - samples are one-shot. a voice ends at the last sample or after its release, whichever comes first
+    - addSample() stores a pointer, so the sample buffer has to outlive the engine (or clearSamples())
+    - float only. the samples it plays are float AudioBuffers, so from processBlock(AudioBuffer<double>&), render() into a float buffer and convert
+
+ */
+
+namespace atec
+{
+    #define SAMPLERDEFAULTMAXVOICES 128
+    #define SAMPLERDEFAULTRELEASEMS 10.0
+    #define SAMPLERSTEALFADESAMPS 64
+
+    class SamplerEngine
+    {
+    public:
+        SamplerEngine();
+        ~SamplerEngine();
+
+        void debug(bool d);
+        void prepare(int maxVoices, double sampleRate);
+        int addSample(const juce::AudioBuffer<float>* sample, double sampleRate);
+        void clearSamples();
+        juce::uint32 startVoice(int sampleIndex, double transpo, float gain, float pan);
+        void stopVoice(juce::uint32 voiceId);
+        void stopAllVoices();
+        void setReleaseMs(double ms);
+        void render(juce::AudioBuffer<float>& outBuf, int startSample, int numSamples);
+        int getNumActiveVoices();
+        int getMaxVoices();
+        int getNumStolenVoices();
+
+    private:
+        int allocateSlot();
+        void releaseSlot(int slot, int fadeSamps);
+        void removeSlot(int slot);
+
+        struct SampleInfo
+        {
+            const juce::AudioBuffer<float>* buffer;
+            double sampleRate;
+        };
+
+        juce::Array<SampleInfo> mSamples;
+
+        // voice state, one entry per slot. slots [0, mNumActive) are the active voices
+        juce::HeapBlock<double> mReadPos;
+        juce::HeapBlock<double> mIncrement;
+        juce::HeapBlock<float> mEnv;
+        juce::HeapBlock<float> mEnvDelta;
+        juce::HeapBlock<float> mGainL;
+        juce::HeapBlock<float> mGainR;
+        juce::HeapBlock<const float*> mSampleData;
+        juce::HeapBlock<int> mLastIdx;
+        juce::HeapBlock<int> mReleasing;
+        juce::HeapBlock<juce::uint32> mVoiceIds;
+        juce::HeapBlock<juce::uint64> mStartOrder;
+
+        // per sample scratch, also one entry per slot
+        juce::HeapBlock<int> mReadIdx;
+        juce::HeapBlock<float> mMu;
+        juce::HeapBlock<float> mY0;
+        juce::HeapBlock<float> mY1;
+        juce::HeapBlock<float> mY2;
+        juce::HeapBlock<float> mY3;
+        juce::HeapBlock<float> mVoiceOut;
+
+        double mSampleRate;
+        double mReleaseMs;
+        juce::uint64 mStartCounter;
+        juce::uint32 mNextVoiceId;
+        int mMaxVoices;
+        int mNumSlots;
+        int mNumActive;
+        int mNumPlaying;
+        int mNumStolen;
+        bool mDebugFlag;
+    };
+} // namespace atec
@@ -0,0 +1,100 @@
+namespace atec
+{
+FastRandom::FastRandom()
+{
+    setSeed(FASTRANDOMDEFAULTSEED);
+}
+
+FastRandom::FastRandom(juce::uint64 seed)
+{
+    setSeed(seed);
+}
+
+FastRandom::~FastRandom()
+{
+}
+
+void FastRandom::setSeed(juce::uint64 seed)
+{
+    // splitmix64, two outputs per 64 bits of state
+    for(int i = 0; i < 4; i += 2)
+    {
+        juce::uint64 z;
+
+        seed += 0x9e3779b97f4a7c15ULL;
+        z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z = z ^ (z >> 31);
+
+        mState[i] = (juce::uint32)z;
+        mState[i + 1] = (juce::uint32)(z >> 32);
+    }
+
+    // xoshiro can't get out of an all zero state. splitmix64 practically never gives one, but make sure
+    if((mState[0] | mState[1] | mState[2] | mState[3]) == 0)
+        mState[0] = 1;
+}
+
+// for when reproducibility doesn't matter. not realtime safe on every platform, so call it from setup code
+void FastRandom::setSeedRandomly()
+{
+    setSeed((juce::uint64)juce::Time::getHighResolutionTicks() ^ ((juce::uint64)(juce::pointer_sized_uint)this << 16));
+}
+
+// xoshiro128**
+juce::uint32 FastRandom::nextUint32()
+{
+    juce::uint32 result = mState[1] * 5;
+    juce::uint32 t = mState[1] << 9;
+
+    result = ((result << 7) | (result >> 25)) * 9;
+
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= t;
+    mState[3] = (mState[3] << 11) | (mState[3] >> 21);
+
+    return result;
+}
+
+// uniform in [0, maxExclusive), without the modulo bias of rand() % n. Lemire's multiply-and-reject method
+int FastRandom::nextInt(int maxExclusive)
+{
+    juce::uint32 bound = (juce::uint32)maxExclusive;
+    juce::uint64 product;
+    juce::uint32 low;
+
+    jassert(maxExclusive > 0);
+
+    product = (juce::uint64)nextUint32() * bound;
+    low = (juce::uint32)product;
+
+    // only a tiny sliver of outputs ever need a retry
+    if(low < bound)
+    {
+        juce::uint32 threshold = (0u - bound) % bound;
+
+        while(low < threshold)
+        {
+            product = (juce::uint64)nextUint32() * bound;
+            low = (juce::uint32)product;
+        }
+    }
+
+    return (int)(product >> 32);
+}
+
+// uniform in [0, 1), from the top 24 bits
+float FastRandom::nextFloat()
+{
+    return (float)(nextUint32() >> 8) * (1.0f / 16777216.0f);
+}
+
+bool FastRandom::nextBool()
+{
+    return (nextUint32() >> 31) != 0;
+}
+} // namespace atec
@@ -0,0 +1,39 @@
+/*
+
+    A small, fast PRNG (xoshiro128**) with its own state, for per-voice/per-block randomness on the audio thread.
+
+    Unlike std::rand(), there's no hidden global state, no lock and nothing to reseed. Each instance is one independent stream, so give every voice (or thread) its own. The same seed always gives the same sequence, which keeps offline renders reproducible.
+
+    NOTE:
+    - not for anything security related
+    - seeds are spread over the 128 bit state with splitmix64, so nearby seeds (0, 1, 2...) still give unrelated streams
+
+ */
+
+#ifndef FAST_RANDOM_H
+#define FAST_RANDOM_H
+
+namespace atec
+{
+    #define FASTRANDOMDEFAULTSEED 0x9e3779b97f4a7c15ULL
+
+    class FastRandom
+    {
+    public:
+        FastRandom();
+        FastRandom(juce::uint64 seed);
+        ~FastRandom();
+
+        void setSeed(juce::uint64 seed);
+        void setSeedRandomly();
+        juce::uint32 nextUint32();
+        int nextInt(int maxExclusive);
+        float nextFloat();
+        bool nextBool();
+
+    private:
+        juce::uint32 mState[4];
+    };
+} // namespace atec
+
+#endif
@@ -0,0 +1,82 @@
+/*
+
+    Lock-free hand-off of a whole object (a gain curve, an analysis snapshot, etc) from one writer thread to one reader thread.
+
+    There are three copies of T. The writer fills its private copy and publish()es it, and the reader calls update() to swap the newest published copy in. Neither side ever waits or allocates, and the reader always sees a complete object, never one that's half written. If the writer publishes several times between updates, the reader just gets the newest one.
+
+    NOTE:
+    - exactly one writer thread and one reader thread
+    - allocate all three copies up front with getSlot() (e.g. in prepareToPlay()), before either side starts using it
+    - this is a template, so it's header only
+
+ */
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+namespace atec
+{
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer() : mMiddleIdx(2)
+        {
+            mWriteIdx = 0;
+            mReadIdx = 1;
+        }
+
+        // only for setting up all three copies while neither thread is using the buffer
+        T& getSlot(int index)
+        {
+            jassert(index >= 0 && index < 3);
+
+            return mSlots[index];
+        }
+
+        // writer thread: the copy to fill in before publish()
+        T& getWriteBuffer()
+        {
+            return mSlots[mWriteIdx];
+        }
+
+        // writer thread: hand the write buffer over to the reader, and take the spare copy back to write into next
+        void publish()
+        {
+            int oldMiddle = mMiddleIdx.exchange(mWriteIdx | TRIPLEBUFFERNEWDATA, std::memory_order_acq_rel);
+
+            mWriteIdx = oldMiddle & TRIPLEBUFFERINDEXMASK;
+        }
+
+        // reader thread: swap in the newest published copy, if there is one. returns true if anything changed
+        bool update()
+        {
+            if((mMiddleIdx.load(std::memory_order_acquire) & TRIPLEBUFFERNEWDATA) == 0)
+                return false;
+
+            int oldMiddle = mMiddleIdx.exchange(mReadIdx, std::memory_order_acq_rel);
+
+            mReadIdx = oldMiddle & TRIPLEBUFFERINDEXMASK;
+
+            return true;
+        }
+
+        // reader thread: the copy swapped in by the last update()
+        const T& getReadBuffer() const
+        {
+            return mSlots[mReadIdx];
+        }
+
+    private:
+        static constexpr int TRIPLEBUFFERINDEXMASK = 3;
+        static constexpr int TRIPLEBUFFERNEWDATA = 4;
+
+        T mSlots[3];
+        // the copy in the middle belongs to neither side. the new data bit says whether the reader has seen it yet
+        std::atomic<int> mMiddleIdx;
+        int mWriteIdx;
+        int mReadIdx;
+    };
+} // namespace atec
+
+#endif
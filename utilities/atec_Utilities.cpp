@@ -112,101 +112,119 @@ double Utilities::transpo2freqSampler(double transpo, long long int N, double sa
     return freq;
 }
 
-/*
- will produce an interpolated sample between y1 and y2, based on a mu value between 0.0 and 1.0
- */
-double Utilities::cubicInterpolate(double y0, double y1, double y2, double y3, double mu)
+// 2^x, split into 2^whole (straight into the exponent bits) times 2^frac (a polynomial), with frac in [-0.5, 0.5]
+float Utilities::fastExp2(float x)
 {
-    double a0, a1, a2, a3, mu2;
+    float whole, frac, result, scale;
+    juce::uint32 bits;
 
-    mu2 = mu*mu;
-    a0 = y3 - y2 - y0 + y1;
-    a1 = y0 - y1 - a0;
-    a2 = y2 - y0;
-    a3 = y1;
+    x = juce::jlimit(-126.0f, 127.0f, x);
 
-    return(a0*mu*mu2+a1*mu2+a2*mu+a3);
+    whole = std::floor(x + 0.5f);
+    frac = x - whole;
+
+    // Taylor series of e^(frac * ln(2)), to the 6th power
+    result = 1.0f + frac * (0.693147181f + frac * (0.240226507f + frac * (0.0555041087f + frac * (0.00961812911f + frac * (0.00133335581f + frac * 0.000154035304f)))));
+
+    bits = (juce::uint32)((int)whole + 127) << 23;
+    std::memcpy(&scale, &bits, sizeof(scale));
+
+    return result * scale;
 }
 
-double Utilities::bufReadInterp(int channel, double readIdx, juce::AudioBuffer<float>& buffer)
+void Utilities::freq2midi(const float* freqIn, float* midiOut, int numValues)
 {
-    int N, j, r0, r1, r2, r3;
-    double outSamp, mu;
-    auto* bufPtr = buffer.getReadPointer(channel);
+    // 12 * log2(f/440) + 69 = 12 * log2(f) - 36.376
+    for (int i = 0; i < numValues; i++)
+        midiOut[i] = 12.0f * fastLog2(freqIn[i]) - 36.3763165623f;
+}
+
+void Utilities::midi2freq(const float* midiIn, float* freqOut, int numValues)
+{
+    for (int i = 0; i < numValues; i++)
+        freqOut[i] = fastExp2((midiIn[i] - 69.0f) * (1.0f / 12.0f)) * 440.0f;
+}
 
-    // get the number of samples in the buffer
-    N = buffer.getNumSamples();
+// pow(v, 1/power) as exp2(log2(v) / power). an input at the bottom of the range maps to 0
+void Utilities::expToLinear(const float* valuesIn, float* valuesOut, int numValues, double power, juce::Range<double> range)
+{
+    float start = (float)range.getStart();
+    float lengthRecip = 1.0f / (float)range.getLength();
+    float powerRecip = 1.0f / (float)power;
 
-    // get the fractional part of the read position
-    mu = readIdx - floor(readIdx);
-    // get the integer part of the read position
-    j = floor(readIdx);
+    for (int i = 0; i < numValues; i++)
+    {
+        float normalized = (valuesIn[i] - start) * lengthRecip;
 
-    // set r0 through r3. if any j value is out of bounds, wrap to the beginning or end of the buffer to avoid reading out of bounds
-    r0 = ((j-1)>=0) ? j-1 : N + (j-1);
-    r1 = j;
-    r2 = (j+1) % N;
-    r3 = (j+2) % N;
+        valuesOut[i] = (normalized > 0.0f) ? fastExp2(fastLog2(juce::jmax(normalized, std::numeric_limits<float>::min())) * powerRecip) : 0.0f;
+    }
+}
 
-    // pull an interpolated sample
-    outSamp = cubicInterpolate(bufPtr[r0], bufPtr[r1], bufPtr[r2], bufPtr[r3], mu);
+void Utilities::linearToExp(const float* valuesIn, float* valuesOut, int numValues, double power, juce::Range<double> range)
+{
+    float start = (float)range.getStart();
+    float length = (float)range.getLength();
+    float fPower = (float)power;
 
-    return outSamp;
+    for (int i = 0; i < numValues; i++)
+    {
+        float value = valuesIn[i];
+        float shaped = (value > 0.0f) ? fastExp2(fastLog2(juce::jmax(value, std::numeric_limits<float>::min())) * fPower) : 0.0f;
+
+        valuesOut[i] = shaped * length + start;
+    }
 }
 
-// JUCE stores sample durations in a long long type
-double Utilities::bufReadInterp(int channel, double readIdx, const float* bufPtr, long long int N)
+void Utilities::transpo2freq(const float* transpoIn, float* freqOut, int numValues, double windowSizeMs)
 {
-    int j, r0, r1, r2, r3;
-    double outSamp, mu;
-    
-    // get the fractional part of the read position
-    mu = readIdx - floor(readIdx);
-    // get the integer part of the read position
-    j = floor(readIdx);
-    
-    // set r0 through r3. if any j value is out of bounds, wrap to the beginning or end of the buffer to avoid reading out of bounds
-    r0 = ((j-1)>=0) ? j-1 : N + (j-1);
-    r1 = j;
-    r2 = (j+1) % N;
-    r3 = (j+2) % N;
-
-    // pull an interpolated sample
-    outSamp = cubicInterpolate(bufPtr[r0], bufPtr[r1], bufPtr[r2], bufPtr[r3], mu);
-    
-    return outSamp;
+    float windowSizeRecip = 1000.0f / (float)windowSizeMs;
+
+    // e^(0.05776 * t) = 2^(0.05776 * log2(e) * t), same constant as the scalar version
+    for (int i = 0; i < numValues; i++)
+        freqOut[i] = (1.0f - fastExp2(transpoIn[i] * (0.05776f * 1.44269504f))) * windowSizeRecip;
 }
 
-// shuffle the contents of a juce::Array. Overload with <float> and <double> versions too
-// this is a very quick and dirty method! it just randomly swaps elements in the array once per iteration of the while loop.
-void Utilities::arrayShuffle(juce::Array<int>& array)
+void Utilities::transpo2freqSampler(const float* transpoIn, float* freqOut, int numValues, long long int N, double sampleRate)
 {
-    int numElements, numIter;
+    float scale = (float)(sampleRate / (double)N);
 
-    // use current time as seed for random generator
-    std::srand( (unsigned int)std::time(nullptr) );
+    for (int i = 0; i < numValues; i++)
+        freqOut[i] = fastExp2(transpoIn[i] * (1.0f / 12.0f)) * scale;
+}
 
-    numElements = array.size();
-    // let's do numElements * 10 swaps
-    numIter = numElements * 10;
+float Utilities::dotProduct(const float* a, const float* b, int numValues)
+{
+    float sums[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    int numWhole = numValues & ~7;
+    float tail = 0.0f;
 
-    while(numIter--)
-    {
-        int i, j;
+    for (int i = 0; i < numWhole; i += 8)
+        for (int j = 0; j < 8; j++)
+            sums[j] += a[i + j] * b[i + j];
 
-        i = std::rand() % (numElements - 1);
-        j = i + (std::rand() % (numElements - 1));
-        j = j % (numElements - 1);
+    for (int i = numWhole; i < numValues; i++)
+        tail += a[i] * b[i];
 
-        array.swap(i, j);
-    }
+    return (((sums[0] + sums[4]) + (sums[1] + sums[5])) + ((sums[2] + sums[6]) + (sums[3] + sums[7]))) + tail;
 }
 
+// shuffle the contents of a juce::Array<int> into a new, unpredictable order. each thread gets its own generator, seeded once, so there's no global state or locking.
+// use the FastRandom overloads when the order needs to be reproducible
+void Utilities::arrayShuffle(juce::Array<int>& array)
+{
+    thread_local FastRandom random((juce::uint64)std::time(nullptr) ^ (juce::uint64)std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    arrayShuffle(array.getRawDataPointer(), array.size(), random);
+}
+
+// for live input, ZeroCrossingDetector catches crossings between blocks and doesn't allocate
 int Utilities::getZeroCrossingPoints(int channel, juce::AudioBuffer<float>& buffer, juce::Array<int>& xIndices, double threshDb)
 {
     int crossings = 0;
     int bufSize = buffer.getNumSamples();
     auto* bufPtr = buffer.getReadPointer(channel);
+    // the threshold doesn't change inside the loop, so only convert it once
+    double threshGain = juce::Decibels::decibelsToGain(threshDb);
 
     for (int i = 1; i < bufSize; i++)
     {
@@ -214,7 +232,7 @@ int Utilities::getZeroCrossingPoints(int channel, juce::AudioBuffer<float>& buff
         {
             // TODO: a more strict criterion would be that the samples on BOTH sides of the crossing are BOTH below the dB thresh
             // check that the sample at the crossing is below our desired dB thresh
-            if (std::fabs(bufPtr[i-1]) < juce::Decibels::decibelsToGain(threshDb))
+            if (std::fabs(bufPtr[i-1]) < threshGain)
             {
                 // add the sample index preceding the crossing
                 xIndices.add(i-1);
@@ -283,6 +301,192 @@ void Utilities::getFftPhaseSpec(juce::dsp::Complex<float>* buffer, juce::Array<d
     }
 }
 
+void Utilities::getFftPowerSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+
+    for (int i = 0; i < numBins; i++)
+        outBuf[i] = binPtr[i*2] * binPtr[i*2] + binPtr[i*2 + 1] * binPtr[i*2 + 1];
+}
+
+void Utilities::getFftPowerSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+
+    for (int i = 0; i < numBins; i++)
+    {
+        double re = binPtr[i*2];
+        double im = binPtr[i*2 + 1];
+
+        outBuf[i] = re * re + im * im;
+    }
+}
+
+void Utilities::getFftMagSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+
+    for (int i = 0; i < numBins; i++)
+        outBuf[i] = std::sqrt(binPtr[i*2] * binPtr[i*2] + binPtr[i*2 + 1] * binPtr[i*2 + 1]);
+}
+
+void Utilities::getFftMagSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+
+    for (int i = 0; i < numBins; i++)
+    {
+        double re = binPtr[i*2];
+        double im = binPtr[i*2 + 1];
+
+        outBuf[i] = std::sqrt(re * re + im * im);
+    }
+}
+
+// 20 * log10(mag) is the same as 10 * log10(power), which saves the square root
+void Utilities::getFftLogMagSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N, float floorDb)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+    // fastLog2() only handles normal floats, so don't let the floor go any lower than that
+    float floorPower = juce::jmax(std::pow(10.0f, floorDb * 0.1f), std::numeric_limits<float>::min());
+
+    for (int i = 0; i < numBins; i++)
+    {
+        float power = binPtr[i*2] * binPtr[i*2] + binPtr[i*2 + 1] * binPtr[i*2 + 1];
+
+        // 10 * log10(2) = 3.0103
+        outBuf[i] = 3.01029996f * fastLog2(juce::jmax(power, floorPower));
+    }
+}
+
+void Utilities::getFftLogMagSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N, float floorDb)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+    float floorPower = juce::jmax(std::pow(10.0f, floorDb * 0.1f), std::numeric_limits<float>::min());
+
+    for (int i = 0; i < numBins; i++)
+    {
+        float power = binPtr[i*2] * binPtr[i*2] + binPtr[i*2 + 1] * binPtr[i*2 + 1];
+
+        outBuf[i] = 3.01029996f * fastLog2(juce::jmax(power, floorPower));
+    }
+}
+
+void Utilities::getFftPhaseSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+
+    for (int i = 0; i < numBins; i++)
+        outBuf[i] = fastAtan2(binPtr[i*2 + 1], binPtr[i*2]);
+}
+
+void Utilities::getFftPhaseSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N)
+{
+    const float* binPtr = reinterpret_cast<const float*>(inBuf);
+    int numBins = (N / 2) + 1;
+
+    for (int i = 0; i < numBins; i++)
+        outBuf[i] = fastAtan2(binPtr[i*2 + 1], binPtr[i*2]);
+}
+
+// polynomial atan2, max error about 2e-6 radians. no branches, so loops calling it can be vectorized.
+// atan2(0, 0) is 0, same as std::atan2()
+float Utilities::fastAtan2(float y, float x)
+{
+    float absX = std::fabs(x);
+    float absY = std::fabs(y);
+    float maxXY = juce::jmax(absX, absY);
+    float minXY = juce::jmin(absX, absY);
+    float a, a2, result;
+
+    // atan() of a ratio in [0, 1], then reflect it into the right octant
+    a = (maxXY > 0.0f) ? minXY / maxXY : 0.0f;
+    a2 = a * a;
+    result = a * (0.99997726f + a2 * (-0.33262347f + a2 * (0.19354346f + a2 * (-0.11643287f + a2 * (0.05265332f + a2 * -0.01172120f)))));
+
+    result = (absY > absX) ? juce::MathConstants<float>::halfPi - result : result;
+    result = (x < 0.0f) ? juce::MathConstants<float>::pi - result : result;
+    result = (y < 0.0f) ? -result : result;
+
+    return result;
+}
+
+// each phase is split into a multiple of pi/2 and a remainder in [-pi/4, pi/4]. sin and cos of the remainder are short polynomials,
+// and the quadrant swaps and negates them with arithmetic instead of branches
+void Utilities::polarToCartesian(const float* magIn, const float* phaseIn, juce::dsp::Complex<float>* outBuf, int N)
+{
+    float* binPtr = reinterpret_cast<float*>(outBuf);
+    int numBins = (N / 2) + 1;
+
+    for (int i = 0; i < numBins; i++)
+    {
+        float x = phaseIn[i] * 0.636619772f;
+        int quadrant = (int)(x + ((x >= 0.0f) ? 0.5f : -0.5f));
+        // pi/2 in two parts. the first has few enough bits that quadrant * part is exact, so large phases don't lose precision here
+        float r = (phaseIn[i] - (float)quadrant * 1.5703125f) - (float)quadrant * 4.83826794897e-4f;
+        float r2 = r * r;
+        float sinR = r * (1.0f + r2 * (-0.166666667f + r2 * (0.00833333333f + r2 * -0.000198412698f)));
+        float cosR = 1.0f + r2 * (-0.5f + r2 * (0.0416666667f + r2 * (-0.00138888889f + r2 * 0.0000248015873f)));
+        // odd quadrants swap sin and cos. quadrants 2 and 3 negate sin, 1 and 2 negate cos
+        float swap = (float)(quadrant & 1);
+        float sinSign = 1.0f - (float)(quadrant & 2);
+        float cosSign = 1.0f - (float)((quadrant + 1) & 2);
+
+        binPtr[i*2] = magIn[i] * cosSign * (cosR + swap * (sinR - cosR));
+        binPtr[i*2 + 1] = magIn[i] * sinSign * (sinR + swap * (cosR - sinR));
+    }
+}
+
+void Utilities::wrapPhase(const float* phaseIn, float* phaseOut, int numValues)
+{
+    for (int i = 0; i < numValues; i++)
+        phaseOut[i] = wrapPhase(phaseIn[i]);
+}
+
+// subtract the nearest whole number of cycles. rounding through an int keeps it branch-free. 2 * pi is split in two the same way as in polarToCartesian()
+float Utilities::wrapPhase(float phase)
+{
+    float cycles = phase * 0.159154943f;
+    int whole = (int)(cycles + ((cycles >= 0.0f) ? 0.5f : -0.5f));
+
+    return (phase - (float)whole * 6.28125f) - (float)whole * 1.93530717958e-3f;
+}
+
+// log2() of a positive, normal float. the error is about 1.5e-7 near x = 1 and grows with the size of the float result, to about 1.1e-6 by log2(x) = +/-32 (x from 2e-10 to 4e9).
+// that's still well under 1e-4 dB once it's scaled to decibels
+float Utilities::fastLog2(float x)
+{
+    juce::uint32 bits;
+    float mantissa, t, t2;
+    int exponent;
+    bool shift;
+
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    // split into exponent and a mantissa in [1, 2)
+    exponent = (int)((bits >> 23) & 0xff) - 127;
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+
+    // move the mantissa into [sqrt(0.5), sqrt(2)) so the series below converges quickly
+    shift = mantissa > 1.41421356f;
+    mantissa = shift ? mantissa * 0.5f : mantissa;
+    exponent += shift;
+
+    // log2(m) = (2 / ln(2)) * (t + t^3/3 + t^5/5 + t^7/7 ...), where t = (m - 1) / (m + 1)
+    t = (mantissa - 1.0f) / (mantissa + 1.0f);
+    t2 = t * t;
+
+    return (float)exponent + t * (2.88539008f + t2 * (0.961796694f + t2 * (0.577078016f + t2 * 0.412198583f)));
+}
+
 void Utilities::fftZeroPhase(juce::dsp::Complex<float>* buffer, int N)
 {
     for (int i = 0; i < N; i++)
@@ -293,23 +497,19 @@ void Utilities::fftZeroPhase(juce::dsp::Complex<float>* buffer, int N)
 }
 
 // incoming filter argument should be N/2+1 elements long. the function handles the mirror image/negative frequency multiplication aspect of the N-point Complex inBuf
-void Utilities::fftApplyFilter(juce::dsp::Complex<float>* inBuf, juce::Array<double> filter, int N)
+void Utilities::fftApplyFilter(juce::dsp::Complex<float>* inBuf, const juce::Array<double>& filter, int N)
 {
-    for (int i = 0; i < N; i++)
-    {
-        float newReal, newImag, thisScalar;
+    int halfN = N / 2;
 
-        // get the right magnitude scalar for the negative frequencies
-        if (i <= N * 0.5)
-            thisScalar = filter[i];
-        else
-            thisScalar = filter[N-i];
+    // getUnchecked() skips the per-element bounds check, so check the whole range once instead. a shorter filter would read past the end of the array
+    jassert(filter.size() > halfN);
 
-        newReal = inBuf[i].real() * thisScalar;
-        newImag = inBuf[i].imag() * thisScalar;
+    // non-negative frequencies
+    for (int i = 0; i <= halfN; i++)
+        inBuf[i] *= (float)filter.getUnchecked(i);
 
-        inBuf[i].real(newReal);
-        inBuf[i].imag(newImag);
-    }
+    // negative frequencies are the mirror image
+    for (int i = halfN + 1; i < N; i++)
+        inBuf[i] *= (float)filter.getUnchecked(N - i);
 }
 } // namespace atec
@@ -4,6 +4,8 @@
 
 */
 
+#include "atec_FastRandom.h"
+
 namespace atec
 {
     class Utilities
@@ -25,19 +27,193 @@ namespace atec
         static double transpo2freq(double transpo, double windowSizeMs);
         static double transpo2freqSampler(double transpo, long long int N, double sampleRate);
 
-        static double cubicInterpolate(double y0, double y1, double y2, double y3, double mu);
-        static double bufReadInterp(int channel, double readIdx, juce::AudioBuffer<float>& buffer);
-        static double bufReadInterp(int channel, double readIdx, const float* bufPtr, long long int N);
+        // fast approximations, both branch-free so loops over them vectorize.
+        // fastExp2() is within 3e-7 relative error for x in [-126, 127], which is under 0.001 cents as a pitch ratio.
+        // fastLog2() takes positive normal floats. it's within 1.5e-7 near x = 1, but the float result is only good to about 1.1e-6 at log2(x) = +/-32 and 4e-6 out at +/-120. that's under 0.005 cents, or 3e-5 dB as 20 * log10()
+        static float fastExp2(float x);
+        static float fastLog2(float x);
+
+        // block versions of the conversions above, built on fastExp2() and fastLog2() so they can be used per sample/per voice.
+        // in and out can be the same array
+        static void freq2midi(const float* freqIn, float* midiOut, int numValues);
+        static void midi2freq(const float* midiIn, float* freqOut, int numValues);
+        static void expToLinear(const float* valuesIn, float* valuesOut, int numValues, double power, juce::Range<double> range);
+        static void linearToExp(const float* valuesIn, float* valuesOut, int numValues, double power, juce::Range<double> range);
+        static void transpo2freq(const float* transpoIn, float* freqOut, int numValues, double windowSizeMs);
+        static void transpo2freqSampler(const float* transpoIn, float* freqOut, int numValues, long long int N, double sampleRate);
+
+        // sum of a[i] * b[i], in 8 separate partial sums so the compiler can keep them in SIMD registers without fast-math. fastest when numValues is a multiple of 8, since the rest is a scalar tail
+        static float dotProduct(const float* a, const float* b, int numValues);
+
+        // constexpr versions for building tables at compile time, e.g. a static constexpr array of MIDI note frequencies.
+        // they're series expansions, accurate to about 1e-12, but too slow to use at run time
+        static constexpr double constExp2(double x)
+        {
+            double result = 1.0;
+            double term = 1.0;
+            int whole = (int)x;
+
+            // floor, so the fractional part is always in [0, 1)
+            if(x < (double)whole)
+                whole--;
+
+            const double frac = (x - (double)whole) * 0.69314718055994531;
+
+            // e^frac as a Taylor series
+            for(int i = 1; i < 25; i++)
+            {
+                term *= frac / (double)i;
+                result += term;
+            }
+
+            for(int i = 0; i < whole; i++)
+                result *= 2.0;
+
+            for(int i = 0; i > whole; i--)
+                result *= 0.5;
+
+            return result;
+        }
+
+        static constexpr double constLog2(double x)
+        {
+            double exponent = 0.0;
+
+            // no jassert here, since it isn't usable in a constexpr function
+            if(x <= 0.0)
+                return -std::numeric_limits<double>::infinity();
+
+            // scale into [sqrt(0.5), sqrt(2))
+            while(x >= 1.4142135623730951)
+            {
+                x *= 0.5;
+                exponent += 1.0;
+            }
+
+            while(x < 0.70710678118654752)
+            {
+                x *= 2.0;
+                exponent -= 1.0;
+            }
+
+            // ln(x) = 2 * (t + t^3/3 + t^5/5 ...), where t = (x - 1) / (x + 1)
+            const double t = (x - 1.0) / (x + 1.0);
+            const double t2 = t * t;
+            double term = t;
+            double sum = 0.0;
+
+            for(int i = 1; i < 40; i += 2)
+            {
+                sum += term / (double)i;
+                term *= t2;
+            }
+
+            return exponent + (2.0 * sum * 1.4426950408889634);
+        }
+
+        static constexpr double constMidi2freq(double m)
+        {
+            return constExp2((m - 69.0) / 12.0) * 440.0;
+        }
+
+        static constexpr double constFreq2midi(double f)
+        {
+            return 12.0 * constLog2(f / 440.0) + 69.0;
+        }
+
+        // will produce an interpolated sample between y1 and y2, based on a mu value between 0.0 and 1.0.
+        // templated on the sample type so a float signal path stays float, without converting to double and back every sample.
+        // mu gets its own type, so float samples with a double mu still compile. it's converted to SampleType once
+        template <typename SampleType, typename MuType>
+        static SampleType cubicInterpolate(SampleType y0, SampleType y1, SampleType y2, SampleType y3, MuType muIn)
+        {
+            SampleType a0, a1, a2, a3, mu, mu2;
+
+            mu = (SampleType)muIn;
+            mu2 = mu*mu;
+            a0 = y3 - y2 - y0 + y1;
+            a1 = y0 - y1 - a0;
+            a2 = y2 - y0;
+            a3 = y1;
+
+            return(a0*mu*mu2+a1*mu2+a2*mu+a3);
+        }
+
+        template <typename SampleType>
+        static SampleType bufReadInterp(int channel, double readIdx, const juce::AudioBuffer<SampleType>& buffer)
+        {
+            return bufReadInterp(channel, readIdx, buffer.getReadPointer(channel), buffer.getNumSamples());
+        }
+
+        // readIdx stays double, since float can't address individual samples far into a long buffer. only the fraction is converted, and the interpolation is done in SampleType.
+        // JUCE stores sample durations in a long long type
+        template <typename SampleType>
+        static SampleType bufReadInterp(int channel, double readIdx, const SampleType* bufPtr, long long int N)
+        {
+            int j, r0, r1, r2, r3;
+            SampleType mu;
+
+            // get the integer part of the read position
+            j = (int)std::floor(readIdx);
+            // get the fractional part of the read position
+            mu = (SampleType)(readIdx - j);
+
+            // set r0 through r3. if any j value is out of bounds, wrap to the beginning or end of the buffer to avoid reading out of bounds
+            r0 = ((j-1)>=0) ? j-1 : (int)N + (j-1);
+            r1 = j;
+            r2 = (j+1) % N;
+            r3 = (j+2) % N;
+
+            // pull an interpolated sample
+            return cubicInterpolate(bufPtr[r0], bufPtr[r1], bufPtr[r2], bufPtr[r3], mu);
+        }
 
         static void arrayShuffle(juce::Array<int>& seq);
+
+        // Fisher-Yates shuffle of any contiguous range, driven by the caller's FastRandom. O(n), no allocation or locking, and the same seed always gives the same order
+        template <typename ElementType>
+        static void arrayShuffle(ElementType* elements, int numElements, FastRandom& random)
+        {
+            for(int i = numElements - 1; i > 0; i--)
+                std::swap(elements[i], elements[random.nextInt(i + 1)]);
+        }
+
+        template <typename ElementType>
+        static void arrayShuffle(juce::Array<ElementType>& array, FastRandom& random)
+        {
+            arrayShuffle(array.getRawDataPointer(), array.size(), random);
+        }
         
         static int getZeroCrossingPoints(int channel, juce::AudioBuffer<float>& buffer, juce::Array<int>& xIndices, double threshDb);
         static double getZeroCrossingRate(int channel, juce::AudioBuffer<float>& buffer);
         static void getFftPowerSpec(juce::dsp::Complex<float>* inBuf, juce::Array<double>& outBuf, int N);
         static void getFftMagSpec(juce::dsp::Complex<float>* inBuf, juce::Array<double>& outBuf, int N);
         static void getFftPhaseSpec(juce::dsp::Complex<float>* buffer, juce::Array<double>& outBuf, int N);
+
+        // half spectrum versions of the above. N is the FFT size, and outBuf must hold N/2+1 values.
+        // these are plain branch-free loops over the interleaved bins, so the compiler can vectorize them
+        static void getFftPowerSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N);
+        static void getFftPowerSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N);
+        static void getFftMagSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N);
+        static void getFftMagSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N);
+        // magnitude in dB, clamped to floorDb. within 1e-4 dB of 20 * log10(mag)
+        static void getFftLogMagSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N, float floorDb = -120.0f);
+        static void getFftLogMagSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N, float floorDb = -120.0f);
+        // phase in radians, [-pi, pi]. within 2e-6 radians of std::atan2()
+        static void getFftPhaseSpec(const juce::dsp::Complex<float>* inBuf, float* outBuf, int N);
+        static void getFftPhaseSpec(const juce::dsp::Complex<float>* inBuf, double* outBuf, int N);
+        static float fastAtan2(float y, float x);
+
+        // the way back from getFftMagSpec()/getFftPhaseSpec(): N/2+1 bins of magnitude and phase into interleaved complex bins, ready for performRealOnlyInverseTransform().
+        // sin/cos are polynomials, within about 1e-6 of std::polar() for phases within +/-1e5 radians, and branch-free
+        static void polarToCartesian(const float* magIn, const float* phaseIn, juce::dsp::Complex<float>* outBuf, int N);
+        // wrap phases within +/-1e5 radians into [-pi, pi], e.g. for phase vocoder deviations. in and out can be the same array
+        static void wrapPhase(const float* phaseIn, float* phaseOut, int numValues);
+        static float wrapPhase(float phase);
+
         static void fftZeroPhase(juce::dsp::Complex<float>* buffer, int N);
-        static void fftApplyFilter(juce::dsp::Complex<float>* inBuf, juce::Array<double> filter, int N);
+        // for per-frame filtering, SpectralFilter is faster: the curve is converted once and applied without branching or conversion
+        static void fftApplyFilter(juce::dsp::Complex<float>* inBuf, const juce::Array<double>& filter, int N);
 
     private:
 